@@ -36,11 +36,11 @@
 #include "libavutil/parseutils.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/colorspace.h"
-#include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/dict.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/probe.h"
 #include "libavutil/avstring.h"
 #include "libavutil/libm.h"
 #include "libavutil/imgutils.h"
@@ -149,6 +149,7 @@ static void exit_program(void)
     int i, j;
 
     for (i = 0; i < nb_filtergraphs; i++) {
+        dump_filtergraph_stats(filtergraphs[i]);
         avfilter_graph_free(&filtergraphs[i]->graph);
         for (j = 0; j < filtergraphs[i]->nb_inputs; j++) {
             av_freep(&filtergraphs[i]->inputs[j]->name);
@@ -203,6 +204,7 @@ static void exit_program(void)
     if (vstats_file)
         fclose(vstats_file);
     av_free(vstats_filename);
+    av_free(trace_filename);
 
     av_freep(&input_streams);
     av_freep(&input_files);
@@ -212,6 +214,7 @@ static void exit_program(void)
     uninit_opts();
 
     avfilter_uninit();
+    av_packet_pool_uninit();
     avformat_network_deinit();
 
     if (received_sigterm) {
@@ -307,6 +310,7 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, OutputStream *ost)
 {
     AVBitStreamFilterContext *bsfc = ost->bitstream_filters;
     AVCodecContext          *avctx = ost->st->codec;
+    int64_t start, pts;
     int ret;
 
     /*
@@ -350,7 +354,10 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, OutputStream *ost)
     }
 
     pkt->stream_index = ost->index;
+    pts   = pkt->pts;
+    start = trace_begin();
     ret = av_interleaved_write_frame(s, pkt);
+    trace_end(main_trace, "write_frame", start, 1, ost->file_index, ost->index, pts);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
         exit(1);
@@ -376,6 +383,7 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
     AVCodecContext *enc = ost->st->codec;
     AVPacket pkt;
     int got_packet = 0;
+    int64_t start;
 
     av_init_packet(&pkt);
     pkt.data = NULL;
@@ -388,10 +396,13 @@ static void do_audio_out(AVFormatContext *s, OutputStream *ost,
         frame->pts = ost->sync_opts;
     ost->sync_opts = frame->pts + frame->nb_samples;
 
+    start = trace_begin();
     if (avcodec_encode_audio2(enc, &pkt, frame, &got_packet) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Audio encoding failed\n");
         exit(1);
     }
+    trace_end(main_trace, "encode_audio", start, 1, ost->file_index, ost->index,
+              frame->pts);
 
     if (got_packet) {
         if (pkt.pts != AV_NOPTS_VALUE)
@@ -522,6 +533,7 @@ static void do_video_out(AVFormatContext *s,
     int ret, format_video_sync;
     AVPacket pkt;
     AVCodecContext *enc = ost->st->codec;
+    int64_t start;
 
     *frame_size = 0;
 
@@ -582,11 +594,14 @@ static void do_video_out(AVFormatContext *s,
             in_picture->pict_type = AV_PICTURE_TYPE_I;
             ost->forced_kf_index++;
         }
+        start = trace_begin();
         ret = avcodec_encode_video2(enc, &pkt, in_picture, &got_packet);
         if (ret < 0) {
             av_log(NULL, AV_LOG_FATAL, "Video encoding failed\n");
             exit(1);
         }
+        trace_end(main_trace, "encode_video", start, 1, ost->file_index,
+                  ost->index, in_picture->pts);
 
         if (got_packet) {
             if (pkt.pts != AV_NOPTS_VALUE)
@@ -938,15 +953,19 @@ static void flush_encoders(void)
             if (encode) {
                 AVPacket pkt;
                 int got_packet;
+                int64_t start;
                 av_init_packet(&pkt);
                 pkt.data = NULL;
                 pkt.size = 0;
 
+                start = trace_begin();
                 ret = encode(enc, &pkt, NULL, &got_packet);
                 if (ret < 0) {
                     av_log(NULL, AV_LOG_FATAL, "%s encoding failed\n", desc);
                     exit(1);
                 }
+                trace_end(main_trace, "flush_encoder", start, 1, ost->file_index,
+                          ost->index, AV_NOPTS_VALUE);
                 *size += ret;
                 if (ost->logfile && enc->stats_out) {
                     fprintf(ost->logfile, "%s", enc->stats_out);
@@ -1142,7 +1161,7 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
 
         for (i = 0; i < nb_filtergraphs; i++)
             if (ist_in_filtergraph(filtergraphs[i], ist) &&
-                configure_filtergraph(filtergraphs[i]) < 0) {
+                reconfigure_filtergraph(filtergraphs[i], ist, decoded_frame) < 0) {
                 av_log(NULL, AV_LOG_FATAL, "Error reinitializing filters!\n");
                 exit(1);
             }
@@ -1171,6 +1190,34 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output)
     return err < 0 ? err : ret;
 }
 
+/**
+ * Skip decoding the non-reference frames that the filters would drop anyway.
+ */
+static void update_skip_frame(InputStream *ist, const AVPacket *pkt)
+{
+    AVCodecContext *dec = ist->st->codec;
+    int64_t min_pts = AV_NOPTS_VALUE;
+    int i;
+
+    dec->skip_frame = ist->skip_frame;
+
+    /* the frame timestamps must be those of the packets for the comparison
+     * to be meaningful */
+    if (!ist->nb_filters || ist->framerate.num || pkt->pts == AV_NOPTS_VALUE ||
+        ist->pts_ctx.num_faulty_pts > ist->pts_ctx.num_faulty_dts)
+        return;
+
+    for (i = 0; i < ist->nb_filters; i++) {
+        int64_t pts = av_buffersrc_get_min_pts(ist->filters[i]->filter);
+        if (pts == AV_NOPTS_VALUE)
+            return;
+        min_pts = i ? FFMIN(min_pts, pts) : pts;
+    }
+
+    if (pkt->pts < min_pts)
+        dec->skip_frame = FFMAX(ist->skip_frame, AVDISCARD_NONREF);
+}
+
 static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
 {
     AVFrame *decoded_frame, *f;
@@ -1183,6 +1230,8 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
         return AVERROR(ENOMEM);
     decoded_frame = ist->decoded_frame;
 
+    update_skip_frame(ist, pkt);
+
     ret = avcodec_decode_video2(ist->st->codec,
                                 decoded_frame, got_output, pkt);
     if (!*got_output || ret < 0) {
@@ -1225,7 +1274,7 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
 
         for (i = 0; i < nb_filtergraphs; i++)
             if (ist_in_filtergraph(filtergraphs[i], ist) &&
-                configure_filtergraph(filtergraphs[i]) < 0) {
+                reconfigure_filtergraph(filtergraphs[i], ist, decoded_frame) < 0) {
                 av_log(NULL, AV_LOG_FATAL, "Error reinitializing filters!\n");
                 exit(1);
             }
@@ -1282,6 +1331,7 @@ static int output_packet(InputStream *ist, const AVPacket *pkt)
     int i;
     int got_output;
     AVPacket avpkt;
+    int64_t start;
 
     if (ist->next_dts == AV_NOPTS_VALUE)
         ist->next_dts = ist->last_dts;
@@ -1312,12 +1362,17 @@ static int output_packet(InputStream *ist, const AVPacket *pkt)
             ist->showed_multi_packet_warning = 1;
         }
 
+        start = trace_begin();
         switch (ist->st->codec->codec_type) {
         case AVMEDIA_TYPE_AUDIO:
             ret = decode_audio    (ist, &avpkt, &got_output);
+            trace_end(main_trace, "decode_audio", start, 0, ist->file_index,
+                      ist->st->index, avpkt.pts);
             break;
         case AVMEDIA_TYPE_VIDEO:
             ret = decode_video    (ist, &avpkt, &got_output);
+            trace_end(main_trace, "decode_video", start, 0, ist->file_index,
+                      ist->st->index, avpkt.pts);
             if (avpkt.duration)
                 ist->next_dts += av_rescale_q(avpkt.duration, ist->st->time_base, AV_TIME_BASE_Q);
             else if (ist->st->avg_frame_rate.num)
@@ -1430,6 +1485,7 @@ static int init_input_stream(int ist_index, char *error, int error_len)
             return ret;
         }
         assert_avoptions(ist->opts);
+        ist->skip_frame = ist->st->codec->skip_frame;
     }
 
     ist->last_dts = ist->st->avg_frame_rate.num ? - ist->st->codec->has_b_frames * AV_TIME_BASE / av_q2d(ist->st->avg_frame_rate) : 0;
@@ -1949,11 +2005,18 @@ static InputFile *select_input_file(void)
 static void *input_thread(void *arg)
 {
     InputFile *f = arg;
-    int ret = 0;
+    int ret = 0, file_index = 0;
+
+    while (input_files[file_index] != f)
+        file_index++;
 
     while (!transcoding_finished && ret >= 0) {
         AVPacket pkt;
+        int64_t start = trace_begin();
         ret = av_read_frame(f->ctx, &pkt);
+        if (ret >= 0)
+            trace_end(f->trace, "read_frame", start, 0, file_index,
+                      pkt.stream_index, pkt.pts);
 
         if (ret == AVERROR(EAGAIN)) {
             av_usleep(10000);
@@ -1962,17 +2025,12 @@ static void *input_thread(void *arg)
         } else if (ret < 0)
             break;
 
-        pthread_mutex_lock(&f->fifo_lock);
-        while (!av_fifo_space(f->fifo))
-            pthread_cond_wait(&f->fifo_cond, &f->fifo_lock);
-
         av_dup_packet(&pkt);
-        av_fifo_generic_write(f->fifo, &pkt, sizeof(pkt), NULL);
-
-        pthread_mutex_unlock(&f->fifo_lock);
+        if ((ret = av_ring_write(f->ring, &pkt, 0)) < 0)
+            av_free_packet(&pkt);
     }
 
-    f->finished = 1;
+    av_ring_set_err_read(f->ring, AVERROR_EOF);
     return NULL;
 }
 
@@ -1989,25 +2047,17 @@ static void free_input_threads(void)
         InputFile *f = input_files[i];
         AVPacket pkt;
 
-        if (!f->fifo || f->joined)
+        if (!f->ring || f->joined)
             continue;
 
-        pthread_mutex_lock(&f->fifo_lock);
-        while (av_fifo_size(f->fifo)) {
-            av_fifo_generic_read(f->fifo, &pkt, sizeof(pkt), NULL);
-            av_free_packet(&pkt);
-        }
-        pthread_cond_signal(&f->fifo_cond);
-        pthread_mutex_unlock(&f->fifo_lock);
-
+        /* wake up the thread if it is waiting for space in the ring */
+        av_ring_set_err_write(f->ring, AVERROR_EOF);
         pthread_join(f->thread, NULL);
         f->joined = 1;
 
-        while (av_fifo_size(f->fifo)) {
-            av_fifo_generic_read(f->fifo, &pkt, sizeof(pkt), NULL);
+        while (!av_ring_read(f->ring, &pkt, AV_RING_NONBLOCK))
             av_free_packet(&pkt);
-        }
-        av_fifo_free(f->fifo);
+        av_ring_free(&f->ring);
     }
 }
 
@@ -2021,11 +2071,15 @@ static int init_input_threads(void)
     for (i = 0; i < nb_input_files; i++) {
         InputFile *f = input_files[i];
 
-        if (!(f->fifo = av_fifo_alloc(8*sizeof(AVPacket))))
+        if (!(f->ring = av_ring_alloc(8, sizeof(AVPacket), 0)))
             return AVERROR(ENOMEM);
 
-        pthread_mutex_init(&f->fifo_lock, NULL);
-        pthread_cond_init (&f->fifo_cond, NULL);
+        if (trace_filename) {
+            char name[32];
+            snprintf(name, sizeof(name), "input #%d", i);
+            if (!(f->trace = trace_buffer_alloc(name)))
+                return AVERROR(ENOMEM);
+        }
 
         if ((ret = pthread_create(&f->thread, NULL, input_thread, f)))
             return AVERROR(ret);
@@ -2035,33 +2089,25 @@ static int init_input_threads(void)
 
 static int get_input_packet_mt(InputFile *f, AVPacket *pkt)
 {
-    int ret = 0;
-
-    pthread_mutex_lock(&f->fifo_lock);
-
-    if (av_fifo_size(f->fifo)) {
-        av_fifo_generic_read(f->fifo, pkt, sizeof(*pkt), NULL);
-        pthread_cond_signal(&f->fifo_cond);
-    } else {
-        if (f->finished)
-            ret = AVERROR_EOF;
-        else
-            ret = AVERROR(EAGAIN);
-    }
-
-    pthread_mutex_unlock(&f->fifo_lock);
-
-    return ret;
+    return av_ring_read(f->ring, pkt, AV_RING_NONBLOCK);
 }
 #endif
 
 static int get_input_packet(InputFile *f, AVPacket *pkt)
 {
+    int64_t start;
+    int ret;
+
 #if HAVE_PTHREADS
     if (nb_input_files > 1)
         return get_input_packet_mt(f, pkt);
 #endif
-    return av_read_frame(f->ctx, pkt);
+    start = trace_begin();
+    ret   = av_read_frame(f->ctx, pkt);
+    if (ret >= 0)
+        trace_end(main_trace, "read_frame", start, 0, 0, pkt->stream_index,
+                  pkt->pts);
+    return ret;
 }
 
 static int got_eagain(void)
@@ -2210,7 +2256,12 @@ static int transcode(void)
     AVFormatContext *os;
     OutputStream *ost;
     InputStream *ist;
-    int64_t timer_start;
+    int64_t timer_start, start;
+
+    if (trace_filename && !(main_trace = trace_buffer_alloc("main"))) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
 
     ret = transcode_init();
     if (ret < 0)
@@ -2235,12 +2286,16 @@ static int transcode(void)
 
         /* read and process one input packet if needed */
         if (need_input) {
+            start = trace_begin();
             ret = process_input();
+            trace_end(main_trace, "process_input", start, 0, -1, -1, AV_NOPTS_VALUE);
             if (ret == AVERROR_EOF)
                 need_input = 0;
         }
 
+        start = trace_begin();
         ret = poll_filters();
+        trace_end(main_trace, "poll_filters", start, 0, -1, -1, AV_NOPTS_VALUE);
         if (ret < 0) {
             if (ret == AVERROR_EOF || ret == AVERROR(EAGAIN))
                 continue;
@@ -2368,6 +2423,10 @@ int main(int argc, char **argv)
     av_log_set_flags(AV_LOG_SKIP_REPEATED);
     parse_loglevel(argc, argv, options);
 
+    /* account the memory from the start, -benchmark is only parsed later */
+    if (locate_option(argc, argv, options, "benchmark"))
+        av_mem_stats_enable(1);
+
     avcodec_register_all();
 #if CONFIG_AVDEVICE
     avdevice_register_all();
@@ -2399,9 +2458,18 @@ int main(int argc, char **argv)
     if (transcode() < 0)
         exit(1);
     ti = getutime() - ti;
+    trace_write();
     if (do_benchmark) {
-        int maxrss = getmaxrss() / 1024;
+        int maxrss   = getmaxrss() / 1024;
+        char *probes = av_probe_dump(AV_PROBE_DUMP_TEXT);
+        char *mem    = av_mem_dump_stats();
         printf("bench: utime=%0.3fs maxrss=%ikB\n", ti / 1000000.0, maxrss);
+        if (probes)
+            printf("%s", probes);
+        if (mem)
+            printf("%s", mem);
+        av_free(probes);
+        av_free(mem);
     }
 
     exit(0);
@@ -40,9 +40,9 @@
 
 #include "libavutil/avutil.h"
 #include "libavutil/dict.h"
-#include "libavutil/fifo.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/rational.h"
+#include "libavutil/ring.h"
 
 #define VSYNC_AUTO       -1
 #define VSYNC_PASSTHROUGH 0
@@ -214,6 +214,7 @@ typedef struct InputStream {
     int showed_multi_packet_warning;
     AVDictionary *opts;
     AVRational framerate;               /* framerate forced with -r */
+    enum AVDiscard skip_frame;          /* skip_frame value set by the user */
 
     int resample_height;
     int resample_width;
@@ -230,6 +231,25 @@ typedef struct InputStream {
     int        nb_filters;
 } InputStream;
 
+typedef struct TraceEvent {
+    const char *name;
+    int64_t start;        /* wallclock time in microseconds */
+    int64_t duration;
+    int output;           /* file_index and stream_index refer to an output */
+    int file_index;       /* -1 if the event is not related to a stream */
+    int stream_index;
+    int64_t pts;
+} TraceEvent;
+
+/* the events recorded by one thread */
+typedef struct TraceBuffer {
+    TraceEvent *events;
+    unsigned nb_events;
+    int tid;
+    char *thread_name;
+    struct TraceBuffer *next;
+} TraceBuffer;
+
 typedef struct InputFile {
     AVFormatContext *ctx;
     int eof_reached;      /* true if eof reached */
@@ -242,11 +262,9 @@ typedef struct InputFile {
 
 #if HAVE_PTHREADS
     pthread_t thread;           /* thread reading from this file */
-    int finished;               /* the thread has exited */
     int joined;                 /* the thread has been joined */
-    pthread_mutex_t fifo_lock;  /* lock for access to fifo */
-    pthread_cond_t  fifo_cond;  /* the main thread will signal on this cond after reading from fifo */
-    AVFifoBuffer *fifo;         /* demuxed packets are stored here; freed by the main thread */
+    AVRing *ring;               /* demuxed packets are stored here; freed by the main thread */
+    TraceBuffer *trace;         /* events of the thread */
 #endif
 } InputFile;
 
@@ -325,6 +343,9 @@ extern FilterGraph **filtergraphs;
 extern int        nb_filtergraphs;
 
 extern char *vstats_filename;
+extern char *trace_filename;
+
+extern TraceBuffer *main_trace;
 
 extern float audio_drift_threshold;
 extern float dts_delta_threshold;
@@ -333,6 +354,7 @@ extern int audio_volume;
 extern int audio_sync_method;
 extern int video_sync_method;
 extern int do_benchmark;
+extern int do_filter_stats;
 extern int do_deinterlace;
 extern int do_hex_dump;
 extern int do_pkt_dump;
@@ -358,10 +380,18 @@ void assert_avoptions(AVDictionary *m);
 int guess_input_channel_layout(InputStream *ist);
 
 int configure_filtergraph(FilterGraph *fg);
+int reconfigure_filtergraph(FilterGraph *fg, InputStream *ist, AVFrame *frame);
 int configure_output_filter(FilterGraph *fg, OutputFilter *ofilter, AVFilterInOut *out);
 int ist_in_filtergraph(FilterGraph *fg, InputStream *ist);
+void dump_filtergraph_stats(FilterGraph *fg);
 FilterGraph *init_simple_filtergraph(InputStream *ist, OutputStream *ost);
 
 int avconv_parse_options(int argc, char **argv);
 
+TraceBuffer *trace_buffer_alloc(const char *thread_name);
+int64_t trace_begin(void);
+void trace_end(TraceBuffer *tb, const char *name, int64_t start,
+               int output, int file_index, int stream_index, int64_t pts);
+void trace_write(void);
+
 #endif /* AVCONV_H */
@@ -22,6 +22,7 @@
 
 #include "libavfilter/avfilter.h"
 #include "libavfilter/avfiltergraph.h"
+#include "libavfilter/buffersrc.h"
 
 #include "libavresample/avresample.h"
 
@@ -32,6 +33,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
 
 /* Define a function for building a string containing a list of
  * allowed formats. */
@@ -499,9 +501,11 @@ int configure_filtergraph(FilterGraph *fg)
     const char *graph_desc = simple ? fg->outputs[0]->ost->avfilter :
                                       fg->graph_desc;
 
+    dump_filtergraph_stats(fg);
     avfilter_graph_free(&fg->graph);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    fg->graph->profile = do_filter_stats;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
@@ -563,6 +567,71 @@ int configure_filtergraph(FilterGraph *fg)
     return 0;
 }
 
+/* check that the frames sent to the encoders keep the parameters the encoders
+ * were opened with */
+static int outputs_match_encoders(FilterGraph *fg)
+{
+    int i;
+
+    for (i = 0; i < fg->nb_outputs; i++) {
+        OutputStream    *ost = fg->outputs[i]->ost;
+        AVFilterLink   *link = fg->outputs[i]->filter->inputs[0];
+        AVCodecContext *enc  = ost->st->codec;
+
+        if (!ost->encoding_needed)
+            continue;
+
+        switch (link->type) {
+        case AVMEDIA_TYPE_VIDEO:
+            if (link->w != enc->width || link->h != enc->height ||
+                link->format != enc->pix_fmt)
+                return 0;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            if (link->format         != enc->sample_fmt  ||
+                link->sample_rate    != enc->sample_rate ||
+                link->channel_layout != enc->channel_layout)
+                return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+int reconfigure_filtergraph(FilterGraph *fg, InputStream *ist, AVFrame *frame)
+{
+    AVRational tb = { 0, 0 };
+    int64_t start = av_gettime();
+    int i, ret = 0, incremental = 1;
+
+    /* the audio timestamps are in 1/sample_rate of the decoder */
+    if (ist->st->codec->codec_type == AVMEDIA_TYPE_AUDIO)
+        tb = (AVRational){ 1, ist->st->codec->sample_rate };
+
+    /* only the filters affected by the new frame properties are configured
+     * again, unless some of them do not support it */
+    for (i = 0; i < fg->nb_inputs && ret >= 0; i++)
+        if (fg->inputs[i]->ist == ist)
+            ret = av_buffersrc_reconfig(fg->inputs[i]->filter, frame, tb);
+
+    /* the encoders are already open, so the graph is configured again with
+     * their parameters enforced if the new output differs from them */
+    if (ret >= 0 && !outputs_match_encoders(fg))
+        ret = AVERROR(EINVAL);
+
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_VERBOSE, "Cannot reconfigure filtergraph %d "
+               "incrementally, configuring it again.\n", fg->index);
+        incremental = 0;
+        if ((ret = configure_filtergraph(fg)) < 0)
+            return ret;
+    }
+
+    av_log(NULL, AV_LOG_INFO, "Filtergraph %d reconfigured%s in %"PRId64" us.\n",
+           fg->index, incremental ? " incrementally" : "", av_gettime() - start);
+    return 0;
+}
+
 int ist_in_filtergraph(FilterGraph *fg, InputStream *ist)
 {
     int i;
@@ -572,3 +641,28 @@ int ist_in_filtergraph(FilterGraph *fg, InputStream *ist)
     return 0;
 }
 
+
+void dump_filtergraph_stats(FilterGraph *fg)
+{
+    int i;
+
+    if (!do_filter_stats || !fg->graph)
+        return;
+
+    av_log(NULL, AV_LOG_INFO, "Filter graph %d statistics:\n", fg->index);
+    for (i = 0; i < fg->graph->filter_count; i++) {
+        AVFilterContext *filter = fg->graph->filters[i];
+        AVFilterStats stats;
+
+        if (avfilter_get_stats(filter, &stats) < 0)
+            continue;
+        av_log(NULL, AV_LOG_INFO, "  %s: %"PRId64" frames in, %"PRId64" out, "
+               "filter_frame %"PRId64"us (max %"PRId64"us), "
+               "request_frame %"PRId64"us (max %"PRId64"us), "
+               "%"PRId64" bytes allocated, up to %d frames queued\n",
+               filter->name, stats.frames_in, stats.frames_out,
+               stats.filter_frame_time, stats.filter_frame_max,
+               stats.request_frame_time, stats.request_frame_max,
+               stats.bytes_allocated, stats.max_queued);
+    }
+}
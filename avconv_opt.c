@@ -32,6 +32,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/autotune.h"
 #include "libavutil/avutil.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/intreadwrite.h"
@@ -55,6 +56,7 @@
 }
 
 char *vstats_filename;
+char *trace_filename;
 
 float audio_drift_threshold = 0.1;
 float dts_delta_threshold   = 10;
@@ -64,6 +66,7 @@ int audio_sync_method = 0;
 int video_sync_method = VSYNC_AUTO;
 int do_deinterlace    = 0;
 int do_benchmark      = 0;
+int do_filter_stats   = 0;
 int do_hex_dump       = 0;
 int do_pkt_dump       = 0;
 int copy_ts           = 0;
@@ -1830,6 +1833,26 @@ int opt_cpuflags(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_autotune(void *optctx, const char *opt, const char *arg)
+{
+    return av_autotune_enable(arg);
+}
+
+static int opt_autotune_impl(void *optctx, const char *opt, const char *arg)
+{
+    char func[128];
+    const char *impl = strchr(arg, '=');
+
+    if (!impl || impl == arg || !impl[1]) {
+        av_log(NULL, AV_LOG_FATAL, "Invalid implementation %s, it must be "
+               "given as function=implementation\n", arg);
+        return AVERROR(EINVAL);
+    }
+    av_strlcpy(func, arg, FFMIN(sizeof(func), impl - arg + 1));
+
+    return av_autotune_force(func, impl + 1);
+}
+
 static int opt_channel_layout(void *optctx, const char *opt, const char *arg)
 {
     OptionsContext *o = optctx;
@@ -2092,6 +2115,10 @@ const OptionDef options[] = {
         "set the number of data frames to record", "number" },
     { "benchmark",      OPT_BOOL | OPT_EXPERT,                       { &do_benchmark },
         "add timings for benchmarking" },
+    { "filter_stats",   OPT_BOOL | OPT_EXPERT,                       { &do_filter_stats },
+        "print per-filter statistics at the end" },
+    { "trace",          HAS_ARG | OPT_STRING | OPT_EXPERT,           { &trace_filename },
+        "write a trace of the processing steps to the given file", "filename" },
     { "timelimit",      HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_timelimit },
         "set max runtime in seconds", "limit" },
     { "dump",           OPT_BOOL | OPT_EXPERT,                       { &do_pkt_dump },
@@ -2149,6 +2176,10 @@ const OptionDef options[] = {
         "extract an attachment into a file", "filename" },
     { "cpuflags",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_cpuflags },
         "set CPU flags mask", "mask" },
+    { "autotune",       HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_autotune },
+        "benchmark the optimized functions and cache the choices in a file", "file" },
+    { "autotune_impl",  HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_autotune_impl },
+        "force the implementation of an optimized function", "function=implementation" },
 
     /* video options */
     { "vframes",      OPT_VIDEO | HAS_ARG  | OPT_PERFILE | OPT_OUTPUT,           { .func_arg = opt_video_frames },
@@ -0,0 +1,146 @@
+/*
+ * avconv pipeline tracing
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "avconv.h"
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+/* number of events kept for each thread, the older ones are overwritten */
+#define TRACE_SIZE_LOG2 18
+
+TraceBuffer *main_trace;
+
+static TraceBuffer *trace_buffers;
+static int          nb_trace_buffers;
+static int64_t      trace_start;
+
+TraceBuffer *trace_buffer_alloc(const char *thread_name)
+{
+    TraceBuffer *tb;
+
+    if (!trace_filename)
+        return NULL;
+
+    tb = av_mallocz(sizeof(*tb));
+    if (!tb)
+        return NULL;
+    tb->events      = av_malloc(sizeof(*tb->events) << TRACE_SIZE_LOG2);
+    tb->thread_name = av_strdup(thread_name);
+    if (!tb->events || !tb->thread_name) {
+        av_freep(&tb->events);
+        av_freep(&tb->thread_name);
+        av_freep(&tb);
+        return NULL;
+    }
+
+    if (!trace_buffers)
+        trace_start = av_gettime();
+
+    tb->tid         = nb_trace_buffers++;
+    tb->next        = trace_buffers;
+    trace_buffers   = tb;
+
+    return tb;
+}
+
+int64_t trace_begin(void)
+{
+    return trace_filename ? av_gettime() : 0;
+}
+
+void trace_end(TraceBuffer *tb, const char *name, int64_t start,
+               int output, int file_index, int stream_index, int64_t pts)
+{
+    TraceEvent *ev;
+
+    if (!tb)
+        return;
+
+    ev = &tb->events[tb->nb_events++ & ((1 << TRACE_SIZE_LOG2) - 1)];
+    ev->name         = name;
+    ev->start        = start;
+    ev->duration     = av_gettime() - start;
+    ev->output       = output;
+    ev->file_index   = file_index;
+    ev->stream_index = stream_index;
+    ev->pts          = pts;
+}
+
+static void write_event(FILE *f, const TraceBuffer *tb, const TraceEvent *ev)
+{
+    fprintf(f, ",\n{ \"name\": \"%s\", \"cat\": \"avconv\", \"ph\": \"X\", "
+            "\"ts\": %"PRId64", \"dur\": %"PRId64", \"pid\": 0, \"tid\": %d",
+            ev->name, ev->start - trace_start, ev->duration, tb->tid);
+    if (ev->file_index >= 0) {
+        fprintf(f, ", \"args\": { \"stream\": \"%s#%d:%d\"",
+                ev->output ? "out" : "in", ev->file_index, ev->stream_index);
+        if (ev->pts != AV_NOPTS_VALUE)
+            fprintf(f, ", \"pts\": %"PRId64, ev->pts);
+        fprintf(f, " }");
+    }
+    fprintf(f, " }");
+}
+
+void trace_write(void)
+{
+    TraceBuffer *tb;
+    FILE *f;
+
+    if (!trace_buffers)
+        return;
+
+    f = fopen(trace_filename, "w");
+    if (!f) {
+        av_log(NULL, AV_LOG_ERROR, "Cannot open trace file %s\n",
+               trace_filename);
+    } else {
+        fprintf(f, "{ \"traceEvents\": [\n");
+        fprintf(f, "{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, "
+                "\"args\": { \"name\": \"avconv\" } }");
+
+        for (tb = trace_buffers; tb; tb = tb->next) {
+            unsigned size = 1 << TRACE_SIZE_LOG2;
+            unsigned i    = tb->nb_events > size ? tb->nb_events - size : 0;
+
+            fprintf(f, ",\n{ \"name\": \"thread_name\", \"ph\": \"M\", "
+                    "\"pid\": 0, \"tid\": %d, \"args\": { \"name\": \"%s\" } }",
+                    tb->tid, tb->thread_name);
+            for (; i != tb->nb_events; i++)
+                write_event(f, tb, &tb->events[i & (size - 1)]);
+        }
+
+        fprintf(f, "\n] }\n");
+        fclose(f);
+    }
+
+    while (trace_buffers) {
+        tb            = trace_buffers;
+        trace_buffers = tb->next;
+        av_freep(&tb->events);
+        av_freep(&tb->thread_name);
+        av_freep(&tb);
+    }
+    main_trace = NULL;
+}
@@ -1251,6 +1251,7 @@ static void do_exit(void)
 #if CONFIG_AVFILTER
     avfilter_uninit();
 #endif
+    av_packet_pool_uninit();
     avformat_network_deinit();
     if (show_status)
         printf("\n");
@@ -1441,6 +1442,27 @@ static int output_picture2(VideoState *is, AVFrame *src_frame, double pts1, int6
     return ret;
 }
 
+#if CONFIG_AVFILTER
+/* skip decoding the non-reference frames that the filters would drop anyway */
+static void update_skip_frame(VideoState *is, const AVPacket *pkt)
+{
+    AVCodecContext *dec = is->video_st->codec;
+    int64_t min_pts;
+    int pkt_pts_used;
+
+    dec->skip_frame = skip_frame;
+    if (!is->in_video_filter || pkt->pts == AV_NOPTS_VALUE)
+        return;
+
+    pkt_pts_used = decoder_reorder_pts == 1 ||
+                   (decoder_reorder_pts == -1 &&
+                    is->pts_ctx.num_faulty_pts <= is->pts_ctx.num_faulty_dts);
+    min_pts      = av_buffersrc_get_min_pts(is->in_video_filter);
+    if (pkt_pts_used && min_pts != AV_NOPTS_VALUE && pkt->pts < min_pts)
+        dec->skip_frame = FFMAX(skip_frame, AVDISCARD_NONREF);
+}
+#endif
+
 static int get_video_frame(VideoState *is, AVFrame *frame, int64_t *pts, AVPacket *pkt)
 {
     int got_picture, i;
@@ -1471,6 +1493,9 @@ static int get_video_frame(VideoState *is, AVFrame *frame, int64_t *pts, AVPacke
         return 0;
     }
 
+#if CONFIG_AVFILTER
+    update_skip_frame(is, pkt);
+#endif
     avcodec_decode_video2(is->video_st->codec, frame, &got_picture, pkt);
 
     if (got_picture) {
@@ -111,9 +111,10 @@ static void scale_coefficients(AC3EncodeContext *s)
 /*
  * Clip MDCT coefficients to allowable range.
  */
-static void clip_coefficients(DSPContext *dsp, int32_t *coef, unsigned int len)
+static void clip_coefficients(void *dsp, int32_t *coef, unsigned int len)
 {
-    dsp->vector_clip_int32(coef, coef, COEF_MIN, COEF_MAX, len);
+    DSPContext *dsp0 = dsp;
+    dsp0->vector_clip_int32(coef, coef, COEF_MIN, COEF_MAX, len);
 }
 
 
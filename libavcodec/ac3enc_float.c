@@ -121,9 +121,10 @@ static void scale_coefficients(AC3EncodeContext *s)
 /*
  * Clip MDCT coefficients to allowable range.
  */
-static void clip_coefficients(DSPContext *dsp, float *coef, unsigned int len)
+static void clip_coefficients(void *dsp, float *coef, unsigned int len)
 {
-    dsp->vector_clipf(coef, coef, COEF_MIN, COEF_MAX, len);
+    AVFloatDSPContext *fdsp = dsp;
+    fdsp->vector_clipf(coef, coef, COEF_MIN, COEF_MAX, len);
 }
 
 
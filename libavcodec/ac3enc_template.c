@@ -40,7 +40,7 @@ static void apply_window(void *dsp, SampleType *output,
 
 static int normalize_samples(AC3EncodeContext *s);
 
-static void clip_coefficients(DSPContext *dsp, CoefType *coef, unsigned int len);
+static void clip_coefficients(void *dsp, CoefType *coef, unsigned int len);
 
 static CoefType calc_cpl_coord(CoefSumType energy_ch, CoefSumType energy_cpl);
 
@@ -161,7 +161,11 @@ static void apply_channel_coupling(AC3EncodeContext *s)
         }
 
         /* coefficients must be clipped in order to be encoded */
+#if CONFIG_AC3ENC_FLOAT
+        clip_coefficients(&s->fdsp, cpl_coef, num_cpl_coefs);
+#else
         clip_coefficients(&s->dsp, cpl_coef, num_cpl_coefs);
+#endif
     }
 
     /* calculate energy in each band in coupling channel and each fbw channel */
@@ -412,8 +416,13 @@ int AC3_NAME(encode_frame)(AVCodecContext *avctx, AVPacket *avpkt,
     if (s->fixed_point)
         scale_coefficients(s);
 
+#if CONFIG_AC3ENC_FLOAT
+    clip_coefficients(&s->fdsp, s->blocks[0].mdct_coef[1],
+                      AC3_MAX_COEFS * s->num_blocks * s->channels);
+#else
     clip_coefficients(&s->dsp, s->blocks[0].mdct_coef[1],
                       AC3_MAX_COEFS * s->num_blocks * s->channels);
+#endif
 
     s->cpl_on = s->cpl_enabled;
     ff_ac3_compute_coupling_strategy(s);
@@ -587,6 +587,7 @@ static av_cold int alac_encode_init(AVCodecContext *avctx)
 
     s->avctx = avctx;
 
+    s->lpc_ctx.bitexact = avctx->flags & CODEC_FLAG_BITEXACT;
     if ((ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
                            s->max_prediction_order,
                            FF_LPC_TYPE_LEVINSON)) < 0) {
@@ -641,6 +641,7 @@ typedef struct RcOverride{
 #define CODEC_FLAG2_NO_OUTPUT     0x00000004 ///< Skip bitstream encoding.
 #define CODEC_FLAG2_LOCAL_HEADER  0x00000008 ///< Place global headers at every keyframe instead of in extradata.
 #define CODEC_FLAG2_IGNORE_CROP   0x00010000 ///< Discard cropping information from SPS.
+#define CODEC_FLAG2_HUGE_PAGES    0x00020000 ///< Back the large frames of the default get_buffer2() with huge pages.
 
 #define CODEC_FLAG2_CHUNKS        0x00008000 ///< Input bitstream might be truncated at a packet boundaries instead of only at frame boundaries.
 
@@ -3115,6 +3116,51 @@ void av_init_packet(AVPacket *pkt);
  */
 int av_new_packet(AVPacket *pkt, int size);
 
+/**
+ * Statistics of the pools the packet payloads are allocated from.
+ */
+typedef struct AVPacketPoolStats {
+    /**
+     * Number of payloads requested from the pools.
+     */
+    unsigned nb_requests;
+    /**
+     * Number of those requests that had to allocate new memory, the others
+     * reused a buffer returned to a pool.
+     */
+    unsigned nb_allocs;
+    /**
+     * Memory currently held by the pools, in bytes, including the buffers
+     * in use by packets.
+     */
+    int64_t retained;
+} AVPacketPoolStats;
+
+/**
+ * Get the statistics of the packet payload pools.
+ *
+ * The payloads allocated by av_new_packet(), av_grow_packet() and
+ * av_dup_packet() are taken from process-wide pools of power of two sizes.
+ */
+void av_packet_pool_get_stats(AVPacketPoolStats *stats);
+
+/**
+ * Free the buffers held by the packet payload pools that are not currently
+ * in use.
+ */
+void av_packet_pool_trim(void);
+
+/**
+ * Free the packet payload pools. The buffers still in use remain valid and
+ * are freed when they are released, the pools are created again on the next
+ * allocation.
+ *
+ * This function must not be called while other threads allocate packets. It
+ * is meant to be called once the caller is done with libavcodec, to release
+ * all the memory held by the pools.
+ */
+void av_packet_pool_uninit(void);
+
 /**
  * Reduce packet size, correctly zeroing padding
  *
@@ -19,13 +19,132 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdint.h>
 #include <string.h>
 
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
+#include "libavutil/buffer.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
 #include "avcodec.h"
 
+/* the payloads are allocated from pools of power of two sizes, larger ones
+ * are allocated directly */
+#define POOL_MIN_SIZE_LOG2  8
+#define POOL_MAX_SIZE_LOG2 22
+#define NB_POOLS (POOL_MAX_SIZE_LOG2 - POOL_MIN_SIZE_LOG2 + 1)
+
+static AVBufferPool * volatile pools[NB_POOLS];
+static volatile int pool_nb_buffers[NB_POOLS];
+static volatile int pool_nb_requests;
+static volatile int pool_nb_allocs;
+
+static int pool_index(int size)
+{
+    int idx = 0;
+
+    while (size > 1 << (POOL_MIN_SIZE_LOG2 + idx))
+        if (++idx == NB_POOLS)
+            return -1;
+    return idx;
+}
+
+static void pool_free_buffer(void *opaque, uint8_t *data)
+{
+    avpriv_atomic_int_add_and_fetch(&pool_nb_buffers[(intptr_t)opaque], -1);
+    av_free(data);
+}
+
+static AVBufferRef *pool_alloc_buffer(int size)
+{
+    intptr_t idx = pool_index(size);
+    AVBufferRef *buf;
+    uint8_t *data;
+
+    if (!(data = av_malloc(size)))
+        return NULL;
+    buf = av_buffer_create(data, size, pool_free_buffer, (void *)idx, 0);
+    if (!buf) {
+        av_free(data);
+        return NULL;
+    }
+
+    avpriv_atomic_int_add_and_fetch(&pool_nb_buffers[idx], 1);
+    avpriv_atomic_int_add_and_fetch(&pool_nb_allocs, 1);
+    return buf;
+}
+
+/**
+ * Allocate a buffer of at least size bytes for a packet payload, the padding
+ * included. The buffer is taken from the pool of the matching size class when
+ * there is one, the size of the returned reference is then that of the class.
+ */
+static AVBufferRef *packet_buffer_alloc(int size)
+{
+    AVBufferPool *pool;
+    AVBufferRef *buf = NULL;
+    int idx = pool_index(size);
+
+    if (idx < 0) {
+        av_buffer_realloc(&buf, size);
+        return buf;
+    }
+
+    if (!(pool = pools[idx])) {
+        AVBufferPool *new;
+        MEM_TAG_START(packets, "lavc:packets");
+
+        new = av_buffer_pool_init2(1 << (POOL_MIN_SIZE_LOG2 + idx),
+                                   pool_alloc_buffer,
+                                   AV_BUFFER_POOL_FLAG_THREAD_CACHES, 0);
+        MEM_TAG_STOP(packets);
+        if (!new)
+            return NULL;
+        /* another thread may have created the pool in the meantime */
+        if ((pool = avpriv_atomic_ptr_cas((void * volatile *)&pools[idx],
+                                          NULL, new)))
+            av_buffer_pool_uninit(&new);
+        else
+            pool = new;
+    }
+
+    avpriv_atomic_int_add_and_fetch(&pool_nb_requests, 1);
+    return av_buffer_pool_get(pool);
+}
+
+void av_packet_pool_get_stats(AVPacketPoolStats *stats)
+{
+    int i;
+
+    stats->nb_requests = avpriv_atomic_int_get(&pool_nb_requests);
+    stats->nb_allocs   = avpriv_atomic_int_get(&pool_nb_allocs);
+    stats->retained    = 0;
+    for (i = 0; i < NB_POOLS; i++)
+        stats->retained += (int64_t)avpriv_atomic_int_get(&pool_nb_buffers[i]) <<
+                           (POOL_MIN_SIZE_LOG2 + i);
+}
+
+void av_packet_pool_trim(void)
+{
+    int i;
+
+    for (i = 0; i < NB_POOLS; i++)
+        if (pools[i])
+            av_buffer_pool_trim(pools[i]);
+}
+
+void av_packet_pool_uninit(void)
+{
+    int i;
+
+    for (i = 0; i < NB_POOLS; i++) {
+        AVBufferPool *pool = pools[i];
+        pools[i] = NULL;
+        av_buffer_pool_uninit(&pool);
+    }
+}
+
 #if FF_API_DESTRUCT_PACKET
 void av_destruct_packet(AVPacket *pkt)
 {
@@ -61,12 +180,12 @@ void av_init_packet(AVPacket *pkt)
 
 int av_new_packet(AVPacket *pkt, int size)
 {
-    AVBufferRef *buf = NULL;
+    AVBufferRef *buf;
 
     if ((unsigned)size >= (unsigned)size + FF_INPUT_BUFFER_PADDING_SIZE)
         return AVERROR(EINVAL);
 
-    av_buffer_realloc(&buf, size + FF_INPUT_BUFFER_PADDING_SIZE);
+    buf = packet_buffer_alloc(size + FF_INPUT_BUFFER_PADDING_SIZE);
     if (!buf)
         return AVERROR(ENOMEM);
 
@@ -102,15 +221,20 @@ int av_grow_packet(AVPacket *pkt, int grow_by)
         return -1;
 
     new_size = pkt->size + grow_by + FF_INPUT_BUFFER_PADDING_SIZE;
-    if (pkt->buf) {
+    if (pkt->buf && av_buffer_is_writable(pkt->buf) &&
+        pkt->data == pkt->buf->data && new_size <= pkt->buf->size) {
+        /* the buffer of the size class is large enough */
+    } else if (pkt->buf && pool_index(new_size) < 0) {
         int ret = av_buffer_realloc(&pkt->buf, new_size);
         if (ret < 0)
             return ret;
     } else {
-        pkt->buf = av_buffer_alloc(new_size);
-        if (!pkt->buf)
+        AVBufferRef *buf = packet_buffer_alloc(new_size);
+        if (!buf)
             return AVERROR(ENOMEM);
-        memcpy(pkt->buf->data, pkt->data, FFMIN(pkt->size, pkt->size + grow_by));
+        memcpy(buf->data, pkt->data, FFMIN(pkt->size, pkt->size + grow_by));
+        av_buffer_unref(&pkt->buf);
+        pkt->buf = buf;
 #if FF_API_DESTRUCT_PACKET
         pkt->destruct = dummy_destruct_packet;
 #endif
@@ -144,7 +268,7 @@ int av_packet_from_data(AVPacket *pkt, uint8_t *data, int size)
 #define ALLOC_MALLOC(data, size) data = av_malloc(size)
 #define ALLOC_BUF(data, size)                \
 do {                                         \
-    av_buffer_realloc(&pkt->buf, size);      \
+    pkt->buf = packet_buffer_alloc(size);    \
     data = pkt->buf ? pkt->buf->data : NULL; \
 } while (0)
 
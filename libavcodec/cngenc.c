@@ -54,6 +54,7 @@ static av_cold int cng_encode_init(AVCodecContext *avctx)
 
     avctx->frame_size = 640;
     p->order = 10;
+    p->lpc.bitexact = avctx->flags & CODEC_FLAG_BITEXACT;
     if ((ret = ff_lpc_init(&p->lpc, avctx->frame_size, p->order, FF_LPC_TYPE_LEVINSON)) < 0)
         return ret;
     p->samples32 = av_malloc(avctx->frame_size * sizeof(*p->samples32));
@@ -151,6 +151,60 @@ static int get_consumed_bytes(MpegEncContext *s, int buf_size){
     }
 }
 
+/**
+ * Keep the frame following the current one in a divx 5.01+ packed bitstream,
+ * so that it is decoded on the next call.
+ */
+static int save_packed_frame(MpegEncContext *s, const uint8_t *buf, int buf_size)
+{
+    int current_pos= get_bits_count(&s->gb)>>3;
+    int startcode_found=0;
+
+    if(buf_size - current_pos > 5){
+        int i;
+        for(i=current_pos; i<buf_size-3; i++){
+            if(buf[i]==0 && buf[i+1]==0 && buf[i+2]==1 && buf[i+3]==0xB6){
+                startcode_found=1;
+                break;
+            }
+        }
+    }
+    if(s->gb.buffer == s->bitstream_buffer && buf_size>7 && s->xvid_build>=0){ //xvid style
+        startcode_found=1;
+        current_pos=0;
+    }
+
+    if(startcode_found){
+        av_fast_malloc(
+            &s->bitstream_buffer,
+            &s->allocated_bitstream_buffer_size,
+            buf_size - current_pos + FF_INPUT_BUFFER_PADDING_SIZE);
+        if (!s->bitstream_buffer)
+            return AVERROR(ENOMEM);
+        memcpy(s->bitstream_buffer, buf + current_pos, buf_size - current_pos);
+        s->bitstream_buffer_size= buf_size - current_pos;
+    }
+    return 0;
+}
+
+/**
+ * Return the number of bytes to consume for a frame of which only the header
+ * was read. Only MPEG-4 may store several frames in a packet, the next one
+ * starts at the next start code.
+ */
+static int get_skipped_bytes(MpegEncContext *s, const uint8_t *buf, int buf_size)
+{
+    int i;
+
+    if (s->codec_id != AV_CODEC_ID_MPEG4 || s->gb.buffer != buf)
+        return buf_size;
+
+    for (i = get_bits_count(&s->gb) >> 3; i < buf_size - 3; i++)
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] == 1)
+            return i;
+    return buf_size;
+}
+
 static int decode_slice(MpegEncContext *s){
     const int part_mask= s->partitioned_frame ? (ER_AC_END|ER_AC_ERROR) : 0x7F;
     const int mb_size = 16;
@@ -606,8 +660,17 @@ retry:
         return get_consumed_bytes(s, buf_size);
     if(   (avctx->skip_frame >= AVDISCARD_NONREF && s->pict_type==AV_PICTURE_TYPE_B)
        || (avctx->skip_frame >= AVDISCARD_NONKEY && s->pict_type!=AV_PICTURE_TYPE_I)
-       ||  avctx->skip_frame >= AVDISCARD_ALL)
+       ||  avctx->skip_frame >= AVDISCARD_ALL) {
+        /* only the header has been read, skip the rest of the frame but not
+           the frames following it in the packet */
+        if (s->codec_id == AV_CODEC_ID_MPEG4 && s->divx_packed) {
+            ret = save_packed_frame(s, buf, buf_size);
+            if (ret < 0)
+                return ret;
+        } else if (!(s->flags & CODEC_FLAG_TRUNCATED) && !avctx->hwaccel)
+            return get_skipped_bytes(s, buf, buf_size);
         return get_consumed_bytes(s, buf_size);
+    }
 
     if(s->next_p_frame_damaged){
         if(s->pict_type==AV_PICTURE_TYPE_B)
@@ -681,33 +744,9 @@ retry:
 frame_end:
     /* divx 5.01+ bistream reorder stuff */
     if(s->codec_id==AV_CODEC_ID_MPEG4 && s->divx_packed){
-        int current_pos= get_bits_count(&s->gb)>>3;
-        int startcode_found=0;
-
-        if(buf_size - current_pos > 5){
-            int i;
-            for(i=current_pos; i<buf_size-3; i++){
-                if(buf[i]==0 && buf[i+1]==0 && buf[i+2]==1 && buf[i+3]==0xB6){
-                    startcode_found=1;
-                    break;
-                }
-            }
-        }
-        if(s->gb.buffer == s->bitstream_buffer && buf_size>7 && s->xvid_build>=0){ //xvid style
-            startcode_found=1;
-            current_pos=0;
-        }
-
-        if(startcode_found){
-            av_fast_malloc(
-                &s->bitstream_buffer,
-                &s->allocated_bitstream_buffer_size,
-                buf_size - current_pos + FF_INPUT_BUFFER_PADDING_SIZE);
-            if (!s->bitstream_buffer)
-                return AVERROR(ENOMEM);
-            memcpy(s->bitstream_buffer, buf + current_pos, buf_size - current_pos);
-            s->bitstream_buffer_size= buf_size - current_pos;
-        }
+        ret = save_packed_frame(s, buf, buf_size);
+        if (ret < 0)
+            return ret;
     }
 
 intrax8_decoded:
@@ -53,6 +53,13 @@ typedef struct LPCContext {
     double *windowed_buffer;
     double *windowed_samples;
 
+    /**
+     * Set by the caller before ff_lpc_init() when the output must be
+     * reproducible, e.g. for CODEC_FLAG_BITEXACT. The optimized functions are
+     * then never chosen by benchmarking them, see avpriv_autotune().
+     */
+    int bitexact;
+
     /**
      * Apply a Welch window to an array of input samples.
      * The output samples have the same scale as the input, but are in double
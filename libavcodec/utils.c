@@ -36,6 +36,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/dict.h"
+#include "libavutil/timer.h"
 #include "avcodec.h"
 #include "dsputil.h"
 #include "libavutil/opt.h"
@@ -314,7 +315,7 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
         int size[4] = { 0 };
         int w = frame->width;
         int h = frame->height;
-        int tmpsize, unaligned;
+        int tmpsize, unaligned, flags;
 
         if (pool->format == frame->format &&
             pool->width == frame->width && pool->height == frame->height)
@@ -348,11 +349,19 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
             size[i] = picture.data[i + 1] - picture.data[i];
         size[i] = tmpsize - (picture.data[i] - picture.data[0]);
 
+        /* with frame threading, the buffers are requested and released from
+         * several threads at once */
+        flags = avctx->flags2 & CODEC_FLAG2_HUGE_PAGES ?
+                AV_BUFFER_POOL_FLAG_HUGE_PAGES : 0;
+        if (avctx->active_thread_type & FF_THREAD_FRAME)
+            flags |= AV_BUFFER_POOL_FLAG_THREAD_CACHES;
+
         for (i = 0; i < 4; i++) {
             av_buffer_pool_uninit(&pool->pools[i]);
             pool->linesize[i] = picture.linesize[i];
             if (size[i]) {
-                pool->pools[i] = av_buffer_pool_init(size[i] + 16, NULL);
+                pool->pools[i] = av_buffer_pool_init2(size[i] + 16, NULL,
+                                                      flags, 0);
                 if (!pool->pools[i]) {
                     ret = AVERROR(ENOMEM);
                     goto fail;
@@ -503,8 +512,11 @@ fail:
 int avcodec_default_get_buffer2(AVCodecContext *avctx, AVFrame *frame, int flags)
 {
     int ret;
+    MEM_TAG_START(pool, "lavc:frame pool");
 
-    if ((ret = update_frame_pool(avctx, frame)) < 0)
+    ret = update_frame_pool(avctx, frame);
+    MEM_TAG_STOP(pool);
+    if (ret < 0)
         return ret;
 
 #if FF_API_GET_BUFFER
@@ -1024,7 +1036,10 @@ int attribute_align_arg avcodec_open2(AVCodecContext *avctx, const AVCodec *code
     }
 
     if (avctx->codec->init && !(avctx->active_thread_type & FF_THREAD_FRAME)) {
+        MEM_TAG_START(init, "lavc:codec init");
+
         ret = avctx->codec->init(avctx);
+        MEM_TAG_STOP(init);
         if (ret < 0) {
             goto free_and_end;
         }
@@ -1152,6 +1167,7 @@ int attribute_align_arg avcodec_encode_audio2(AVCodecContext *avctx,
     AVFrame *padded_frame = NULL;
     int ret;
     int user_packet = !!avpkt->data;
+    PROBE_START(encode);
 
     *got_packet_ptr = 0;
 
@@ -1243,6 +1259,7 @@ end:
         av_freep(&padded_frame);
     }
 
+    PROBE_STOP(encode, "avcodec_encode_audio2");
     return ret;
 }
 
@@ -1253,6 +1270,7 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
 {
     int ret;
     int user_packet = !!avpkt->data;
+    PROBE_START(encode);
 
     *got_packet_ptr = 0;
 
@@ -1288,6 +1306,7 @@ int attribute_align_arg avcodec_encode_video2(AVCodecContext *avctx,
         av_free_packet(avpkt);
 
     emms_c();
+    PROBE_STOP(encode, "avcodec_encode_video2");
     return ret;
 }
 
@@ -1354,6 +1373,7 @@ int attribute_align_arg avcodec_decode_video2(AVCodecContext *avctx, AVFrame *pi
 {
     AVCodecInternal *avci = avctx->internal;
     int ret;
+    PROBE_START(decode);
 
     *got_picture_ptr = 0;
     if ((avctx->coded_width || avctx->coded_height) && av_image_check_size(avctx->coded_width, avctx->coded_height, 0, avctx))
@@ -1404,6 +1424,7 @@ int attribute_align_arg avcodec_decode_video2(AVCodecContext *avctx, AVFrame *pi
      * make sure it's set correctly */
     picture->extended_data = picture->data;
 
+    PROBE_STOP(decode, "avcodec_decode_video2");
     return ret;
 }
 
@@ -1415,6 +1436,7 @@ int attribute_align_arg avcodec_decode_audio4(AVCodecContext *avctx,
     AVCodecInternal *avci = avctx->internal;
     int planar, channels;
     int ret = 0;
+    PROBE_START(decode);
 
     *got_frame_ptr = 0;
 
@@ -1458,6 +1480,7 @@ int attribute_align_arg avcodec_decode_audio4(AVCodecContext *avctx,
     if (!(planar && channels > AV_NUM_DATA_POINTERS))
         frame->extended_data = frame->data;
 
+    PROBE_STOP(decode, "avcodec_decode_audio4");
     return ret;
 }
 
@@ -23,7 +23,9 @@
  */
 
 #include "libavutil/attributes.h"
+#include "libavutil/autotune_internal.h"
 #include "libavutil/cpu.h"
+#include "libavutil/internal.h"
 #include "libavutil/x86/asm.h"
 #include "libavcodec/dsputil.h"
 #include "libavcodec/h264dsp.h"
@@ -1305,40 +1307,6 @@ void ff_put_vc1_mspel_mc00_mmx(uint8_t *dst, const uint8_t *src,
     put_pixels8_mmx(dst, src, stride, 8);
 }
 
-static void vector_clipf_sse(float *dst, const float *src,
-                             float min, float max, int len)
-{
-    x86_reg i = (len - 16) * 4;
-    __asm__ volatile (
-        "movss          %3, %%xmm4      \n\t"
-        "movss          %4, %%xmm5      \n\t"
-        "shufps $0, %%xmm4, %%xmm4      \n\t"
-        "shufps $0, %%xmm5, %%xmm5      \n\t"
-        "1:                             \n\t"
-        "movaps   (%2, %0), %%xmm0      \n\t" // 3/1 on intel
-        "movaps 16(%2, %0), %%xmm1      \n\t"
-        "movaps 32(%2, %0), %%xmm2      \n\t"
-        "movaps 48(%2, %0), %%xmm3      \n\t"
-        "maxps      %%xmm4, %%xmm0      \n\t"
-        "maxps      %%xmm4, %%xmm1      \n\t"
-        "maxps      %%xmm4, %%xmm2      \n\t"
-        "maxps      %%xmm4, %%xmm3      \n\t"
-        "minps      %%xmm5, %%xmm0      \n\t"
-        "minps      %%xmm5, %%xmm1      \n\t"
-        "minps      %%xmm5, %%xmm2      \n\t"
-        "minps      %%xmm5, %%xmm3      \n\t"
-        "movaps     %%xmm0,   (%1, %0)  \n\t"
-        "movaps     %%xmm1, 16(%1, %0)  \n\t"
-        "movaps     %%xmm2, 32(%1, %0)  \n\t"
-        "movaps     %%xmm3, 48(%1, %0)  \n\t"
-        "sub           $64, %0          \n\t"
-        "jge            1b              \n\t"
-        : "+&r"(i)
-        : "r"(dst), "r"(src), "m"(min), "m"(max)
-        : "memory"
-    );
-}
-
 #endif /* HAVE_INLINE_ASM */
 
 int32_t ff_scalarproduct_int16_mmxext(const int16_t *v1, const int16_t *v2,
@@ -1598,11 +1566,24 @@ static av_cold void dsputil_init_sse(DSPContext *c, AVCodecContext *avctx,
             c->clear_blocks = clear_blocks_sse;
         }
     }
-
-    c->vector_clipf = vector_clipf_sse;
 #endif /* HAVE_INLINE_ASM */
 }
 
+#if HAVE_SSE2_EXTERNAL
+typedef struct Pixels16Bench {
+    op_pixels_func put[2], avg[2];
+    uint8_t *src, *dst;
+} Pixels16Bench;
+
+static void run_pixels16(void *opaque, int impl)
+{
+    Pixels16Bench *b = opaque;
+    b->put[impl](b->dst, b->src, 64, 16);
+    b->avg[impl](b->dst, b->src, 64, 16);
+    emms_c();
+}
+#endif /* HAVE_SSE2_EXTERNAL */
+
 static av_cold void dsputil_init_sse2(DSPContext *c, AVCodecContext *avctx,
                                       int mm_flags)
 {
@@ -1619,9 +1600,21 @@ static av_cold void dsputil_init_sse2(DSPContext *c, AVCodecContext *avctx,
 #endif /* HAVE_SSE2_INLINE */
 
 #if HAVE_SSE2_EXTERNAL
-    if (!(mm_flags & AV_CPU_FLAG_SSE2SLOW)) {
+    if (!high_bit_depth) {
+        static const char * const names[] = { "mmx", "sse2" };
+        LOCAL_ALIGNED_16(uint8_t, src, [16 * 64]);
+        LOCAL_ALIGNED_16(uint8_t, dst, [16 * 64]);
+        Pixels16Bench b = { { c->put_pixels_tab[0][0], ff_put_pixels16_sse2 },
+                            { c->avg_pixels_tab[0][0], ff_avg_pixels16_sse2 },
+                            src, dst };
         // these functions are slower than mmx on AMD, but faster on Intel
-        if (!high_bit_depth) {
+        int def = !(mm_flags & AV_CPU_FLAG_SSE2SLOW);
+
+        memset(src, 0x40, 16 * 64);
+        memset(dst, 0x80, 16 * 64);
+        if (avpriv_autotune("dsputil.pixels16", names, 2, def,
+                            avctx->flags & CODEC_FLAG_BITEXACT,
+                            run_pixels16, &b)) {
             c->put_pixels_tab[0][0]        = ff_put_pixels16_sse2;
             c->put_no_rnd_pixels_tab[0][0] = ff_put_pixels16_sse2;
             c->avg_pixels_tab[0][0]        = ff_avg_pixels16_sse2;
@@ -23,6 +23,7 @@
  */
 
 #include "libavutil/attributes.h"
+#include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
@@ -113,11 +114,62 @@ static void float_interleave_sse(float *dst, const float **src,
 }
 #endif /* HAVE_YASM */
 
+#if HAVE_AVX_INLINE
+static void int32_to_float_fmul_scalar_avx(float *dst, const int *src,
+                                           float mul, int len)
+{
+    x86_reg i = -len * 4;
+    __asm__ volatile (
+        "vbroadcastss         %3, %%ymm2            \n"
+        "1:                                         \n"
+        "vcvtdq2ps      (%2, %0), %%ymm0            \n"
+        "vmulps           %%ymm2, %%ymm0, %%ymm0    \n"
+        "vmovups          %%ymm0, (%1, %0)          \n"
+        "add                 $32, %0                \n"
+        "jl                   1b                    \n"
+        "vzeroupper                                 \n"
+        : "+r"(i)
+        : "r"(dst + len), "r"(src + len), "m"(mul)
+        : XMM_CLOBBERS("%xmm0", "%xmm2",) "memory"
+    );
+}
+#endif /* HAVE_AVX_INLINE */
+
+#if HAVE_AVX2_INLINE
+static void float_to_int16_avx2(int16_t *dst, const float *src, long len)
+{
+    long n = len & ~15;
+    x86_reg i = -n * 2;
+
+    if (n) {
+        /* the packing works within each 128-bit lane, vpermq puts the
+         * 64-bit quarters of the result back in order */
+        __asm__ volatile (
+            "1:                                             \n"
+            "vcvtps2dq        (%2, %0, 2), %%ymm0           \n"
+            "vcvtps2dq      32(%2, %0, 2), %%ymm1           \n"
+            "vpackssdw            %%ymm1, %%ymm0, %%ymm0    \n"
+            "vpermq        $0xd8, %%ymm0, %%ymm0            \n"
+            "vmovdqu              %%ymm0, (%1, %0)          \n"
+            "add                     $32, %0                \n"
+            "jl                       1b                    \n"
+            "vzeroupper                                     \n"
+            : "+r"(i)
+            : "r"(dst + n), "r"(src + n)
+            : XMM_CLOBBERS("%xmm0", "%xmm1",) "memory"
+        );
+    }
+    for (; n < len; n++)
+        dst[n] = av_clip_int16(lrintf(src[n]));
+}
+#endif /* HAVE_AVX2_INLINE */
+
 av_cold void ff_fmt_convert_init_x86(FmtConvertContext *c, AVCodecContext *avctx)
 {
-#if HAVE_YASM
     int mm_flags = av_get_cpu_flags();
 
+#if HAVE_YASM
+
     if (EXTERNAL_MMX(mm_flags)) {
         c->float_interleave = float_interleave_mmx;
 
@@ -145,4 +197,14 @@ av_cold void ff_fmt_convert_init_x86(FmtConvertContext *c, AVCodecContext *avctx
         }
     }
 #endif /* HAVE_YASM */
+#if HAVE_AVX_INLINE
+    if (INLINE_AVX(mm_flags)) {
+        c->int32_to_float_fmul_scalar = int32_to_float_fmul_scalar_avx;
+    }
+#endif
+#if HAVE_AVX2_INLINE
+    if (INLINE_AVX2(mm_flags)) {
+        c->float_to_int16 = float_to_int16_avx2;
+    }
+#endif
 }
@@ -21,6 +21,7 @@
 
 #include "libavutil/x86/asm.h"
 #include "libavutil/attributes.h"
+#include "libavutil/autotune_internal.h"
 #include "libavutil/cpu.h"
 #include "libavutil/internal.h"
 #include "libavcodec/lpc.h"
@@ -140,6 +141,33 @@ static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
     }
 }
 
+typedef struct AutocorrBench {
+    void (*funcs[2])(const double *data, int len, int lag, double *autoc);
+    LPCContext *c;
+    double autoc[MAX_LPC_ORDER + 1];
+} AutocorrBench;
+
+static void run_autocorr(void *opaque, int impl)
+{
+    AutocorrBench *b = opaque;
+    b->funcs[impl](b->c->windowed_samples, b->c->blocksize, b->c->max_order,
+                   b->autoc);
+}
+
+static av_cold void tune_autocorr(LPCContext *c)
+{
+    static const char * const names[] = { "c", "sse2" };
+    AutocorrBench b = { { c->lpc_compute_autocorr, lpc_compute_autocorr_sse2 },
+                        c };
+    int impl = 1;
+
+    /* the samples buffer only exists for the Levinson method */
+    if (c->windowed_samples)
+        impl = avpriv_autotune("lpc.compute_autocorr", names, 2, impl,
+                               c->bitexact, run_autocorr, &b);
+    c->lpc_compute_autocorr = b.funcs[impl];
+}
+
 #endif /* HAVE_SSE2_INLINE */
 
 av_cold void ff_lpc_init_x86(LPCContext *c)
@@ -149,7 +177,7 @@ av_cold void ff_lpc_init_x86(LPCContext *c)
 
     if (mm_flags & (AV_CPU_FLAG_SSE2|AV_CPU_FLAG_SSE2SLOW)) {
         c->lpc_apply_welch_window = lpc_apply_welch_window_sse2;
-        c->lpc_compute_autocorr   = lpc_compute_autocorr_sse2;
+        tune_autocorr(c);
     }
 #endif /* HAVE_SSE2_INLINE */
 }
@@ -157,4 +157,5 @@ AVFilter avfilter_af_aformat = {
 
     .inputs        = avfilter_af_aformat_inputs,
     .outputs       = avfilter_af_aformat_outputs,
+    .flags         = AVFILTER_FLAG_RECONFIG,
 };
@@ -52,4 +52,5 @@ AVFilter avfilter_af_anull = {
     .inputs    = avfilter_af_anull_inputs,
 
     .outputs   = avfilter_af_anull_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
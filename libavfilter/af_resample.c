@@ -28,6 +28,7 @@
 #include "libavutil/dict.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
 
 #include "libavresample/avresample.h"
 
@@ -66,6 +67,8 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
         av_dict_set(&s->options, "out_sample_rate",    NULL, 0);
     }
 
+    s->next_pts = AV_NOPTS_VALUE;
+
     return 0;
 }
 
@@ -104,6 +107,70 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
+/**
+ * Output the samples still buffered in the resampler before it is replaced
+ * with a new input format: the converted samples that did not fit in the
+ * previous output frames, followed by the samples delayed in the resampler.
+ * lavr cannot flush the latter, so they are pushed out with silence in the
+ * previous input format, keeping only the output samples that correspond to
+ * the delayed ones.
+ */
+static int drain_delay(AVFilterLink *outlink)
+{
+    ResampleContext *s = outlink->src->priv;
+    uint8_t *silence[AVRESAMPLE_MAX_CHANNELS] = { NULL };
+    int64_t format, channel_layout, sample_rate;
+    int available = avresample_available(s->avr);
+    int delay     = avresample_get_delay(s->avr);
+    int nb_channels, nb_delayed, nb_samples, linesize = 0, ret;
+    AVFrame *frame;
+
+    av_opt_get_int(s->avr, "in_sample_fmt",     0, &format);
+    av_opt_get_int(s->avr, "in_channel_layout", 0, &channel_layout);
+    av_opt_get_int(s->avr, "in_sample_rate",    0, &sample_rate);
+    nb_channels = av_get_channel_layout_nb_channels(channel_layout);
+    nb_delayed  = av_rescale(delay, outlink->sample_rate, sample_rate);
+    nb_samples  = available + nb_delayed;
+    if (!nb_samples)
+        return 0;
+
+    if (nb_delayed) {
+        if ((ret = av_samples_alloc(silence, &linesize, nb_channels, delay,
+                                    format, 0)) < 0)
+            return ret;
+        av_samples_set_silence(silence, 0, delay, nb_channels, format);
+    }
+
+    frame = ff_get_audio_buffer(outlink, nb_samples);
+    if (!frame) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    /* the samples already buffered in the output fifo come out first */
+    if (nb_delayed)
+        ret = avresample_convert(s->avr, frame->extended_data,
+                                 frame->linesize[0], nb_samples,
+                                 silence, linesize, delay);
+    else
+        ret = avresample_read(s->avr, frame->extended_data, nb_samples);
+    if (ret <= 0) {
+        av_frame_free(&frame);
+        goto fail;
+    }
+
+    frame->nb_samples = ret;
+    frame->pts        = s->next_pts;
+    if (s->next_pts != AV_NOPTS_VALUE)
+        s->next_pts += ret;
+
+    ret = ff_filter_frame(outlink, frame);
+
+fail:
+    av_freep(&silence[0]);
+    return ret;
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -113,8 +180,17 @@ static int config_output(AVFilterLink *outlink)
     int ret;
 
     if (s->avr) {
+        /* reconfigured with a new input, the output link keeps its format:
+         * send the samples of the old context before closing it, with the
+         * timestamps following the previous output */
+        outlink->time_base = (AVRational){ 1, outlink->sample_rate };
+        ret = drain_delay(outlink);
+        outlink->time_base = (AVRational){ 0, 0 };
+
         avresample_close(s->avr);
         avresample_free(&s->avr);
+        if (ret < 0)
+            return ret;
     }
 
     if (inlink->channel_layout == outlink->channel_layout &&
@@ -148,7 +224,6 @@ static int config_output(AVFilterLink *outlink)
         return ret;
 
     outlink->time_base = (AVRational){ 1, outlink->sample_rate };
-    s->next_pts        = AV_NOPTS_VALUE;
 
     av_get_channel_layout_string(buf1, sizeof(buf1),
                                  -1, inlink ->channel_layout);
@@ -302,4 +377,5 @@ AVFilter avfilter_af_resample = {
 
     .inputs    = avfilter_af_resample_inputs,
     .outputs   = avfilter_af_resample_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
@@ -18,33 +18,89 @@
 
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
+#include "libavutil/mem.h"
 
 #include "audio.h"
 #include "avfilter.h"
 #include "internal.h"
 
+static AVFrame *get_audio_buffer(AVFilterLink *link, int nb_samples)
+{
+    AVFrame *ret = NULL;
+
+    if (link->dstpad->get_audio_buffer)
+        ret = link->dstpad->get_audio_buffer(link, nb_samples);
+
+    if (!ret)
+        ret = ff_default_get_audio_buffer(link, nb_samples);
+
+    return ret;
+}
+
 AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
-    return ff_get_audio_buffer(link->dst->outputs[0], nb_samples);
+    return get_audio_buffer(link->dst->outputs[0], nb_samples);
+}
+
+/**
+ * (Re)create the pool of the link for frames with the given number of
+ * samples. The pool is kept as long as its buffers are large enough, so that
+ * frames of varying size do not recreate it every time.
+ */
+static int update_frame_pool(AVFilterLink *link, int channels, int nb_samples)
+{
+    FFFramePool *pool = link->frame_pool;
+    int ret;
+
+    if (pool && pool->format == link->format && pool->channels == channels &&
+        pool->samples >= nb_samples)
+        return 0;
+
+    if (!pool) {
+        pool = link->frame_pool = av_mallocz(sizeof(*pool));
+        if (!pool)
+            return AVERROR(ENOMEM);
+    }
+
+    av_buffer_pool_uninit(&pool->pools[0]);
+    pool->format = -1;
+
+    ret = av_samples_get_buffer_size(&pool->linesize[0], channels, nb_samples,
+                                     link->format, 0);
+    if (ret < 0)
+        return ret;
+
+    pool->pools[0] = av_buffer_pool_init(ret, NULL);
+    if (!pool->pools[0])
+        return AVERROR(ENOMEM);
+
+    pool->format   = link->format;
+    pool->channels = channels;
+    pool->samples  = nb_samples;
+
+    return 0;
 }
 
 AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
-    AVFrame *frame = av_frame_alloc();
+    AVFrame *frame;
     int channels = av_get_channel_layout_nb_channels(link->channel_layout);
     int buf_size, ret;
+    MEM_TAG_START(pool, "lavfi:frame pool");
 
-    if (!frame)
+    ret = update_frame_pool(link, channels, nb_samples);
+    MEM_TAG_STOP(pool);
+    if (ret < 0)
         return NULL;
 
-    buf_size = av_samples_get_buffer_size(NULL, channels, nb_samples,
-                                          link->format, 0);
-    if (buf_size < 0)
-        goto fail;
+    frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
 
-    frame->buf[0] = av_buffer_alloc(buf_size);
+    frame->buf[0] = av_buffer_pool_get(link->frame_pool->pools[0]);
     if (!frame->buf[0])
         goto fail;
+    buf_size = frame->buf[0]->size;
 
     frame->nb_samples = nb_samples;
     ret = avcodec_fill_audio_frame(frame, channels, link->format,
@@ -70,13 +126,13 @@ fail:
 
 AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
-    AVFrame *ret = NULL;
+    AVFrame *ret = get_audio_buffer(link, nb_samples);
+    int i;
 
-    if (link->dstpad->get_audio_buffer)
-        ret = link->dstpad->get_audio_buffer(link, nb_samples);
-
-    if (!ret)
-        ret = ff_default_get_audio_buffer(link, nb_samples);
+    for (i = 0; ret && i < FF_ARRAY_ELEMS(ret->buf) && ret->buf[i]; i++)
+        link->stats.bytes_allocated += ret->buf[i]->size;
+    for (i = 0; ret && i < ret->nb_extended_buf; i++)
+        link->stats.bytes_allocated += ret->extended_buf[i]->size;
 
     return ret;
 }
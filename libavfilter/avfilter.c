@@ -24,14 +24,18 @@
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/mathematics.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
+#include "libavutil/timer.h"
 
 #include "audio.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "thread.h"
 #include "video.h"
 
 unsigned avfilter_version(void) {
@@ -96,6 +100,7 @@ int avfilter_link(AVFilterContext *src, unsigned srcpad,
     link->type    = src->output_pads[srcpad].type;
     assert(AV_PIX_FMT_NONE == -1 && AV_SAMPLE_FMT_NONE == -1);
     link->format  = -1;
+    link->min_pts = AV_NOPTS_VALUE;
 
     return 0;
 }
@@ -137,9 +142,75 @@ int avfilter_insert_filter(AVFilterLink *link, AVFilterContext *filt,
     return 0;
 }
 
-int avfilter_config_links(AVFilterContext *filter)
+/**
+ * Set the properties of a link from the output pad of its source.
+ */
+static int config_output_link(AVFilterLink *link)
 {
     int (*config_link)(AVFilterLink *);
+    int ret;
+
+    if (!(config_link = link->srcpad->config_props)) {
+        if (link->src->nb_inputs != 1) {
+            av_log(link->src, AV_LOG_ERROR, "Source filters and filters "
+                                            "with more than one input "
+                                            "must set config_props() "
+                                            "callbacks on all outputs\n");
+            return AVERROR(EINVAL);
+        }
+    } else if ((ret = config_link(link)) < 0) {
+        av_log(link->src, AV_LOG_ERROR,
+               "Failed to configure output pad on %s\n",
+               link->src->name);
+        return ret;
+    }
+
+    if (link->time_base.num == 0 && link->time_base.den == 0)
+        link->time_base = link->src && link->src->nb_inputs ?
+            link->src->inputs[0]->time_base : AV_TIME_BASE_Q;
+
+    if (link->type == AVMEDIA_TYPE_VIDEO) {
+        if (!link->sample_aspect_ratio.num && !link->sample_aspect_ratio.den)
+            link->sample_aspect_ratio = link->src->nb_inputs ?
+                link->src->inputs[0]->sample_aspect_ratio : (AVRational){1,1};
+
+        if (link->src->nb_inputs) {
+            if (!link->w)
+                link->w = link->src->inputs[0]->w;
+            if (!link->h)
+                link->h = link->src->inputs[0]->h;
+        } else if (!link->w || !link->h) {
+            av_log(link->src, AV_LOG_ERROR,
+                   "Video source filters must set their output link's "
+                   "width and height\n");
+            return AVERROR(EINVAL);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Let the destination of a link configure its input pad.
+ */
+static int config_input_link(AVFilterLink *link)
+{
+    int (*config_link)(AVFilterLink *);
+    int ret;
+
+    if ((config_link = link->dstpad->config_props))
+        if ((ret = config_link(link)) < 0) {
+            av_log(link->src, AV_LOG_ERROR,
+                   "Failed to configure input pad on %s\n",
+                   link->dst->name);
+            return ret;
+        }
+
+    return 0;
+}
+
+int avfilter_config_links(AVFilterContext *filter)
+{
     unsigned i;
     int ret;
 
@@ -160,50 +231,9 @@ int avfilter_config_links(AVFilterContext *filter)
             if ((ret = avfilter_config_links(link->src)) < 0)
                 return ret;
 
-            if (!(config_link = link->srcpad->config_props)) {
-                if (link->src->nb_inputs != 1) {
-                    av_log(link->src, AV_LOG_ERROR, "Source filters and filters "
-                                                    "with more than one input "
-                                                    "must set config_props() "
-                                                    "callbacks on all outputs\n");
-                    return AVERROR(EINVAL);
-                }
-            } else if ((ret = config_link(link)) < 0) {
-                av_log(link->src, AV_LOG_ERROR,
-                       "Failed to configure output pad on %s\n",
-                       link->src->name);
+            if ((ret = config_output_link(link)) < 0 ||
+                (ret = config_input_link(link)) < 0)
                 return ret;
-            }
-
-            if (link->time_base.num == 0 && link->time_base.den == 0)
-                link->time_base = link->src && link->src->nb_inputs ?
-                    link->src->inputs[0]->time_base : AV_TIME_BASE_Q;
-
-            if (link->type == AVMEDIA_TYPE_VIDEO) {
-                if (!link->sample_aspect_ratio.num && !link->sample_aspect_ratio.den)
-                    link->sample_aspect_ratio = link->src->nb_inputs ?
-                        link->src->inputs[0]->sample_aspect_ratio : (AVRational){1,1};
-
-                if (link->src->nb_inputs) {
-                    if (!link->w)
-                        link->w = link->src->inputs[0]->w;
-                    if (!link->h)
-                        link->h = link->src->inputs[0]->h;
-                } else if (!link->w || !link->h) {
-                    av_log(link->src, AV_LOG_ERROR,
-                           "Video source filters must set their output link's "
-                           "width and height\n");
-                    return AVERROR(EINVAL);
-                }
-            }
-
-            if ((config_link = link->dstpad->config_props))
-                if ((ret = config_link(link)) < 0) {
-                    av_log(link->src, AV_LOG_ERROR,
-                           "Failed to configure input pad on %s\n",
-                           link->dst->name);
-                    return ret;
-                }
 
             link->init_state = AVLINK_INIT;
         }
@@ -212,6 +242,201 @@ int avfilter_config_links(AVFilterContext *filter)
     return 0;
 }
 
+typedef struct LinkProps {
+    int w, h, format;
+    AVRational sample_aspect_ratio;
+    AVRational time_base;
+    int sample_rate;
+    uint64_t channel_layout;
+} LinkProps;
+
+static void get_link_props(AVFilterLink *link, LinkProps *props)
+{
+    props->w                   = link->w;
+    props->h                   = link->h;
+    props->format              = link->format;
+    props->sample_aspect_ratio = link->sample_aspect_ratio;
+    props->time_base           = link->time_base;
+    props->sample_rate         = link->sample_rate;
+    props->channel_layout      = link->channel_layout;
+}
+
+static int link_formats_changed(AVFilterLink *link, const LinkProps *props)
+{
+    return link->format         != props->format      ||
+           link->sample_rate    != props->sample_rate ||
+           link->channel_layout != props->channel_layout;
+}
+
+static int link_props_changed(AVFilterLink *link, const LinkProps *props)
+{
+    return link_formats_changed(link, props)                        ||
+           link->w != props->w || link->h != props->h               ||
+           /* unset on audio links, where av_cmp_q() would not return 0 */
+           (link->type == AVMEDIA_TYPE_VIDEO &&
+            av_cmp_q(link->sample_aspect_ratio, props->sample_aspect_ratio)) ||
+           av_cmp_q(link->time_base, props->time_base);
+}
+
+static int format_is_in(AVFilterFormats *formats, int format)
+{
+    int i;
+
+    if (!formats)
+        return 1;
+    for (i = 0; i < formats->format_count; i++)
+        if (formats->formats[i] == format)
+            return 1;
+    return 0;
+}
+
+static int samplerate_is_in(AVFilterFormats *samplerates, int sample_rate)
+{
+    return !samplerates || !samplerates->format_count ||
+           format_is_in(samplerates, sample_rate);
+}
+
+static int channel_layout_is_in(AVFilterChannelLayouts *layouts,
+                                uint64_t channel_layout)
+{
+    int i;
+
+    if (!layouts || !layouts->nb_channel_layouts)
+        return 1;
+    for (i = 0; i < layouts->nb_channel_layouts; i++)
+        if (layouts->channel_layouts[i] == channel_layout)
+            return 1;
+    return 0;
+}
+
+/**
+ * Check that the destination of a link accepts the new format, sample rate
+ * and channel layout of the link, and carry them over to the outputs on which
+ * the filter requires the same ones as on that input.
+ */
+static int reconfig_formats(AVFilterLink *link)
+{
+    AVFilterContext *dst = link->dst;
+    int i, ret;
+
+    ret = dst->filter->query_formats ? dst->filter->query_formats(dst) :
+                                       ff_default_query_formats(dst);
+
+    if (ret >= 0 &&
+        (!format_is_in(link->out_formats, link->format)                ||
+         !samplerate_is_in(link->out_samplerates, link->sample_rate)   ||
+         !channel_layout_is_in(link->out_channel_layouts, link->channel_layout)))
+        ret = AVERROR(ENOSYS);
+
+    for (i = 0; ret >= 0 && i < dst->nb_outputs; i++) {
+        AVFilterLink *out = dst->outputs[i];
+
+        if (out->in_formats && out->in_formats == link->out_formats)
+            out->format = link->format;
+        if (out->in_samplerates && out->in_samplerates == link->out_samplerates)
+            out->sample_rate = link->sample_rate;
+        if (out->in_channel_layouts &&
+            out->in_channel_layouts == link->out_channel_layouts)
+            out->channel_layout = link->channel_layout;
+    }
+
+    for (i = 0; i < dst->nb_inputs; i++) {
+        ff_formats_unref(&dst->inputs[i]->out_formats);
+        ff_formats_unref(&dst->inputs[i]->out_samplerates);
+        ff_channel_layouts_unref(&dst->inputs[i]->out_channel_layouts);
+    }
+    for (i = 0; i < dst->nb_outputs; i++) {
+        ff_formats_unref(&dst->outputs[i]->in_formats);
+        ff_formats_unref(&dst->outputs[i]->in_samplerates);
+        ff_channel_layouts_unref(&dst->outputs[i]->in_channel_layouts);
+    }
+
+    return ret;
+}
+
+static int reconfig_input(AVFilterLink *link, const LinkProps *old);
+
+/**
+ * Recompute the properties of the outputs of a filter and reconfigure the
+ * filters downstream of those that changed.
+ *
+ * @param old the properties of the outputs before the change
+ */
+static int reconfig_outputs(AVFilterContext *filter, const LinkProps *old)
+{
+    int i, ret;
+
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+
+        link->w = link->h         = 0;
+        link->sample_aspect_ratio = (AVRational){ 0, 0 };
+        link->time_base           = (AVRational){ 0, 0 };
+        if ((ret = config_output_link(link)) < 0)
+            return ret;
+
+        if (link_props_changed(link, &old[i]) &&
+            (ret = reconfig_input(link, &old[i])) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static int reconfig_input(AVFilterLink *link, const LinkProps *old)
+{
+    AVFilterContext *dst = link->dst;
+    LinkProps *old_outputs = NULL;
+    int i, ret;
+
+    if (!(dst->filter->flags & AVFILTER_FLAG_RECONFIG) ||
+        dst->internal->queued) {
+        av_log(dst, AV_LOG_VERBOSE, "Cannot reconfigure the filter%s.\n",
+               dst->internal->queued ? " while it holds frames" : "");
+        return AVERROR(ENOSYS);
+    }
+    av_log(dst, AV_LOG_DEBUG, "Reconfiguring input '%s'.\n", link->dstpad->name);
+
+    if (dst->nb_outputs &&
+        !(old_outputs = av_malloc(dst->nb_outputs * sizeof(*old_outputs))))
+        return AVERROR(ENOMEM);
+    for (i = 0; i < dst->nb_outputs; i++)
+        get_link_props(dst->outputs[i], &old_outputs[i]);
+
+    if (link_formats_changed(link, old) && (ret = reconfig_formats(link)) < 0) {
+        av_log(dst, AV_LOG_VERBOSE, "The new input format is not supported.\n");
+        goto end;
+    }
+
+    if ((ret = config_input_link(link)) < 0)
+        goto end;
+
+    ret = reconfig_outputs(dst, old_outputs);
+
+end:
+    av_free(old_outputs);
+    return ret;
+}
+
+int ff_filter_reconfig_outputs(AVFilterContext *filter)
+{
+    LinkProps *old;
+    int i, ret;
+
+    if (!filter->nb_outputs)
+        return 0;
+
+    if (!(old = av_malloc(filter->nb_outputs * sizeof(*old))))
+        return AVERROR(ENOMEM);
+    for (i = 0; i < filter->nb_outputs; i++)
+        get_link_props(filter->outputs[i], &old[i]);
+
+    ret = reconfig_outputs(filter, old);
+
+    av_free(old);
+    return ret;
+}
+
 void ff_dlog_link(void *ctx, AVFilterLink *link, int end)
 {
     if (link->type == AVMEDIA_TYPE_VIDEO) {
@@ -236,10 +461,60 @@ void ff_dlog_link(void *ctx, AVFilterLink *link, int end)
     }
 }
 
-int ff_request_frame(AVFilterLink *link)
+static int profiling(AVFilterContext *ctx)
 {
-    FF_DPRINTF_START(NULL, request_frame); ff_dlog_link(NULL, link, 1);
+    return ctx->graph && ctx->graph->profile;
+}
+
+/**
+ * Total time spent so far in the filters called by the given filter through
+ * its links. Must be called with the profiling lock of the graph held.
+ */
+static int64_t sum_nested_time(AVFilterContext *ctx)
+{
+    int64_t t = 0;
+    int i;
+
+    for (i = 0; i < ctx->nb_inputs; i++)
+        if (ctx->inputs[i])
+            t += ctx->inputs[i]->request_frame_time_total;
+    for (i = 0; i < ctx->nb_outputs; i++)
+        if (ctx->outputs[i])
+            t += ctx->outputs[i]->filter_frame_time_total;
+    return t;
+}
+
+static int64_t nested_time(AVFilterContext *ctx)
+{
+    int64_t t;
+
+    ff_graph_profile_lock(ctx->graph);
+    t = sum_nested_time(ctx);
+    ff_graph_profile_unlock(ctx->graph);
+    return t;
+}
 
+/**
+ * Account the time of a call into a filter started at start, when the nested
+ * time of the filter was nested. Only the part not spent in other filters
+ * counts towards the time of the filter itself.
+ */
+static void update_time(AVFilterContext *ctx, int64_t start, int64_t nested,
+                        int64_t *total, int64_t *self, int64_t *self_max)
+{
+    int64_t elapsed = av_gettime() - start;
+    int64_t t;
+
+    ff_graph_profile_lock(ctx->graph);
+    t         = FFMAX(elapsed - (sum_nested_time(ctx) - nested), 0);
+    *total   += elapsed;
+    *self    += t;
+    *self_max = FFMAX(*self_max, t);
+    ff_graph_profile_unlock(ctx->graph);
+}
+
+static int request_frame(AVFilterLink *link)
+{
     if (link->srcpad->request_frame)
         return link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
@@ -247,6 +522,25 @@ int ff_request_frame(AVFilterLink *link)
     else return -1;
 }
 
+int ff_request_frame(AVFilterLink *link)
+{
+    int64_t start, nested;
+    int ret;
+
+    FF_DPRINTF_START(NULL, request_frame); ff_dlog_link(NULL, link, 1);
+
+    if (!profiling(link->src))
+        return request_frame(link);
+
+    start  = av_gettime();
+    nested = nested_time(link->src);
+    ret    = request_frame(link);
+    update_time(link->src, start, nested, &link->request_frame_time_total,
+                &link->stats.request_frame_time, &link->stats.request_frame_max);
+
+    return ret;
+}
+
 int ff_poll_frame(AVFilterLink *link)
 {
     int i, min = INT_MAX;
@@ -265,6 +559,22 @@ int ff_poll_frame(AVFilterLink *link)
     return min;
 }
 
+void ff_link_set_min_pts(AVFilterLink *link, int64_t pts)
+{
+    AVFilterContext *src = link->src;
+
+    link->min_pts = pts;
+
+    if (!(src->filter->flags & AVFILTER_FLAG_KEEP_PTS) ||
+        src->nb_inputs != 1 || !src->inputs[0])
+        return;
+
+    if (pts != AV_NOPTS_VALUE)
+        pts = av_rescale_q_rnd(pts, link->time_base, src->inputs[0]->time_base,
+                               AV_ROUND_DOWN);
+    ff_link_set_min_pts(src->inputs[0], pts);
+}
+
 #define MAX_REGISTERED_AVFILTERS_NB 64
 
 static AVFilter *registered_avfilters[MAX_REGISTERED_AVFILTERS_NB + 1];
@@ -326,6 +636,19 @@ static const AVClass avfilter_class = {
     LIBAVUTIL_VERSION_INT,
 };
 
+static int default_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    int i;
+
+    for (i = 0; i < nb_jobs; i++) {
+        int r = func(ctx, arg, i, nb_jobs);
+        if (ret)
+            ret[i] = r;
+    }
+    return 0;
+}
+
 int avfilter_open(AVFilterContext **filter_ctx, AVFilter *filter, const char *inst_name)
 {
     AVFilterContext *ret;
@@ -338,9 +661,16 @@ int avfilter_open(AVFilterContext **filter_ctx, AVFilter *filter, const char *in
     if (!ret)
         return AVERROR(ENOMEM);
 
-    ret->av_class = &avfilter_class;
-    ret->filter   = filter;
-    ret->name     = inst_name ? av_strdup(inst_name) : NULL;
+    ret->av_class    = &avfilter_class;
+    ret->filter      = filter;
+    ret->name        = inst_name ? av_strdup(inst_name) : NULL;
+    ret->thread_type = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_BRANCH;
+
+    ret->internal = av_mallocz(sizeof(*ret->internal));
+    if (!ret->internal)
+        goto err;
+    ret->internal->execute = default_execute;
+
     if (filter->priv_size) {
         ret->priv     = av_mallocz(filter->priv_size);
         if (!ret->priv)
@@ -384,10 +714,23 @@ err:
     av_freep(&ret->output_pads);
     ret->nb_outputs = 0;
     av_freep(&ret->priv);
+    av_freep(&ret->internal);
     av_free(ret);
     return AVERROR(ENOMEM);
 }
 
+void ff_frame_pool_uninit(FFFramePool **pool)
+{
+    int i;
+
+    if (!*pool)
+        return;
+
+    for (i = 0; i < FF_ARRAY_ELEMS((*pool)->pools); i++)
+        av_buffer_pool_uninit(&(*pool)->pools[i]);
+    av_freep(pool);
+}
+
 void avfilter_free(AVFilterContext *filter)
 {
     int i;
@@ -398,6 +741,10 @@ void avfilter_free(AVFilterContext *filter)
 
     for (i = 0; i < filter->nb_inputs; i++) {
         if ((link = filter->inputs[i])) {
+            if (link->frame_count_inplace || link->frame_count_copied)
+                av_log(filter, AV_LOG_VERBOSE, "input %d: %"PRId64" frames "
+                       "processed in place, %"PRId64" copied\n", i,
+                       link->frame_count_inplace, link->frame_count_copied);
             if (link->src)
                 link->src->outputs[link->srcpad - link->src->output_pads] = NULL;
             ff_formats_unref(&link->in_formats);
@@ -406,6 +753,7 @@ void avfilter_free(AVFilterContext *filter)
             ff_formats_unref(&link->out_samplerates);
             ff_channel_layouts_unref(&link->in_channel_layouts);
             ff_channel_layouts_unref(&link->out_channel_layouts);
+            ff_frame_pool_uninit(&link->frame_pool);
         }
         av_freep(&link);
     }
@@ -419,6 +767,7 @@ void avfilter_free(AVFilterContext *filter)
             ff_formats_unref(&link->out_samplerates);
             ff_channel_layouts_unref(&link->in_channel_layouts);
             ff_channel_layouts_unref(&link->out_channel_layouts);
+            ff_frame_pool_uninit(&link->frame_pool);
         }
         av_freep(&link);
     }
@@ -429,9 +778,49 @@ void avfilter_free(AVFilterContext *filter)
     av_freep(&filter->inputs);
     av_freep(&filter->outputs);
     av_freep(&filter->priv);
+    av_freep(&filter->internal->output_frames);
+    av_freep(&filter->internal->output_rets);
+    av_freep(&filter->internal);
     av_free(filter);
 }
 
+int avfilter_link_get_stats(AVFilterLink *link, AVFilterStats *stats)
+{
+    *stats = link->stats;
+    return 0;
+}
+
+int avfilter_get_stats(AVFilterContext *filter, AVFilterStats *stats)
+{
+    int i;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (i = 0; i < filter->nb_inputs; i++) {
+        AVFilterLink *link = filter->inputs[i];
+        if (!link)
+            continue;
+        stats->frames_in         += link->stats.frames_in;
+        stats->filter_frame_time += link->stats.filter_frame_time;
+        stats->filter_frame_max   = FFMAX(stats->filter_frame_max,
+                                          link->stats.filter_frame_max);
+    }
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+        if (!link)
+            continue;
+        stats->frames_out         += link->stats.frames_out;
+        stats->request_frame_time += link->stats.request_frame_time;
+        stats->request_frame_max   = FFMAX(stats->request_frame_max,
+                                           link->stats.request_frame_max);
+        stats->bytes_allocated    += link->stats.bytes_allocated;
+    }
+    stats->queued     = filter->internal->queued;
+    stats->max_queued = filter->internal->max_queued;
+
+    return 0;
+}
+
 int avfilter_init_filter(AVFilterContext *filter, const char *args, void *opaque)
 {
     int ret=0;
@@ -461,49 +850,137 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
     int (*filter_frame)(AVFilterLink *, AVFrame *);
     AVFilterPad *dst = link->dstpad;
     AVFrame *out;
+    int64_t start, nested;
+    int ret;
+    PROBE_START(filter);
 
     FF_DPRINTF_START(NULL, filter_frame);
     ff_dlog_link(NULL, link, 1);
 
+    link->stats.frames_in++;
+    link->stats.frames_out++;
+
     if (!(filter_frame = dst->filter_frame))
         filter_frame = default_filter_frame;
 
     /* copy the frame if needed */
-    if (dst->needs_writable && !av_frame_is_writable(frame)) {
+    if (dst->needs_writable && link->type == AVMEDIA_TYPE_VIDEO) {
+        out = ff_get_writable_video_buffer(link, frame, 1);
+        if (!out) {
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+        if (out != frame) {
+            av_log(link->dst, AV_LOG_DEBUG, "Copying data in avfilter.\n");
+            av_frame_free(&frame);
+        }
+    } else if (dst->needs_writable && !av_frame_is_writable(frame)) {
         av_log(link->dst, AV_LOG_DEBUG, "Copying data in avfilter.\n");
+        link->frame_count_copied++;
 
-        switch (link->type) {
-        case AVMEDIA_TYPE_VIDEO:
-            out = ff_get_video_buffer(link, link->w, link->h);
-            break;
-        case AVMEDIA_TYPE_AUDIO:
-            out = ff_get_audio_buffer(link, frame->nb_samples);
-            break;
-        default: return AVERROR(EINVAL);
+        if (link->type != AVMEDIA_TYPE_AUDIO) {
+            av_frame_free(&frame);
+            return AVERROR(EINVAL);
         }
+
+        out = ff_get_audio_buffer(link, frame->nb_samples);
         if (!out) {
             av_frame_free(&frame);
             return AVERROR(ENOMEM);
         }
         av_frame_copy_props(out, frame);
 
-        switch (link->type) {
-        case AVMEDIA_TYPE_VIDEO:
-            av_image_copy(out->data, out->linesize, frame->data, frame->linesize,
-                          frame->format, frame->width, frame->height);
-            break;
-        case AVMEDIA_TYPE_AUDIO:
-            av_samples_copy(out->extended_data, frame->extended_data,
-                            0, 0, frame->nb_samples,
-                            av_get_channel_layout_nb_channels(frame->channel_layout),
-                            frame->format);
-            break;
-        default: return AVERROR(EINVAL);
-        }
+        av_samples_copy(out->extended_data, frame->extended_data,
+                        0, 0, frame->nb_samples,
+                        av_get_channel_layout_nb_channels(frame->channel_layout),
+                        frame->format);
 
         av_frame_free(&frame);
-    } else
+    } else {
+        if (dst->needs_writable)
+            link->frame_count_inplace++;
         out = frame;
+    }
+
+    if (!profiling(link->dst)) {
+        ret = filter_frame(link, out);
+    } else {
+        start  = av_gettime();
+        nested = nested_time(link->dst);
+        ret    = filter_frame(link, out);
+        update_time(link->dst, start, nested, &link->filter_frame_time_total,
+                    &link->stats.filter_frame_time,
+                    &link->stats.filter_frame_max);
+    }
 
-    return filter_frame(link, out);
+    PROBE_STOP(filter, "ff_filter_frame");
+    return ret;
+}
+
+static int filter_frame_output(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AVFrame **frames = arg;
+    return ff_filter_frame(ctx->outputs[jobnr], frames[jobnr]);
+}
+
+int ff_filter_frame_outputs(AVFilterContext *ctx, AVFrame *frame)
+{
+    AVFilterInternal *internal = ctx->internal;
+    int i, ret = 0;
+
+    if (!internal->execute_outputs) {
+        for (i = 0; i < ctx->nb_outputs; i++) {
+            AVFrame *buf_out = av_frame_clone(frame);
+            if (!buf_out) {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+
+            ret = ff_filter_frame(ctx->outputs[i], buf_out);
+            if (ret < 0)
+                break;
+        }
+        av_frame_free(&frame);
+        return ret;
+    }
+
+    if (internal->nb_output_frames < ctx->nb_outputs) {
+        av_freep(&internal->output_frames);
+        av_freep(&internal->output_rets);
+        internal->nb_output_frames = 0;
+
+        internal->output_frames = av_mallocz(ctx->nb_outputs *
+                                             sizeof(*internal->output_frames));
+        internal->output_rets   = av_mallocz(ctx->nb_outputs *
+                                             sizeof(*internal->output_rets));
+        if (!internal->output_frames || !internal->output_rets) {
+            av_freep(&internal->output_frames);
+            av_freep(&internal->output_rets);
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+        internal->nb_output_frames = ctx->nb_outputs;
+    }
+
+    for (i = 0; i < ctx->nb_outputs; i++) {
+        internal->output_frames[i] = av_frame_clone(frame);
+        if (!internal->output_frames[i]) {
+            while (i--)
+                av_frame_free(&internal->output_frames[i]);
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    /* the frames are owned by ff_filter_frame() from here on */
+    internal->execute_outputs(ctx, filter_frame_output, internal->output_frames,
+                              internal->output_rets, ctx->nb_outputs);
+
+    for (i = 0; i < ctx->nb_outputs; i++) {
+        internal->output_frames[i] = NULL;
+        if (internal->output_rets[i] < 0 && ret >= 0)
+            ret = internal->output_rets[i];
+    }
+    av_frame_free(&frame);
+    return ret;
 }
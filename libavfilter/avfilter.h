@@ -372,6 +372,23 @@ const char *avfilter_pad_get_name(AVFilterPad *pads, int pad_idx);
  */
 enum AVMediaType avfilter_pad_get_type(AVFilterPad *pads, int pad_idx);
 
+/**
+ * The filter supports multithreading by splitting frames into multiple parts
+ * and processing them concurrently.
+ */
+#define AVFILTER_FLAG_SLICE_THREADS         (1 << 0)
+/**
+ * The filter outputs exactly one frame for each input frame, with the same
+ * timestamp, so the frames its output does not need are not needed on its
+ * input either.
+ */
+#define AVFILTER_FLAG_KEEP_PTS              (1 << 1)
+/**
+ * The filter can be configured again with different input properties, e.g.
+ * after av_buffersrc_reconfig(), without losing its state.
+ */
+#define AVFILTER_FLAG_RECONFIG              (1 << 2)
+
 /**
  * Filter definition. This defines the pads a filter contains, and all the
  * callback functions used to interact with the filter.
@@ -388,6 +405,11 @@ typedef struct AVFilter {
     const AVFilterPad *inputs;  ///< NULL terminated list of inputs. NULL if none
     const AVFilterPad *outputs; ///< NULL terminated list of outputs. NULL if none
 
+    /**
+     * A combination of AVFILTER_FLAG_*
+     */
+    int flags;
+
     /*****************************************************************
      * All fields below this line are not part of the public API. They
      * may not be used outside of libavfilter and can be changed and
@@ -422,6 +444,19 @@ typedef struct AVFilter {
     int priv_size;      ///< size of private data to allocate for the filter
 } AVFilter;
 
+/**
+ * Process multiple parts of the frame concurrently.
+ */
+#define AVFILTER_THREAD_SLICE (1 << 0)
+/**
+ * Run independent branches of the graph downstream of a filter's outputs
+ * concurrently. Only available with the internal threading implementation,
+ * i.e. when AVFilterGraph.execute is not set.
+ */
+#define AVFILTER_THREAD_BRANCH (1 << 1)
+
+typedef struct AVFilterInternal AVFilterInternal;
+
 /** An instance of a filter */
 struct AVFilterContext {
     const AVClass *av_class;              ///< needed for av_log()
@@ -445,8 +480,53 @@ struct AVFilterContext {
     unsigned    nb_outputs;         ///< number of output pads
 
     void *priv;                     ///< private data for use by the filter
+
+    struct AVFilterGraph *graph;    ///< filtergraph this filter belongs to
+
+    /**
+     * Type of multithreading being allowed/used. A combination of
+     * AVFILTER_THREAD_* flags.
+     *
+     * May be set by the caller before configuring the graph to forbid some
+     * or all kinds of multithreading for this filter. The default is allowing
+     * everything.
+     *
+     * When the graph is configured, this field is combined using bit AND with
+     * AVFilterGraph.thread_type to get the final mask used for determining
+     * allowed threading types. I.e. a threading type needs to be set in both
+     * to be allowed.
+     *
+     * After the graph is configured, libavfilter sets this field to the
+     * threading type that is actually used (0 for no multithreading).
+     */
+    int thread_type;
+
+    /**
+     * An opaque struct for libavfilter internal use.
+     */
+    AVFilterInternal *internal;
 };
 
+/**
+ * Statistics gathered about a filter or a link while frames pass through the
+ * graph, see avfilter_get_stats() and avfilter_link_get_stats().
+ *
+ * The times are only measured if AVFilterGraph.profile was set, they are
+ * wallclock times in microseconds and do not include the time spent in other
+ * filters called from the filter.
+ */
+typedef struct AVFilterStats {
+    int64_t frames_in;          ///< number of frames received
+    int64_t frames_out;         ///< number of frames sent
+    int64_t filter_frame_time;  ///< total time spent in filter_frame()
+    int64_t filter_frame_max;   ///< longest single filter_frame() call
+    int64_t request_frame_time; ///< total time spent in request_frame()
+    int64_t request_frame_max;  ///< longest single request_frame() call
+    int64_t bytes_allocated;    ///< size of the buffers allocated for sent frames
+    int     queued;             ///< number of frames currently queued
+    int     max_queued;         ///< highest number of frames queued at once
+} AVFilterStats;
+
 /**
  * A link between two filters. This contains pointers to the source and
  * destination filters between which this link exists, and the indexes of
@@ -521,6 +601,42 @@ struct AVFilterLink {
         AVLINK_STARTINIT,       ///< started, but incomplete
         AVLINK_INIT             ///< complete
     } init_state;
+
+    /**
+     * Pool of buffers used for the frames allocated on this link by the
+     * default get_video_buffer()/get_audio_buffer() implementations.
+     */
+    struct FFFramePool *frame_pool;
+
+    /**
+     * Number of frames received on this link that the destination filter
+     * needed to write to, and which were written in place or had to be
+     * written to a new buffer respectively.
+     */
+    int64_t frame_count_inplace;
+    int64_t frame_count_copied;
+
+    /**
+     * Statistics about the frames passed over this link. The times are those
+     * spent by the destination filter in filter_frame() and by the source
+     * filter in request_frame() for this link.
+     */
+    AVFilterStats stats;
+
+    /**
+     * Time spent in the calls to filter_frame() and request_frame() for this
+     * link, including the filters called from there.
+     */
+    int64_t filter_frame_time_total;
+    int64_t request_frame_time_total;
+
+    /**
+     * Frames with a timestamp lower than this one will be dropped by the
+     * filters downstream without affecting their output, so their source
+     * may skip producing them. AV_NOPTS_VALUE if all frames are needed.
+     * Set with ff_link_set_min_pts().
+     */
+    int64_t min_pts;
 };
 
 /**
@@ -535,6 +651,23 @@ struct AVFilterLink {
 int avfilter_link(AVFilterContext *src, unsigned srcpad,
                   AVFilterContext *dst, unsigned dstpad);
 
+/**
+ * Get the statistics of a filter, summed over all its links. The frames in and
+ * filter_frame() times are those of its inputs, the frames out,
+ * request_frame() times and allocated bytes those of its outputs.
+ *
+ * @return 0 on success, a negative AVERROR on failure
+ */
+int avfilter_get_stats(AVFilterContext *filter, AVFilterStats *stats);
+
+/**
+ * Get the statistics of a single link. The frames in and out are both the
+ * number of frames passed over the link.
+ *
+ * @return 0 on success, a negative AVERROR on failure
+ */
+int avfilter_link_get_stats(AVFilterLink *link, AVFilterStats *stats);
+
 /**
  * Negotiate the media format, dimensions, etc of all inputs to a filter.
  *
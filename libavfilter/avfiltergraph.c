@@ -25,24 +25,81 @@
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/log.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/samplefmt.h"
 #include "avfilter.h"
 #include "avfiltergraph.h"
 #include "formats.h"
 #include "internal.h"
+#include "thread.h"
+
+#define OFFSET(x) offsetof(AVFilterGraph, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_AUDIO_PARAM
+static const AVOption filtergraph_options[] = {
+    { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
+        { .i64 = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_BRANCH }, 0, INT_MAX, FLAGS, "thread_type" },
+        { "slice",  NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE  }, .flags = FLAGS, .unit = "thread_type" },
+        { "branch", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_BRANCH }, .flags = FLAGS, .unit = "thread_type" },
+    { "threads",     "Maximum number of threads", OFFSET(nb_threads),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
+    { "profile",     "Measure the time spent in each filter", OFFSET(profile),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, 1,       FLAGS },
+    { "huge_pages",  "Back large frames with huge pages", OFFSET(huge_pages),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, 1,       FLAGS },
+    { NULL },
+};
 
 static const AVClass filtergraph_class = {
     .class_name = "AVFilterGraph",
     .item_name  = av_default_item_name,
+    .option     = filtergraph_options,
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+#if !HAVE_THREADS
+void ff_graph_thread_free(AVFilterGraph *graph)
+{
+}
+
+int ff_graph_thread_init(AVFilterGraph *graph)
+{
+    graph->thread_type = 0;
+    graph->nb_threads  = 1;
+    return 0;
+}
+
+int ff_graph_branch_thread_init(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_profile_lock(AVFilterGraph *graph)
+{
+}
+
+void ff_graph_profile_unlock(AVFilterGraph *graph)
+{
+}
+#endif
+
 AVFilterGraph *avfilter_graph_alloc(void)
 {
     AVFilterGraph *ret = av_mallocz(sizeof(AVFilterGraph));
     if (!ret)
         return NULL;
+
+    ret->internal = av_mallocz(sizeof(*ret->internal));
+    if (!ret->internal) {
+        av_freep(&ret);
+        return NULL;
+    }
+
     ret->av_class = &filtergraph_class;
+    av_opt_set_defaults(ret);
+
     return ret;
 }
 
@@ -52,9 +109,13 @@ void avfilter_graph_free(AVFilterGraph **graph)
         return;
     for (; (*graph)->filter_count > 0; (*graph)->filter_count--)
         avfilter_free((*graph)->filters[(*graph)->filter_count - 1]);
+
+    ff_graph_thread_free(*graph);
+
     av_freep(&(*graph)->scale_sws_opts);
     av_freep(&(*graph)->resample_lavr_opts);
     av_freep(&(*graph)->filters);
+    av_freep(&(*graph)->internal);
     av_freep(graph);
 }
 
@@ -67,6 +128,7 @@ int avfilter_graph_add_filter(AVFilterGraph *graph, AVFilterContext *filter)
 
     graph->filters = filters;
     graph->filters[graph->filter_count++] = filter;
+    filter->graph = graph;
 
     return 0;
 }
@@ -163,6 +225,10 @@ AVFilterContext *avfilter_graph_get_filter(AVFilterGraph *graph, char *name)
     return NULL;
 }
 
+#define CONVERT_FORMAT         (1 << 0)
+#define CONVERT_SAMPLE_RATE    (1 << 1)
+#define CONVERT_CHANNEL_LAYOUT (1 << 2)
+
 static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
 {
     int i, j, ret;
@@ -190,16 +256,16 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
             if (link->in_formats != link->out_formats &&
                 !ff_merge_formats(link->in_formats,
                                         link->out_formats))
-                convert_needed = 1;
+                convert_needed |= CONVERT_FORMAT;
             if (link->type == AVMEDIA_TYPE_AUDIO) {
                 if (link->in_channel_layouts != link->out_channel_layouts &&
                     !ff_merge_channel_layouts(link->in_channel_layouts,
                                               link->out_channel_layouts))
-                    convert_needed = 1;
+                    convert_needed |= CONVERT_CHANNEL_LAYOUT;
                 if (link->in_samplerates != link->out_samplerates &&
                     !ff_merge_samplerates(link->in_samplerates,
                                           link->out_samplerates))
-                    convert_needed = 1;
+                    convert_needed |= CONVERT_SAMPLE_RATE;
             }
 
             if (convert_needed) {
@@ -248,6 +314,15 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
                     return AVERROR(EINVAL);
                 }
 
+                av_log(log_ctx, AV_LOG_DEBUG, "Inserting '%s' between the filter "
+                       "'%s' and the filter '%s': no common%s%s%s.\n", inst_name,
+                       link->src->name, link->dst->name,
+                       convert_needed & CONVERT_FORMAT ?
+                       (link->type == AVMEDIA_TYPE_VIDEO ? " pixel format" :
+                                                           " sample format") : "",
+                       convert_needed & CONVERT_SAMPLE_RATE    ? " sample rate"    : "",
+                       convert_needed & CONVERT_CHANNEL_LAYOUT ? " channel layout" : "");
+
                 if ((ret = avfilter_insert_filter(link, convert, 0, 0)) < 0)
                     return ret;
 
@@ -613,10 +688,212 @@ static void swap_sample_fmts(AVFilterGraph *graph)
 
 }
 
+static int pix_fmt_has_color(const AVPixFmtDescriptor *desc)
+{
+    return (desc->flags & (PIX_FMT_RGB | PIX_FMT_PAL)) ||
+           desc->nb_components - !!(desc->flags & PIX_FMT_ALPHA) >= 3;
+}
+
+static int pix_fmt_depth(const AVPixFmtDescriptor *desc)
+{
+    int i, depth = 0;
+
+    for (i = 0; i < desc->nb_components; i++)
+        depth = FFMAX(depth, desc->comp[i].depth_minus1 + 1);
+    return depth;
+}
+
+/**
+ * Estimate how expensive and how lossy it is to convert a picture from one
+ * pixel format to another. The result is only meaningful relative to other
+ * results of this function, 0 means no conversion at all.
+ */
+static int pix_fmt_conversion_cost(enum AVPixelFormat src, enum AVPixelFormat dst)
+{
+    const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src);
+    const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst);
+    int src_depth, dst_depth, src_color, dst_color;
+    int cost = 1;
+
+    if (src == dst)
+        return 0;
+    if (!src_desc || !dst_desc)
+        return 1 << 16;
+
+    /* bit depth: losing precision is much worse than carrying extra bits */
+    src_depth = pix_fmt_depth(src_desc);
+    dst_depth = pix_fmt_depth(dst_desc);
+    if (dst_depth < src_depth)
+        cost += 8 * (src_depth - dst_depth);
+    else
+        cost += (dst_depth - src_depth) >> 2;
+
+    /* format family: dropping the color, a colorspace matrix or a palette */
+    src_color = pix_fmt_has_color(src_desc);
+    dst_color = pix_fmt_has_color(dst_desc);
+    if (src_color && !dst_color)
+        cost += 256;
+    else if (!src_color && dst_color)
+        cost += 4;
+    else if (src_color &&
+             (src_desc->flags & PIX_FMT_RGB) != (dst_desc->flags & PIX_FMT_RGB))
+        cost += 16;
+    if (dst_desc->flags & PIX_FMT_PAL)
+        cost += 64;
+
+    /* chroma subsampling, counted per halving or doubling of each dimension */
+    if (src_color && dst_color) {
+        int dw = dst_desc->log2_chroma_w - src_desc->log2_chroma_w;
+        int dh = dst_desc->log2_chroma_h - src_desc->log2_chroma_h;
+
+        cost += dw > 0 ? 32 * dw : -2 * dw;
+        cost += dh > 0 ? 32 * dh : -2 * dh;
+    }
+
+    if ((src_desc->flags & PIX_FMT_ALPHA) && !(dst_desc->flags & PIX_FMT_ALPHA))
+        cost += 32;
+
+    return cost;
+}
+
+/**
+ * Return the pixel format of a video link if it is already decided, -1
+ * otherwise.
+ */
+static int link_pix_fmt(AVFilterLink *link)
+{
+    if (link->type != AVMEDIA_TYPE_VIDEO)
+        return -1;
+    if (!link->in_formats)
+        return link->format;
+    if (link->in_formats->format_count == 1)
+        return link->in_formats->formats[0];
+    return -1;
+}
+
+/**
+ * Pick the candidate format of an undecided link with the lowest total
+ * conversion cost from the fixed formats of the links on the other side of
+ * the filter.
+ */
+static int pick_cheapest_pix_fmt(AVFilterLink *link, AVFilterLink **others,
+                                 int nb_others, int to_link)
+{
+    AVFilterFormats *fmts = link->in_formats;
+    int best_idx = -1, best_cost = INT_MAX;
+    int i, j, nb_fixed = 0;
+
+    for (j = 0; j < nb_others; j++)
+        nb_fixed += link_pix_fmt(others[j]) >= 0;
+    if (!nb_fixed)
+        return 0;
+
+    for (i = 0; i < fmts->format_count; i++) {
+        int cost = 0;
+
+        for (j = 0; j < nb_others; j++) {
+            int fmt = link_pix_fmt(others[j]);
+            if (fmt < 0)
+                continue;
+            cost += to_link ? pix_fmt_conversion_cost(fmt, fmts->formats[i]) :
+                              pix_fmt_conversion_cost(fmts->formats[i], fmt);
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_idx  = i;
+        }
+    }
+    av_assert0(best_idx >= 0);
+
+    if (best_idx)
+        av_log(link->src, AV_LOG_DEBUG, "Picked %s instead of %s for the link "
+               "between filters %s and %s, estimated conversion cost %d.\n",
+               av_get_pix_fmt_name(fmts->formats[best_idx]),
+               av_get_pix_fmt_name(fmts->formats[0]),
+               link->src->name, link->dst->name, best_cost);
+
+    FFSWAP(int, fmts->formats[0], fmts->formats[best_idx]);
+    return 1;
+}
+
+static int pick_pix_fmts_on_filter(AVFilterContext *filter)
+{
+    int i, ret, change = 0;
+
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *link = filter->outputs[i];
+
+        if (link->type != AVMEDIA_TYPE_VIDEO || link_pix_fmt(link) >= 0 ||
+            !pick_cheapest_pix_fmt(link, filter->inputs, filter->nb_inputs, 1))
+            continue;
+        if ((ret = pick_format(link)) < 0)
+            return ret;
+        change = 1;
+    }
+
+    for (i = 0; i < filter->nb_inputs; i++) {
+        AVFilterLink *link = filter->inputs[i];
+
+        if (link->type != AVMEDIA_TYPE_VIDEO || link_pix_fmt(link) >= 0 ||
+            !pick_cheapest_pix_fmt(link, filter->outputs, filter->nb_outputs, 0))
+            continue;
+        if ((ret = pick_format(link)) < 0)
+            return ret;
+        change = 1;
+    }
+
+    return change;
+}
+
+/**
+ * Decide the pixel formats of the video links, starting from the links
+ * whose format is fixed and walking outwards, so that every filter gets the
+ * format closest to what it is fed or has to produce. This keeps the
+ * conversions done by scale filters, and the ones hidden inside other
+ * filters, as cheap as possible.
+ */
+static int pick_pix_fmts(AVFilterGraph *graph)
+{
+    int i, j, ret, change;
+
+    do {
+        do {
+            change = 0;
+            for (i = 0; i < graph->filter_count; i++) {
+                if ((ret = pick_pix_fmts_on_filter(graph->filters[i])) < 0)
+                    return ret;
+                change |= ret;
+            }
+        } while (change);
+
+        /* nothing left to propagate from, take the preferred format of the
+         * first undecided link and continue from there */
+        for (i = 0; i < graph->filter_count && !change; i++) {
+            AVFilterContext *filter = graph->filters[i];
+
+            for (j = 0; j < filter->nb_outputs; j++) {
+                AVFilterLink *link = filter->outputs[j];
+
+                if (link->type == AVMEDIA_TYPE_VIDEO && link->in_formats) {
+                    if ((ret = pick_format(link)) < 0)
+                        return ret;
+                    change = 1;
+                    break;
+                }
+            }
+        }
+    } while (change);
+
+    return 0;
+}
+
 static int pick_formats(AVFilterGraph *graph)
 {
     int i, j, ret;
 
+    if ((ret = pick_pix_fmts(graph)) < 0)
+        return ret;
+
     for (i = 0; i < graph->filter_count; i++) {
         AVFilterContext *filter = graph->filters[i];
 
@@ -630,6 +907,50 @@ static int pick_formats(AVFilterGraph *graph)
     return 0;
 }
 
+/**
+ * Log the formats the auto-inserted conversion filters ended up converting
+ * between.
+ */
+static void dump_conversions(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    int i;
+
+    if (av_log_get_level() < AV_LOG_DEBUG)
+        return;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterLink *inlink, *outlink;
+
+        if (!filter->name || strncmp(filter->name, "auto-inserted ", 14) ||
+            (strcmp(filter->filter->name, "scale") &&
+             strcmp(filter->filter->name, "resample")))
+            continue;
+        inlink  = filter->inputs[0];
+        outlink = filter->outputs[0];
+
+        if (inlink->type == AVMEDIA_TYPE_VIDEO) {
+            av_log(log_ctx, AV_LOG_DEBUG, "'%s' converts %s to %s for '%s', "
+                   "estimated conversion cost %d.\n", filter->name,
+                   av_get_pix_fmt_name(inlink->format),
+                   av_get_pix_fmt_name(outlink->format), outlink->dst->name,
+                   pix_fmt_conversion_cost(inlink->format, outlink->format));
+        } else if (inlink->type == AVMEDIA_TYPE_AUDIO) {
+            char in_layout[128], out_layout[128];
+
+            av_get_channel_layout_string(in_layout, sizeof(in_layout), -1,
+                                         inlink->channel_layout);
+            av_get_channel_layout_string(out_layout, sizeof(out_layout), -1,
+                                         outlink->channel_layout);
+            av_log(log_ctx, AV_LOG_DEBUG, "'%s' converts %s %dHz %s to "
+                   "%s %dHz %s for '%s'.\n", filter->name,
+                   av_get_sample_fmt_name(inlink->format), inlink->sample_rate,
+                   in_layout, av_get_sample_fmt_name(outlink->format),
+                   outlink->sample_rate, out_layout, outlink->dst->name);
+        }
+    }
+}
+
 /**
  * Configure the formats of all the links in the graph.
  */
@@ -655,6 +976,8 @@ static int graph_config_formats(AVFilterGraph *graph, AVClass *log_ctx)
     if ((ret = pick_formats(graph)) < 0)
         return ret;
 
+    dump_conversions(graph, log_ctx);
+
     return 0;
 }
 
@@ -696,6 +1019,138 @@ static int graph_insert_fifos(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+static int filter_index(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    int i;
+
+    for (i = 0; i < graph->filter_count; i++)
+        if (graph->filters[i] == filter)
+            return i;
+    return -1;
+}
+
+/**
+ * Check whether the parts of the graph reachable from each output of a
+ * filter, in any direction and without going through the filter itself,
+ * are disjoint. Frames can then be sent to the outputs concurrently.
+ *
+ * @return 1 if they are, 0 if not, a negative AVERROR on error
+ */
+static int outputs_are_independent(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    int *component, *stack;
+    int i, j, ret = 1;
+
+    component = av_malloc(graph->filter_count * sizeof(*component));
+    stack     = av_malloc(graph->filter_count * sizeof(*stack));
+    if (!component || !stack) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    for (i = 0; i < graph->filter_count; i++)
+        component[i] = -1;
+
+    for (i = 0; i < filter->nb_outputs && ret; i++) {
+        AVFilterLink *link = filter->outputs[i];
+        int idx = link ? filter_index(graph, link->dst) : -1;
+        int nb_stack = 0;
+
+        if (idx < 0 || component[idx] >= 0) {
+            ret = 0;
+            break;
+        }
+
+        component[idx]    = i;
+        stack[nb_stack++] = idx;
+        while (nb_stack && ret) {
+            AVFilterContext *cur = graph->filters[stack[--nb_stack]];
+
+            for (j = 0; j < cur->nb_inputs + cur->nb_outputs; j++) {
+                AVFilterLink *l = j < cur->nb_inputs ? cur->inputs[j] :
+                                  cur->outputs[j - cur->nb_inputs];
+                AVFilterContext *next;
+                int next_idx;
+
+                if (!l)
+                    continue;
+                next = j < cur->nb_inputs ? l->src : l->dst;
+                if (next == filter)
+                    continue;
+
+                next_idx = filter_index(graph, next);
+                if (next_idx < 0 || (component[next_idx] >= 0 &&
+                                     component[next_idx] != i)) {
+                    ret = 0;
+                    break;
+                }
+                if (component[next_idx] < 0) {
+                    component[next_idx] = i;
+                    stack[nb_stack++]   = next_idx;
+                }
+            }
+        }
+    }
+
+end:
+    av_freep(&component);
+    av_freep(&stack);
+    return ret;
+}
+
+/**
+ * Start the graph worker threads and select the threading type used by each
+ * filter.
+ */
+static int graph_config_threads(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    avfilter_execute_func *execute;
+    int i, ret;
+
+    if (!graph->execute && graph->thread_type & AVFILTER_THREAD_SLICE) {
+        ret = ff_graph_thread_init(graph);
+        if (ret < 0) {
+            av_log(log_ctx, AV_LOG_ERROR, "Error initializing threading.\n");
+            return ret;
+        }
+    }
+    if (graph->execute && !graph->nb_threads)
+        graph->nb_threads = av_cpu_count();
+    execute = graph->execute ? graph->execute : graph->internal->thread_execute;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *filt = graph->filters[i];
+        int thread_type       = filt->thread_type & graph->thread_type;
+
+        filt->thread_type = 0;
+        if (execute && filt->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
+            thread_type & AVFILTER_THREAD_SLICE) {
+            filt->thread_type       = AVFILTER_THREAD_SLICE;
+            filt->internal->execute = execute;
+        }
+
+        filt->internal->execute_outputs = NULL;
+        if (!graph->execute && thread_type & AVFILTER_THREAD_BRANCH &&
+            filt->nb_outputs > 1) {
+            ret = outputs_are_independent(graph, filt);
+            if (ret <= 0) {
+                if (ret < 0)
+                    return ret;
+                continue;
+            }
+            if ((ret = ff_graph_branch_thread_init(graph)) < 0) {
+                av_log(log_ctx, AV_LOG_ERROR, "Error initializing threading.\n");
+                return ret;
+            }
+            if (graph->internal->branch_execute) {
+                filt->thread_type              |= AVFILTER_THREAD_BRANCH;
+                filt->internal->execute_outputs = graph->internal->branch_execute;
+            }
+        }
+    }
+
+    return 0;
+}
+
 int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
 {
     int ret;
@@ -706,6 +1161,8 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_formats(graphctx, log_ctx)))
         return ret;
+    if ((ret = graph_config_threads(graphctx, log_ctx)) < 0)
+        return ret;
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
 
@@ -36,8 +36,10 @@
 
 typedef struct {
     AVFrame *cur_frame;          ///< last frame delivered on the sink
+    AVFrame *partial;            ///< samples of the last frame not returned yet
     AVAudioFifo  *audio_fifo;    ///< FIFO for audio samples
     int64_t next_pts;            ///< interpolating audio pts
+    int queued;                  ///< whether samples are kept between calls
 } BufferSinkContext;
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -46,6 +48,38 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     if (sink->audio_fifo)
         av_audio_fifo_free(sink->audio_fifo);
+    av_frame_free(&sink->partial);
+}
+
+static int config_input_audio(AVFilterLink *link)
+{
+    BufferSinkContext *s = link->dst->priv;
+
+    /* the fifo is empty, the sink is not reconfigured while it holds samples,
+     * but it must be allocated again with the new format */
+    if (s->audio_fifo) {
+        av_audio_fifo_free(s->audio_fifo);
+        s->audio_fifo = NULL;
+    }
+
+    return 0;
+}
+
+/**
+ * Report the samples kept in the fifo or the partial frame as one queued
+ * frame, so that the sink is not reconfigured while it holds samples with
+ * the previous parameters.
+ */
+static void update_queued(AVFilterContext *ctx)
+{
+    BufferSinkContext *s = ctx->priv;
+    int queued = s->partial ||
+                 (s->audio_fifo && av_audio_fifo_size(s->audio_fifo));
+
+    if (queued != s->queued) {
+        ff_update_queued(ctx, ctx->inputs[0], queued - s->queued);
+        s->queued = queued;
+    }
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *frame)
@@ -98,7 +132,66 @@ static int read_from_fifo(AVFilterContext *ctx, AVFrame *frame,
 
 }
 
-int av_buffersink_get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_samples)
+/**
+ * Check whether all the data pointers of an audio frame are aligned enough to
+ * be handed out without copying.
+ */
+static int is_aligned(AVFilterLink *link, AVFrame *frame)
+{
+    int planes = av_sample_fmt_is_planar(link->format) ?
+                 av_get_channel_layout_nb_channels(link->channel_layout) : 1;
+    int i;
+
+    for (i = 0; i < planes; i++)
+        if ((intptr_t)frame->extended_data[i] & 31)
+            return 0;
+    return 1;
+}
+
+/**
+ * Return the first nb_samples samples of the partially read frame as a new
+ * reference to the same data, and skip them in the partial frame.
+ */
+static int read_from_partial(AVFilterContext *ctx, AVFrame *frame,
+                             int nb_samples)
+{
+    BufferSinkContext *s = ctx->priv;
+    AVFilterLink   *link = ctx->inputs[0];
+    AVFrame *partial = s->partial;
+    int ret;
+
+    if (partial->nb_samples == nb_samples) {
+        av_frame_move_ref(frame, partial);
+        av_frame_free(&s->partial);
+    } else {
+        int nb_channels = av_get_channel_layout_nb_channels(link->channel_layout);
+        int planar      = av_sample_fmt_is_planar(link->format);
+        int planes      = planar ? nb_channels : 1;
+        int offset      = nb_samples * av_get_bytes_per_sample(link->format) *
+                          (planar ? 1 : nb_channels);
+        int i;
+
+        if ((ret = av_frame_ref(frame, partial)) < 0)
+            return ret;
+        frame->nb_samples = nb_samples;
+
+        for (i = 0; i < planes; i++)
+            partial->extended_data[i] += offset;
+        if (partial->data != partial->extended_data)
+            memcpy(partial->data, partial->extended_data,
+                   FFMIN(planes, FF_ARRAY_ELEMS(partial->data)) * sizeof(*partial->data));
+        partial->linesize[0] -= offset;
+        partial->nb_samples  -= nb_samples;
+    }
+
+    frame->pts = s->next_pts;
+    s->next_pts += av_rescale_q(nb_samples, (AVRational){1, link->sample_rate},
+                                link->time_base);
+
+    return 0;
+}
+
+static int get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_samples)
 {
     BufferSinkContext *s = ctx->priv;
     AVFilterLink   *link = ctx->inputs[0];
@@ -114,6 +207,20 @@ int av_buffersink_get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_sampl
         if (av_audio_fifo_size(s->audio_fifo) >= nb_samples)
             return read_from_fifo(ctx, frame, nb_samples);
 
+        if (s->partial) {
+            /* the samples can be returned without copying if they all come
+             * from a single frame */
+            if (!av_audio_fifo_size(s->audio_fifo) &&
+                s->partial->nb_samples >= nb_samples &&
+                is_aligned(link, s->partial))
+                return read_from_partial(ctx, frame, nb_samples);
+
+            ret = av_audio_fifo_write(s->audio_fifo, (void**)s->partial->extended_data,
+                                      s->partial->nb_samples);
+            av_frame_free(&s->partial);
+            continue;
+        }
+
         ret = ff_request_frame(link);
         if (ret == AVERROR_EOF && av_audio_fifo_size(s->audio_fifo))
             return read_from_fifo(ctx, frame, av_audio_fifo_size(s->audio_fifo));
@@ -127,15 +234,22 @@ int av_buffersink_get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_sampl
                                        link->time_base);
         }
 
-        ret = av_audio_fifo_write(s->audio_fifo, (void**)s->cur_frame->extended_data,
-                                  s->cur_frame->nb_samples);
-        av_frame_free(&s->cur_frame);
+        s->partial   = s->cur_frame;
+        s->cur_frame = NULL;
     }
 
     return ret;
 
 }
 
+int av_buffersink_get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_samples)
+{
+    int ret = get_samples(ctx, frame, nb_samples);
+
+    update_queued(ctx);
+    return ret;
+}
+
 #if FF_API_AVFILTERBUFFER
 static void compat_free_buffer(AVFilterBuffer *buf)
 {
@@ -225,12 +339,14 @@ AVFilter avfilter_vsink_buffer = {
 
     .inputs    = avfilter_vsink_buffer_inputs,
     .outputs   = NULL,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
 
 static const AVFilterPad avfilter_asink_abuffer_inputs[] = {
     {
         .name           = "default",
         .type           = AVMEDIA_TYPE_AUDIO,
+        .config_props   = config_input_audio,
         .filter_frame   = filter_frame,
         .needs_fifo     = 1
     },
@@ -245,4 +361,5 @@ AVFilter avfilter_asink_abuffer = {
 
     .inputs    = avfilter_asink_abuffer_inputs,
     .outputs   = NULL,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
@@ -77,8 +77,11 @@ int av_buffersink_get_frame(AVFilterContext *ctx, AVFrame *frame);
 
 /**
  * Same as av_buffersink_get_frame(), but with the ability to specify the number
- * of samples read. This function is less efficient than
- * av_buffersink_get_frame(), because it copies the data around.
+ * of samples read. The returned frame references the data of the filtered
+ * frames when the samples all come from a single one, otherwise the data is
+ * copied. This function is therefore less efficient than
+ * av_buffersink_get_frame() when the filtered frames do not contain a multiple
+ * of nb_samples samples.
  *
  * @param ctx pointer to a context of the abuffersink AVFilter.
  * @param frame pointer to an allocated frame that will be filled with data.
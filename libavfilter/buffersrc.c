@@ -70,19 +70,71 @@ typedef struct {
         return AVERROR(EINVAL);\
     }
 
+/**
+ * Check that a frame can be added to the source and make room for it in the
+ * FIFO.
+ */
+static int check_frame(AVFilterContext *ctx, const AVFrame *frame)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    if (s->eof)
+        return AVERROR(EINVAL);
+
+    switch (ctx->outputs[0]->type) {
+    case AVMEDIA_TYPE_VIDEO:
+        CHECK_VIDEO_PARAM_CHANGE(ctx, s, frame->width, frame->height,
+                                 frame->format);
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        CHECK_AUDIO_PARAM_CHANGE(ctx, s, frame->sample_rate, frame->channel_layout,
+                                 frame->format);
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+
+    if (!av_fifo_space(s->fifo))
+        return av_fifo_realloc2(s->fifo, av_fifo_size(s->fifo) +
+                                         sizeof(frame));
+
+    return 0;
+}
+
+/**
+ * Queue a frame, which must have been allocated with av_frame_alloc(). There
+ * must be space for it in the FIFO.
+ */
+static void queue_frame(AVFilterContext *ctx, AVFrame *frame)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    av_fifo_generic_write(s->fifo, &frame, sizeof(frame), NULL);
+    ff_update_queued(ctx, ctx->outputs[0], 1);
+}
+
 int av_buffersrc_write_frame(AVFilterContext *ctx, const AVFrame *frame)
 {
+    BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
-    int ret = 0;
+    int ret;
+
+    if (!frame) {
+        s->eof = 1;
+        return 0;
+    }
+    if ((ret = check_frame(ctx, frame)) < 0)
+        return ret;
 
     if (!(copy = av_frame_alloc()))
         return AVERROR(ENOMEM);
-    ret = av_frame_ref(copy, frame);
-    if (ret >= 0)
-        ret = av_buffersrc_add_frame(ctx, copy);
+    if ((ret = av_frame_ref(copy, frame)) < 0) {
+        av_frame_free(&copy);
+        return ret;
+    }
 
-    av_frame_free(&copy);
-    return ret;
+    queue_frame(ctx, copy);
+    return 0;
 }
 
 int av_buffersrc_add_frame(AVFilterContext *ctx, AVFrame *frame)
@@ -94,38 +146,65 @@ int av_buffersrc_add_frame(AVFilterContext *ctx, AVFrame *frame)
     if (!frame) {
         s->eof = 1;
         return 0;
-    } else if (s->eof)
+    }
+    if ((ret = check_frame(ctx, frame)) < 0)
+        return ret;
+
+    if (!(copy = av_frame_alloc()))
+        return AVERROR(ENOMEM);
+
+    /* take over the references when there are some, the data of frames that
+     * are not reference counted has to be copied */
+    if (frame->buf[0]) {
+        av_frame_move_ref(copy, frame);
+    } else if ((ret = av_frame_ref(copy, frame)) < 0) {
+        av_frame_free(&copy);
+        return ret;
+    }
+
+    queue_frame(ctx, copy);
+    return 0;
+}
+
+int av_buffersrc_reconfig(AVFilterContext *ctx, const AVFrame *frame,
+                          AVRational time_base)
+{
+    BufferSourceContext *s = ctx->priv;
+
+    if (!ctx->outputs[0] || ctx->outputs[0]->init_state != AVLINK_INIT)
         return AVERROR(EINVAL);
+    if (av_fifo_size(s->fifo)) {
+        av_log(ctx, AV_LOG_VERBOSE, "Cannot reconfigure with frames queued.\n");
+        return AVERROR(EAGAIN);
+    }
 
     switch (ctx->outputs[0]->type) {
     case AVMEDIA_TYPE_VIDEO:
-        CHECK_VIDEO_PARAM_CHANGE(ctx, s, frame->width, frame->height,
-                                 frame->format);
+        s->w       = frame->width;
+        s->h       = frame->height;
+        s->pix_fmt = frame->format;
+        if (frame->sample_aspect_ratio.num)
+            s->pixel_aspect = frame->sample_aspect_ratio;
         break;
     case AVMEDIA_TYPE_AUDIO:
-        CHECK_AUDIO_PARAM_CHANGE(ctx, s, frame->sample_rate, frame->channel_layout,
-                                 frame->format);
+        s->sample_fmt     = frame->format;
+        s->sample_rate    = frame->sample_rate;
+        s->channel_layout = frame->channel_layout;
         break;
     default:
         return AVERROR(EINVAL);
     }
+    if (time_base.num)
+        s->time_base = time_base;
 
-    if (!av_fifo_space(s->fifo) &&
-        (ret = av_fifo_realloc2(s->fifo, av_fifo_size(s->fifo) +
-                                         sizeof(copy))) < 0)
-        return ret;
-
-    if (!(copy = av_frame_alloc()))
-        return AVERROR(ENOMEM);
-    av_frame_move_ref(copy, frame);
-
-    if ((ret = av_fifo_generic_write(s->fifo, &copy, sizeof(copy), NULL)) < 0) {
-        av_frame_move_ref(frame, copy);
-        av_frame_free(&copy);
-        return ret;
-    }
+    return ff_filter_reconfig_outputs(ctx);
+}
 
-    return 0;
+int64_t av_buffersrc_get_min_pts(AVFilterContext *ctx)
+{
+    if (!ctx->outputs[0])
+        return AV_NOPTS_VALUE;
+    return ctx->outputs[0]->min_pts;
 }
 
 #if FF_API_AVFILTERBUFFER
@@ -372,11 +451,13 @@ static int config_props(AVFilterLink *link)
 
     switch (link->type) {
     case AVMEDIA_TYPE_VIDEO:
+        link->format = c->pix_fmt;
         link->w = c->w;
         link->h = c->h;
         link->sample_aspect_ratio = c->pixel_aspect;
         break;
     case AVMEDIA_TYPE_AUDIO:
+        link->format         = c->sample_fmt;
         link->channel_layout = c->channel_layout;
         link->sample_rate    = c->sample_rate;
         break;
@@ -400,6 +481,7 @@ static int request_frame(AVFilterLink *link)
         return AVERROR(EAGAIN);
     }
     av_fifo_generic_read(c->fifo, &frame, sizeof(frame), NULL);
+    ff_update_queued(link->src, link, -1);
 
     ff_filter_frame(link, frame);
 
@@ -70,4 +70,34 @@ int av_buffersrc_write_frame(AVFilterContext *s, const AVFrame *frame);
  */
 int av_buffersrc_add_frame(AVFilterContext *ctx, AVFrame *frame);
 
+/**
+ * Change the properties of the frames output by the buffer source to those
+ * of frame, and reconfigure the filters downstream that are affected by the
+ * change. The other filters are left untouched and keep their state.
+ *
+ * @param ctx an instance of the buffersrc filter, in a configured graph.
+ * @param frame a frame with the new properties: dimensions, pixel format and
+ * sample aspect ratio for video, sample format, sample rate and channel layout
+ * for audio.
+ * @param time_base the new time base of the frames, or {0, 0} to keep it.
+ *
+ * @return 0 on success, a negative AVERROR on error. AVERROR(ENOSYS) is
+ * returned if some of the filters cannot be reconfigured, AVERROR(EAGAIN) if
+ * frames added earlier have not been consumed yet. The graph cannot be used
+ * after a failure and must be configured again from scratch.
+ */
+int av_buffersrc_reconfig(AVFilterContext *ctx, const AVFrame *frame,
+                          AVRational time_base);
+
+/**
+ * Get the timestamp below which the frames added to the buffer source will be
+ * dropped by the filtergraph without affecting its output. The caller may
+ * then skip decoding such frames, e.g. by setting AVCodecContext.skip_frame.
+ *
+ * @param ctx an instance of the buffersrc filter.
+ * @return the timestamp in the time base of the buffer source, AV_NOPTS_VALUE
+ * if all the frames are needed.
+ */
+int64_t av_buffersrc_get_min_pts(AVFilterContext *ctx);
+
 #endif /* AVFILTER_BUFFERSRC_H */
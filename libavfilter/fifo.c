@@ -85,17 +85,20 @@ static int add_to_queue(AVFilterLink *inlink, AVFrame *frame)
 
     fifo->last = fifo->last->next;
     fifo->last->frame = frame;
+    ff_update_queued(inlink->dst, inlink, 1);
 
     return 0;
 }
 
-static void queue_pop(FifoContext *s)
+static void queue_pop(AVFilterContext *ctx)
 {
+    FifoContext *s = ctx->priv;
     Buf *tmp = s->root.next->next;
     if (s->last == s->root.next)
         s->last = &s->root;
     av_freep(&s->root.next);
     s->root.next = tmp;
+    ff_update_queued(ctx, ctx->inputs[0], -1);
 }
 
 /**
@@ -156,7 +159,7 @@ static int return_audio_frame(AVFilterContext *ctx)
         calc_ptr_alignment(head) >= 32) {
         if (head->nb_samples == link->request_samples) {
             out = head;
-            queue_pop(s);
+            queue_pop(ctx);
         } else {
             out = av_frame_clone(head);
             if (!out)
@@ -176,6 +179,9 @@ static int return_audio_frame(AVFilterContext *ctx)
             s->out->nb_samples = 0;
             s->out->pts                   = head->pts;
             s->allocated_samples          = link->request_samples;
+            /* the partial buffer counts as a queued frame until it is
+             * returned, the filter cannot be reconfigured while it exists */
+            ff_update_queued(ctx, ctx->inputs[0], 1);
         } else if (link->request_samples != s->allocated_samples) {
             av_log(ctx, AV_LOG_ERROR, "request_samples changed before the "
                    "buffer was returned.\n");
@@ -193,7 +199,7 @@ static int return_audio_frame(AVFilterContext *ctx)
 
             if (len == head->nb_samples) {
                 av_frame_free(&head);
-                queue_pop(s);
+                queue_pop(ctx);
 
                 if (!s->root.next &&
                     (ret = ff_request_frame(ctx->inputs[0])) < 0) {
@@ -215,6 +221,7 @@ static int return_audio_frame(AVFilterContext *ctx)
         }
         out = s->out;
         s->out = NULL;
+        ff_update_queued(ctx, ctx->inputs[0], -1);
     }
     return ff_filter_frame(link, out);
 }
@@ -233,7 +240,7 @@ static int request_frame(AVFilterLink *outlink)
         return return_audio_frame(outlink->src);
     } else {
         ret = ff_filter_frame(outlink, fifo->root.next->frame);
-        queue_pop(fifo);
+        queue_pop(outlink->src);
     }
 
     return ret;
@@ -269,6 +276,7 @@ AVFilter avfilter_vf_fifo = {
 
     .inputs    = avfilter_vf_fifo_inputs,
     .outputs   = avfilter_vf_fifo_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
 
 static const AVFilterPad avfilter_af_afifo_inputs[] = {
@@ -301,4 +309,5 @@ AVFilter avfilter_af_afifo = {
 
     .inputs    = avfilter_af_afifo_inputs,
     .outputs   = avfilter_af_afifo_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
@@ -24,7 +24,11 @@
  * internal API functions
  */
 
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
 #include "avfilter.h"
+#include "avfiltergraph.h"
+#include "thread.h"
 
 #if !FF_API_AVFILTERPAD_PUBLIC
 /**
@@ -117,6 +121,65 @@ struct AVFilterPad {
 };
 #endif
 
+struct AVFilterGraphInternal {
+    void *thread;
+    avfilter_execute_func *thread_execute;
+
+    void *branch_thread;
+    avfilter_execute_func *branch_execute;
+};
+
+struct AVFilterInternal {
+    avfilter_execute_func *execute;
+
+    /**
+     * Used by ff_filter_frame_outputs() to run the branches downstream of
+     * the outputs concurrently. NULL if they are not independent.
+     */
+    avfilter_execute_func *execute_outputs;
+
+    /**
+     * Per-output frames and return values of ff_filter_frame_outputs(),
+     * allocated on first use and reused for all the following frames.
+     */
+    AVFrame **output_frames;
+    int      *output_rets;
+    int    nb_output_frames;
+
+    /**
+     * Number of frames kept queued by the filter, see ff_update_queued().
+     */
+    int queued;
+    int max_queued;
+};
+
+/**
+ * Buffer pools used for allocating the frames of a link. The pools are
+ * recreated whenever the frame parameters change, except for audio frames
+ * with fewer samples than the pool was created for.
+ */
+typedef struct FFFramePool {
+    /**
+     * Pools for each data plane. For audio all the planes are stored in a
+     * single buffer, so only pools[0] is used.
+     */
+    AVBufferPool *pools[4];
+
+    /*
+     * Pool parameters
+     */
+    int format;
+    int width, height;
+    int linesize[4];
+    int channels;
+    int samples;    ///< maximum number of samples per audio frame
+} FFFramePool;
+
+/**
+ * Free a frame pool. Frames allocated from it remain valid.
+ */
+void ff_frame_pool_uninit(FFFramePool **pool);
+
 /** default handler for freeing audio/video buffer when there are no references left */
 void ff_avfilter_default_free_buffer(AVFilterBuffer *buf);
 
@@ -166,6 +229,20 @@ static inline void ff_insert_outpad(AVFilterContext *f, unsigned index,
 #endif
 }
 
+/**
+ * Update the number of frames a filter keeps queued after receiving them on
+ * the given link, or before sending them over it.
+ */
+static inline void ff_update_queued(AVFilterContext *ctx, AVFilterLink *link,
+                                    int delta)
+{
+    link->stats.queued    += delta;
+    link->stats.max_queued = FFMAX(link->stats.max_queued, link->stats.queued);
+    ctx->internal->queued    += delta;
+    ctx->internal->max_queued = FFMAX(ctx->internal->max_queued,
+                                      ctx->internal->queued);
+}
+
 /**
  * Poll a frame from the filter chain.
  *
@@ -183,6 +260,28 @@ int ff_poll_frame(AVFilterLink *link);
  */
 int ff_request_frame(AVFilterLink *link);
 
+/**
+ * Recompute the properties of the outputs of a configured filter, e.g. after
+ * the parameters of a source changed, and reconfigure the filters downstream
+ * for as long as the properties of their inputs change. The filters whose
+ * inputs are unchanged keep their state.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if one of the filters to reconfigure
+ * does not support it, another negative AVERROR on failure. The graph must be
+ * configured again from scratch when this function fails.
+ */
+int ff_filter_reconfig_outputs(AVFilterContext *filter);
+
+/**
+ * Tell the source of a link that the frames with a timestamp lower than pts
+ * will be dropped downstream, see AVFilterLink.min_pts. The hint is forwarded
+ * upstream through the filters flagged with AVFILTER_FLAG_KEEP_PTS.
+ *
+ * @param pts the timestamp in the link time base, AV_NOPTS_VALUE if all frames
+ *            are needed
+ */
+void ff_link_set_min_pts(AVFilterLink *link, int64_t pts);
+
 /**
  * Send a frame of data to the next filter.
  *
@@ -196,4 +295,29 @@ int ff_request_frame(AVFilterLink *link);
  */
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame);
 
+/**
+ * Send a reference to a frame to every output of a filter. If the branches
+ * of the graph starting at the outputs are independent, they are run
+ * concurrently; this call returns once all of them are done.
+ *
+ * @param frame the frame; ownership is taken by this function
+ * @return >= 0 on success, the first error returned by ff_filter_frame()
+ *         otherwise
+ */
+int ff_filter_frame_outputs(AVFilterContext *ctx, AVFrame *frame);
+
+/**
+ * Get the number of threads a filter should split its work into when using
+ * AVFilterInternal.execute.
+ *
+ * @return the number of threads of the graph if slice threading is used by
+ *         the filter, 1 otherwise
+ */
+static inline int ff_filter_get_nb_threads(AVFilterContext *ctx)
+{
+    if (ctx->graph && ctx->thread_type & AVFILTER_THREAD_SLICE)
+        return ctx->graph->nb_threads;
+    return 1;
+}
+
 #endif /* AVFILTER_INTERNAL_H */
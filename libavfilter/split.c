@@ -69,22 +69,7 @@ static void split_uninit(AVFilterContext *ctx)
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
-    AVFilterContext *ctx = inlink->dst;
-    int i, ret = 0;
-
-    for (i = 0; i < ctx->nb_outputs; i++) {
-        AVFrame *buf_out = av_frame_clone(frame);
-        if (!buf_out) {
-            ret = AVERROR(ENOMEM);
-            break;
-        }
-
-        ret = ff_filter_frame(ctx->outputs[i], buf_out);
-        if (ret < 0)
-            break;
-    }
-    av_frame_free(&frame);
-    return ret;
+    return ff_filter_frame_outputs(inlink->dst, frame);
 }
 
 static const AVFilterPad avfilter_vf_split_inputs[] = {
@@ -106,6 +91,7 @@ AVFilter avfilter_vf_split = {
 
     .inputs    = avfilter_vf_split_inputs,
     .outputs   = NULL,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
 
 static const AVFilterPad avfilter_af_asplit_inputs[] = {
@@ -127,4 +113,5 @@ AVFilter avfilter_af_asplit = {
 
     .inputs  = avfilter_af_asplit_inputs,
     .outputs = NULL,
+    .flags   = AVFILTER_FLAG_RECONFIG,
 };
@@ -0,0 +1,52 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_THREAD_H
+#define AVFILTER_THREAD_H
+
+#include "avfilter.h"
+#include "avfiltergraph.h"
+
+/**
+ * Start the worker threads of a graph and set
+ * AVFilterGraphInternal.thread_execute. On failure or when only one thread
+ * is used, slice threading is disabled for the graph.
+ */
+int ff_graph_thread_init(AVFilterGraph *graph);
+
+/**
+ * Start the worker threads used for running independent branches of a graph
+ * concurrently and set AVFilterGraphInternal.branch_execute. Nothing is done
+ * when only one thread is used.
+ */
+int ff_graph_branch_thread_init(AVFilterGraph *graph);
+
+/**
+ * Serialize the accesses to the profiling times of the links of a graph,
+ * which are updated from several threads when its branches run concurrently.
+ * Nothing is done when branch threading is not used.
+ */
+void ff_graph_profile_lock(AVFilterGraph *graph);
+void ff_graph_profile_unlock(AVFilterGraph *graph);
+
+/**
+ * Stop all the worker threads of a graph.
+ */
+void ff_graph_thread_free(AVFilterGraph *graph);
+
+#endif /* AVFILTER_THREAD_H */
@@ -70,7 +70,8 @@ typedef struct {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    uint8_t *temp[2]; ///< temporary buffers used in blur_power(), one set per thread
+    int temp_size;    ///< size of the temporary buffers of each thread
 } BoxBlurContext;
 
 #define Y 0
@@ -148,11 +149,12 @@ static int config_input(AVFilterLink *inlink)
     char *expr;
     int ret;
 
+    boxblur->temp_size = FFMAX(w, h);
     av_freep(&boxblur->temp[0]);
     av_freep(&boxblur->temp[1]);
-    if (!(boxblur->temp[0] = av_malloc(FFMAX(w, h))))
+    if (!(boxblur->temp[0] = av_malloc(boxblur->temp_size * ff_filter_get_nb_threads(ctx))))
        return AVERROR(ENOMEM);
-    if (!(boxblur->temp[1] = av_malloc(FFMAX(w, h)))) {
+    if (!(boxblur->temp[1] = av_malloc(boxblur->temp_size * ff_filter_get_nb_threads(ctx)))) {
         av_freep(&boxblur->temp[0]);
         return AVERROR(ENOMEM);
     }
@@ -307,16 +309,67 @@ static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    h, radius, power, temp);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[4], h[4];
+} ThreadData;
+
+/* rows are blurred horizontally and columns vertically, so the first pass is
+   split into ranges of rows and the second one into ranges of columns */
+static int filter_hblur(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *boxblur = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { boxblur->temp[0] + jobnr * boxblur->temp_size,
+                         boxblur->temp[1] + jobnr * boxblur->temp_size };
+    int plane;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++) {
+        int slice_start = (td->h[plane] *  jobnr   ) / nb_jobs;
+        int slice_end   = (td->h[plane] * (jobnr+1)) / nb_jobs;
+
+        hblur(td->out->data[plane] + slice_start * td->out->linesize[plane],
+              td->out->linesize[plane],
+              td->in ->data[plane] + slice_start * td->in ->linesize[plane],
+              td->in ->linesize[plane],
+              td->w[plane], slice_end - slice_start,
+              boxblur->radius[plane], boxblur->power[plane], temp);
+    }
+    return 0;
+}
+
+static int filter_vblur(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *boxblur = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { boxblur->temp[0] + jobnr * boxblur->temp_size,
+                         boxblur->temp[1] + jobnr * boxblur->temp_size };
+    int plane;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++) {
+        int slice_start = (td->w[plane] *  jobnr   ) / nb_jobs;
+        int slice_end   = (td->w[plane] * (jobnr+1)) / nb_jobs;
+
+        vblur(td->out->data[plane] + slice_start, td->out->linesize[plane],
+              td->out->data[plane] + slice_start, td->out->linesize[plane],
+              slice_end - slice_start, td->h[plane],
+              boxblur->radius[plane], boxblur->power[plane], temp);
+    }
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     BoxBlurContext *boxblur = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
-    int plane;
     int cw = inlink->w >> boxblur->hsub, ch = in->height >> boxblur->vsub;
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
+    ThreadData td = {
+        .in = in,
+        .w  = { inlink->w, cw, cw, inlink->w },
+        .h  = { in->height, ch, ch, in->height },
+    };
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -324,18 +377,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
+    td.out = out;
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], boxblur->radius[plane], boxblur->power[plane],
-              boxblur->temp);
-
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], boxblur->radius[plane], boxblur->power[plane],
-              boxblur->temp);
+    ctx->internal->execute(ctx, filter_hblur, &td, NULL,
+                           ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, filter_vblur, &td, NULL,
+                           ff_filter_get_nb_threads(ctx));
 
     av_frame_free(&in);
 
@@ -370,4 +417,6 @@ AVFilter avfilter_vf_boxblur = {
 
     .inputs    = avfilter_vf_boxblur_inputs,
     .outputs   = avfilter_vf_boxblur_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_KEEP_PTS,
 };
@@ -68,4 +68,5 @@ AVFilter avfilter_vf_copy = {
 
     .inputs    = avfilter_vf_copy_inputs,
     .outputs   = avfilter_vf_copy_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
@@ -101,37 +101,50 @@ static int config_props(AVFilterLink *inlink)
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     FadeContext *fade = inlink->dst->priv;
-    uint8_t *p;
+    AVFrame *out = frame;
+    const uint8_t *src;
+    uint8_t *dst;
     int i, j, plane;
 
+    /* frames outside of the fade are passed through untouched, so only
+     * get a writable frame when they are actually modified */
     if (fade->factor < UINT16_MAX) {
+        out = ff_get_writable_video_buffer(inlink, frame, 0);
+        if (!out) {
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+
         /* luma or rgb plane */
         for (i = 0; i < frame->height; i++) {
-            p = frame->data[0] + i * frame->linesize[0];
+            src = frame->data[0] + i * frame->linesize[0];
+            dst = out  ->data[0] + i * out  ->linesize[0];
             for (j = 0; j < inlink->w * fade->bpp; j++) {
                 /* fade->factor is using 16 lower-order bits for decimal
                  * places. 32768 = 1 << 15, it is an integer representation
                  * of 0.5 and is for rounding. */
-                *p = (*p * fade->factor + 32768) >> 16;
-                p++;
+                dst[j] = (src[j] * fade->factor + 32768) >> 16;
             }
         }
 
         if (frame->data[1] && frame->data[2]) {
             /* chroma planes */
             for (plane = 1; plane < 3; plane++) {
-                for (i = 0; i < frame->height; i++) {
-                    p = frame->data[plane] + (i >> fade->vsub) * frame->linesize[plane];
+                for (i = 0; i < -((-frame->height) >> fade->vsub); i++) {
+                    src = frame->data[plane] + i * frame->linesize[plane];
+                    dst = out  ->data[plane] + i * out  ->linesize[plane];
                     for (j = 0; j < inlink->w >> fade->hsub; j++) {
                         /* 8421367 = ((128 << 1) + 1) << 15. It is an integer
                          * representation of 128.5. The .5 is for rounding
                          * purposes. */
-                        *p = ((*p - 128) * fade->factor + 8421367) >> 16;
-                        p++;
+                        dst[j] = ((src[j] - 128) * fade->factor + 8421367) >> 16;
                     }
                 }
             }
         }
+
+        if (out != frame)
+            av_frame_free(&frame);
     }
 
     if (fade->frame_index >= fade->start_frame &&
@@ -140,7 +153,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     fade->factor = av_clip_uint16(fade->factor);
     fade->frame_index++;
 
-    return ff_filter_frame(inlink->dst->outputs[0], frame);
+    return ff_filter_frame(inlink->dst->outputs[0], out);
 }
 
 static const AVFilterPad avfilter_vf_fade_inputs[] = {
@@ -150,7 +163,6 @@ static const AVFilterPad avfilter_vf_fade_inputs[] = {
         .config_props     = config_props,
         .get_video_buffer = ff_null_get_video_buffer,
         .filter_frame     = filter_frame,
-        .needs_writable   = 1,
     },
     { NULL }
 };
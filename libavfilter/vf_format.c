@@ -128,6 +128,7 @@ AVFilter avfilter_vf_format = {
 
     .inputs    = avfilter_vf_format_inputs,
     .outputs   = avfilter_vf_format_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
 #endif /* CONFIG_FORMAT_FILTER */
 
@@ -167,5 +168,6 @@ AVFilter avfilter_vf_noformat = {
 
     .inputs    = avfilter_vf_noformat_inputs,
     .outputs   = avfilter_vf_noformat_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
 #endif /* CONFIG_NOFORMAT_FILTER */
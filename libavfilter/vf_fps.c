@@ -39,6 +39,7 @@ typedef struct FPSContext {
     /* timestamps in input timebase */
     int64_t first_pts;      ///< pts of the first frame that arrived on this filter
     int64_t pts;            ///< pts of the first frame currently in the fifo
+    AVRational time_base;   ///< input timebase the timestamps above are in
 
     AVRational framerate;   ///< target framerate
     char *fps;              ///< a string describing target framerate
@@ -87,15 +88,42 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
     if (!(s->fifo = av_fifo_alloc(2*sizeof(AVFrame*))))
         return AVERROR(ENOMEM);
 
+    s->pts = AV_NOPTS_VALUE;
+
     av_log(ctx, AV_LOG_VERBOSE, "fps=%d/%d\n", s->framerate.num, s->framerate.den);
     return 0;
 }
 
-static void flush_fifo(AVFifoBuffer *fifo)
+static int write_to_fifo(AVFilterContext *ctx, AVFrame *buf)
 {
-    while (av_fifo_size(fifo)) {
-        AVFrame *tmp;
-        av_fifo_generic_read(fifo, &tmp, sizeof(tmp), NULL);
+    FPSContext *s = ctx->priv;
+    int ret;
+
+    if (!av_fifo_space(s->fifo) &&
+        (ret = av_fifo_realloc2(s->fifo, 2*av_fifo_size(s->fifo)))) {
+        av_frame_free(&buf);
+        return ret;
+    }
+
+    av_fifo_generic_write(s->fifo, &buf, sizeof(buf), NULL);
+    return 0;
+}
+
+static AVFrame *read_from_fifo(AVFilterContext *ctx)
+{
+    FPSContext *s = ctx->priv;
+    AVFrame *buf;
+
+    av_fifo_generic_read(s->fifo, &buf, sizeof(buf), NULL);
+    return buf;
+}
+
+static void flush_fifo(AVFilterContext *ctx)
+{
+    FPSContext *s = ctx->priv;
+
+    while (av_fifo_size(s->fifo)) {
+        AVFrame *tmp = read_from_fifo(ctx);
         av_frame_free(&tmp);
     }
 }
@@ -105,7 +133,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     FPSContext *s = ctx->priv;
     if (s->fifo) {
         s->drop += av_fifo_size(s->fifo) / sizeof(AVFilterBufferRef*);
-        flush_fifo(s->fifo);
+        flush_fifo(ctx);
         av_fifo_free(s->fifo);
     }
 
@@ -113,14 +141,60 @@ static av_cold void uninit(AVFilterContext *ctx)
            "%d frames duplicated.\n", s->frames_in, s->frames_out, s->drop, s->dup);
 }
 
+/**
+ * Let the upstream filters know which frames will be dropped: those arriving
+ * less than half an output frame after s->pts give a delta < 1 below.
+ */
+static void update_min_pts(AVFilterContext *ctx)
+{
+    FPSContext      *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    int64_t half_frame = av_rescale_q_rnd(1, ctx->outputs[0]->time_base,
+                                          inlink->time_base, AV_ROUND_DOWN) / 2;
+
+    ff_link_set_min_pts(inlink, s->pts + half_frame);
+}
+
+/**
+ * The frames held in the fifo when the input is reconfigured have the old
+ * properties and cannot be sent after the filters downstream are
+ * reconfigured, so they are dropped. The next input frame takes the output
+ * slot of the first one.
+ */
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    FPSContext        *s = ctx->priv;
+
+    if (av_fifo_size(s->fifo)) {
+        int drop = av_fifo_size(s->fifo) / sizeof(AVFrame*);
+
+        av_log(ctx, AV_LOG_DEBUG, "Dropping %d frame(s) on reconfiguration.\n",
+               drop);
+        s->drop += drop;
+        flush_fifo(ctx);
+    }
+    return 0;
+}
+
 static int config_props(AVFilterLink* link)
 {
     FPSContext   *s = link->src->priv;
+    AVRational   tb = link->src->inputs[0]->time_base;
+
+    /* keep the timestamps when reconfigured with a new input timebase */
+    if (s->pts != AV_NOPTS_VALUE && av_cmp_q(tb, s->time_base)) {
+        s->first_pts = av_rescale_q(s->first_pts, s->time_base, tb);
+        s->pts       = av_rescale_q(s->pts,       s->time_base, tb);
+    }
+    s->time_base = tb;
 
     link->time_base = (AVRational){ s->framerate.den, s->framerate.num };
     link->w         = link->src->inputs[0]->w;
     link->h         = link->src->inputs[0]->h;
-    s->pts          = AV_NOPTS_VALUE;
+
+    if (s->pts != AV_NOPTS_VALUE)
+        update_min_pts(link->src);
 
     return 0;
 }
@@ -139,9 +213,8 @@ static int request_frame(AVFilterLink *outlink)
     if (ret == AVERROR_EOF && av_fifo_size(s->fifo)) {
         int i;
         for (i = 0; av_fifo_size(s->fifo); i++) {
-            AVFrame *buf;
+            AVFrame *buf = read_from_fifo(ctx);
 
-            av_fifo_generic_read(s->fifo, &buf, sizeof(buf), NULL);
             buf->pts = av_rescale_q(s->first_pts, ctx->inputs[0]->time_base,
                                     outlink->time_base) + s->frames_out;
 
@@ -156,20 +229,6 @@ static int request_frame(AVFilterLink *outlink)
     return ret;
 }
 
-static int write_to_fifo(AVFifoBuffer *fifo, AVFrame *buf)
-{
-    int ret;
-
-    if (!av_fifo_space(fifo) &&
-        (ret = av_fifo_realloc2(fifo, 2*av_fifo_size(fifo)))) {
-        av_frame_free(&buf);
-        return ret;
-    }
-
-    av_fifo_generic_write(fifo, &buf, sizeof(buf), NULL);
-    return 0;
-}
-
 static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
 {
     AVFilterContext    *ctx = inlink->dst;
@@ -182,11 +241,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
     /* discard frames until we get the first timestamp */
     if (s->pts == AV_NOPTS_VALUE) {
         if (buf->pts != AV_NOPTS_VALUE) {
-            ret = write_to_fifo(s->fifo, buf);
+            ret = write_to_fifo(ctx, buf);
             if (ret < 0)
                 return ret;
 
             s->first_pts = s->pts = buf->pts;
+            update_min_pts(ctx);
         } else {
             av_log(ctx, AV_LOG_WARNING, "Discarding initial frame(s) with no "
                    "timestamp.\n");
@@ -196,9 +256,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
         return 0;
     }
 
-    /* now wait for the next timestamp */
-    if (buf->pts == AV_NOPTS_VALUE) {
-        return write_to_fifo(s->fifo, buf);
+    /* now wait for the next timestamp; after a reconfiguration the fifo is
+     * empty and the frame fills the output slot of the dropped ones */
+    if (buf->pts == AV_NOPTS_VALUE || !av_fifo_size(s->fifo)) {
+        return write_to_fifo(ctx, buf);
     }
 
     /* number of output frames */
@@ -213,9 +274,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
         av_log(ctx, AV_LOG_DEBUG, "Dropping %d frame(s).\n", drop);
         s->drop += drop;
 
-        av_fifo_generic_read(s->fifo, &tmp, sizeof(tmp), NULL);
-        flush_fifo(s->fifo);
-        ret = write_to_fifo(s->fifo, tmp);
+        tmp = read_from_fifo(ctx);
+        flush_fifo(ctx);
+        ret = write_to_fifo(ctx, tmp);
 
         av_frame_free(&buf);
         return ret;
@@ -223,8 +284,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
 
     /* can output >= 1 frames */
     for (i = 0; i < delta; i++) {
-        AVFrame *buf_out;
-        av_fifo_generic_read(s->fifo, &buf_out, sizeof(buf_out), NULL);
+        AVFrame *buf_out = read_from_fifo(ctx);
 
         /* duplicate the frame if needed */
         if (!av_fifo_size(s->fifo) && i < delta - 1) {
@@ -232,7 +292,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
 
             av_log(ctx, AV_LOG_DEBUG, "Duplicating frame.\n");
             if (dup)
-                ret = write_to_fifo(s->fifo, dup);
+                ret = write_to_fifo(ctx, dup);
             else
                 ret = AVERROR(ENOMEM);
 
@@ -255,10 +315,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
 
         s->frames_out++;
     }
-    flush_fifo(s->fifo);
+    flush_fifo(ctx);
 
-    ret = write_to_fifo(s->fifo, buf);
+    ret = write_to_fifo(ctx, buf);
     s->pts = s->first_pts + av_rescale_q(s->frames_out, outlink->time_base, inlink->time_base);
+    update_min_pts(ctx);
 
     return ret;
 }
@@ -268,6 +329,7 @@ static const AVFilterPad avfilter_vf_fps_inputs[] = {
         .name        = "default",
         .type        = AVMEDIA_TYPE_VIDEO,
         .filter_frame = filter_frame,
+        .config_props = config_input,
     },
     { NULL }
 };
@@ -293,4 +355,5 @@ AVFilter avfilter_vf_fps = {
 
     .inputs    = avfilter_vf_fps_inputs,
     .outputs   = avfilter_vf_fps_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
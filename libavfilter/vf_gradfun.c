@@ -78,13 +78,13 @@ void ff_gradfun_blur_line_c(uint16_t *dc, uint16_t *buf, uint16_t *buf1, uint8_t
     }
 }
 
-static void filter(GradFunContext *ctx, uint8_t *dst, uint8_t *src, int width, int height, int dst_linesize, int src_linesize, int r)
+static void filter(GradFunContext *ctx, uint16_t *tmp, uint8_t *dst, uint8_t *src, int width, int height, int dst_linesize, int src_linesize, int r)
 {
     int bstride = FFALIGN(width, 16) / 2;
     int y;
     uint32_t dc_factor = (1 << 21) / (r * r);
-    uint16_t *dc = ctx->buf + 16;
-    uint16_t *buf = ctx->buf + bstride + 32;
+    uint16_t *dc = tmp + 16;
+    uint16_t *buf = tmp + bstride + 32;
     int thresh = ctx->thresh;
 
     memset(dc, 0, (bstride + 16) * sizeof(*buf));
@@ -146,7 +146,10 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     GradFunContext *gf = ctx->priv;
-    av_freep(&gf->buf);
+    int p;
+
+    for (p = 0; p < 4; p++)
+        av_freep(&gf->buf[p]);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -170,10 +173,16 @@ static int config_input(AVFilterLink *inlink)
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     int hsub = desc->log2_chroma_w;
     int vsub = desc->log2_chroma_h;
-
-    gf->buf = av_mallocz((FFALIGN(inlink->w, 16) * (gf->radius + 1) / 2 + 32) * sizeof(uint16_t));
-    if (!gf->buf)
-        return AVERROR(ENOMEM);
+    int p;
+
+    /* the blur is recursive within a plane, use separate buffers so that the
+       planes can be filtered in parallel */
+    for (p = 0; p < 4; p++) {
+        av_freep(&gf->buf[p]);
+        gf->buf[p] = av_mallocz((FFALIGN(inlink->w, 16) * (gf->radius + 1) / 2 + 32) * sizeof(uint16_t));
+        if (!gf->buf[p])
+            return AVERROR(ENOMEM);
+    }
 
     gf->chroma_w = -((-inlink->w) >> hsub);
     gf->chroma_h = -((-inlink->h) >> vsub);
@@ -182,12 +191,42 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int filter_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    GradFunContext *gf = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int p = jobnr;
+    int w = inlink->w;
+    int h = inlink->h;
+    int r = gf->radius;
+
+    if (p) {
+        w = gf->chroma_w;
+        h = gf->chroma_h;
+        r = gf->chroma_r;
+    }
+
+    if (FFMIN(w, h) > 2 * r)
+        filter(gf, gf->buf[p], out->data[p], in->data[p], w, h, out->linesize[p], in->linesize[p], r);
+    else if (out->data[p] != in->data[p])
+        av_image_copy_plane(out->data[p], out->linesize[p], in->data[p], in->linesize[p], w, h);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    GradFunContext *gf = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    ThreadData td;
     AVFrame *out;
-    int p, direct;
+    int nb_planes, direct;
 
     if (av_frame_is_writable(in)) {
         direct = 1;
@@ -205,21 +244,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         out->height = outlink->h;
     }
 
-    for (p = 0; p < 4 && in->data[p]; p++) {
-        int w = inlink->w;
-        int h = inlink->h;
-        int r = gf->radius;
-        if (p) {
-            w = gf->chroma_w;
-            h = gf->chroma_h;
-            r = gf->chroma_r;
-        }
+    for (nb_planes = 0; nb_planes < 4 && in->data[nb_planes]; nb_planes++);
 
-        if (FFMIN(w, h) > 2 * r)
-            filter(gf, out->data[p], in->data[p], w, h, out->linesize[p], in->linesize[p], r);
-        else if (out->data[p] != in->data[p])
-            av_image_copy_plane(out->data[p], out->linesize[p], in->data[p], in->linesize[p], w, h);
-    }
+    td.in  = in;
+    td.out = out;
+    inlink->dst->internal->execute(inlink->dst, filter_plane, &td, NULL, nb_planes);
 
     if (!direct)
         av_frame_free(&in);
@@ -255,4 +284,6 @@ AVFilter avfilter_vf_gradfun = {
 
     .inputs    = avfilter_vf_gradfun_inputs,
     .outputs   = avfilter_vf_gradfun_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_KEEP_PTS,
 };
@@ -30,6 +30,7 @@
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
+#include "libavutil/common.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -84,6 +85,52 @@ static int config_props(AVFilterLink *inlink)
     return 0;
 }
 
+/**
+ * Mirror a line by swapping the pixels from both ends.
+ */
+static void flip_line_inplace(uint8_t *line, int w, int step)
+{
+    uint8_t *left  = line;
+    uint8_t *right = line + (w - 1) * step;
+    int j, k;
+
+    switch (step) {
+    case 1:
+        for (j = 0; j < w / 2; j++)
+            FFSWAP(uint8_t, line[j], line[w - 1 - j]);
+        break;
+
+    case 2:
+    {
+        uint16_t *line16 = (uint16_t *)line;
+        for (j = 0; j < w / 2; j++)
+            FFSWAP(uint16_t, line16[j], line16[w - 1 - j]);
+    }
+    break;
+
+    case 3:
+        for (j = 0; j < w / 2; j++, left += 3, right -= 3) {
+            int32_t v = AV_RB24(left);
+            AV_WB24(left, AV_RB24(right));
+            AV_WB24(right, v);
+        }
+        break;
+
+    case 4:
+    {
+        uint32_t *line32 = (uint32_t *)line;
+        for (j = 0; j < w / 2; j++)
+            FFSWAP(uint32_t, line32[j], line32[w - 1 - j]);
+    }
+    break;
+
+    default:
+        for (j = 0; j < w / 2; j++, left += step, right -= step)
+            for (k = 0; k < step; k++)
+                FFSWAP(uint8_t, left[k], right[k]);
+    }
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx  = inlink->dst;
@@ -93,18 +140,24 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     uint8_t *inrow, *outrow;
     int i, j, plane, step, hsub, vsub;
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    out = ff_get_writable_video_buffer(inlink, in, 0);
     if (!out) {
         av_frame_free(&in);
         return AVERROR(ENOMEM);
     }
-    av_frame_copy_props(out, in);
 
     for (plane = 0; plane < 4 && in->data[plane]; plane++) {
         step = flip->max_step[plane];
         hsub = (plane == 1 || plane == 2) ? flip->hsub : 0;
         vsub = (plane == 1 || plane == 2) ? flip->vsub : 0;
 
+        if (out == in) {
+            for (i = 0; i < in->height >> vsub; i++)
+                flip_line_inplace(in->data[plane] + i * in->linesize[plane],
+                                  inlink->w >> hsub, step);
+            continue;
+        }
+
         outrow = out->data[plane];
         inrow  = in ->data[plane] + ((inlink->w >> hsub) - 1) * step;
         for (i = 0; i < in->height >> vsub; i++) {
@@ -153,7 +206,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
     }
 
-    av_frame_free(&in);
+    if (out != in)
+        av_frame_free(&in);
     return ff_filter_frame(outlink, out);
 }
 
@@ -183,4 +237,5 @@ AVFilter avfilter_vf_hflip = {
 
     .inputs    = avfilter_vf_hflip_inputs,
     .outputs   = avfilter_vf_hflip_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
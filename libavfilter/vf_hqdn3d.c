@@ -243,7 +243,9 @@ static void uninit(AVFilterContext *ctx)
     av_freep(&hqdn3d->coefs[1]);
     av_freep(&hqdn3d->coefs[2]);
     av_freep(&hqdn3d->coefs[3]);
-    av_freep(&hqdn3d->line);
+    av_freep(&hqdn3d->line[0]);
+    av_freep(&hqdn3d->line[1]);
+    av_freep(&hqdn3d->line[2]);
     av_freep(&hqdn3d->frame_prev[0]);
     av_freep(&hqdn3d->frame_prev[1]);
     av_freep(&hqdn3d->frame_prev[2]);
@@ -289,11 +291,18 @@ static int config_input(AVFilterLink *inlink)
     hqdn3d->vsub  = desc->log2_chroma_h;
     hqdn3d->depth = desc->comp[0].depth_minus1+1;
 
-    hqdn3d->line = av_malloc(inlink->w * sizeof(*hqdn3d->line));
-    if (!hqdn3d->line)
-        return AVERROR(ENOMEM);
+    /* one line buffer per plane, so that the planes can be denoised in
+       parallel */
+    for (i = 0; i < 3; i++) {
+        av_freep(&hqdn3d->line[i]);
+        av_freep(&hqdn3d->frame_prev[i]);
+        hqdn3d->line[i] = av_malloc(inlink->w * sizeof(*hqdn3d->line[i]));
+        if (!hqdn3d->line[i])
+            return AVERROR(ENOMEM);
+    }
 
     for (i = 0; i < 4; i++) {
+        av_freep(&hqdn3d->coefs[i]);
         hqdn3d->coefs[i] = precalc_coefs(hqdn3d->strength[i], hqdn3d->depth);
         if (!hqdn3d->coefs[i])
             return AVERROR(ENOMEM);
@@ -305,12 +314,34 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int denoise_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HQDN3DContext *hqdn3d = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int c = jobnr;
+
+    denoise(hqdn3d, in->data[c], out->data[c],
+            hqdn3d->line[c], &hqdn3d->frame_prev[c],
+            in->width  >> (!!c * hqdn3d->hsub),
+            in->height >> (!!c * hqdn3d->vsub),
+            in->linesize[c], out->linesize[c],
+            hqdn3d->coefs[c?2:0], hqdn3d->coefs[c?3:1]);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    HQDN3DContext *hqdn3d = inlink->dst->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    ThreadData td;
     AVFrame *out;
-    int direct, c;
+    int direct;
 
     if (av_frame_is_writable(in)) {
         direct = 1;
@@ -328,14 +359,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         out->height = outlink->h;
     }
 
-    for (c = 0; c < 3; c++) {
-        denoise(hqdn3d, in->data[c], out->data[c],
-                hqdn3d->line, &hqdn3d->frame_prev[c],
-                in->width  >> (!!c * hqdn3d->hsub),
-                in->height >> (!!c * hqdn3d->vsub),
-                in->linesize[c], out->linesize[c],
-                hqdn3d->coefs[c?2:0], hqdn3d->coefs[c?3:1]);
-    }
+    /* the filter is recursive within a plane, so only the planes are
+       processed in parallel */
+    td.in  = in;
+    td.out = out;
+    inlink->dst->internal->execute(inlink->dst, denoise_plane, &td, NULL, 3);
 
     if (!direct)
         av_frame_free(&in);
@@ -373,4 +401,6 @@ AVFilter avfilter_vf_hqdn3d = {
     .inputs    = avfilter_vf_hqdn3d_inputs,
 
     .outputs   = avfilter_vf_hqdn3d_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -304,12 +304,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     uint8_t *inrow, *outrow, *inrow0, *outrow0;
     int i, j, k, plane;
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    out = ff_get_writable_video_buffer(inlink, in, 0);
     if (!out) {
         av_frame_free(&in);
         return AVERROR(ENOMEM);
     }
-    av_frame_copy_props(out, in);
 
     if (lut->is_rgb) {
         /* packed */
@@ -346,7 +345,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
     }
 
-    av_frame_free(&in);
+    if (out != in)
+        av_frame_free(&in);
     return ff_filter_frame(outlink, out);
 }
 
@@ -375,6 +375,7 @@ static const AVFilterPad outputs[] = {
                                                                         \
         .inputs        = inputs,                                        \
         .outputs       = outputs,                                       \
+        .flags         = AVFILTER_FLAG_KEEP_PTS,                        \
     }
 
 #if CONFIG_LUT_FILTER
@@ -445,4 +445,5 @@ AVFilter avfilter_vf_pad = {
     .inputs    = avfilter_vf_pad_inputs,
 
     .outputs   = avfilter_vf_pad_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS,
 };
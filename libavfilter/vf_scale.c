@@ -31,9 +31,11 @@
 #include "internal.h"
 #include "video.h"
 #include "libavutil/avstring.h"
+#include "libavutil/common.h"
 #include "libavutil/eval.h"
 #include "libavutil/internal.h"
 #include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libswscale/swscale.h"
@@ -71,6 +73,15 @@ enum var_name {
 typedef struct {
     struct SwsContext *sws;     ///< software scaler context
 
+    /**
+     * Scaler contexts used by slice threading, one per band of rows.
+     * Only set up when the output rows depend on the same input rows
+     * only, so that bands can be converted independently.
+     */
+    struct SwsContext **slice_sws;
+    int nb_slices;
+    int slice_h;                ///< height of every band but the last one
+
     /**
      * New dimensions. Special values are:
      *   0 = original width/height
@@ -113,11 +124,71 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
     return 0;
 }
 
+static void free_slice_contexts(ScaleContext *scale)
+{
+    int i;
+
+    for (i = 0; i < scale->nb_slices; i++)
+        sws_freeContext(scale->slice_sws[i]);
+    av_freep(&scale->slice_sws);
+    scale->nb_slices = 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ScaleContext *scale = ctx->priv;
     sws_freeContext(scale->sws);
     scale->sws = NULL;
+    free_slice_contexts(scale);
+}
+
+/**
+ * Set up one scaler per band of rows if the conversion can be split.
+ * The bands are aligned to the 8 lines period of the ordered dither,
+ * which is also a multiple of any vertical chroma subsampling.
+ * libswscale converts the last two lines of a picture with the C output
+ * functions, so the bands are not used when bitexact output is requested.
+ */
+static int init_slice_contexts(AVFilterContext *ctx, AVFilterLink *inlink,
+                               AVFilterLink *outlink)
+{
+    ScaleContext *scale = ctx->priv;
+    const AVPixFmtDescriptor *idesc = av_pix_fmt_desc_get(inlink->format);
+    const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
+    int nb_threads = ff_filter_get_nb_threads(ctx);
+    int h = outlink->h, i;
+
+    free_slice_contexts(scale);
+
+    if (nb_threads <= 1 || !scale->sws || scale->flags & SWS_BITEXACT ||
+        inlink->h != outlink->h                                       ||
+        idesc->log2_chroma_h != odesc->log2_chroma_h                  ||
+        (idesc->flags | odesc->flags) & (PIX_FMT_PAL | PIX_FMT_PSEUDOPAL |
+                                         PIX_FMT_BITSTREAM))
+        return 0;
+
+    scale->slice_h = FFALIGN((h + nb_threads - 1) / nb_threads, 8);
+    if (scale->slice_h >= h)
+        return 0;
+
+    scale->slice_sws = av_mallocz(sizeof(*scale->slice_sws) * nb_threads);
+    if (!scale->slice_sws)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i * scale->slice_h < h; i++) {
+        int slice_h = FFMIN(scale->slice_h, h - i * scale->slice_h);
+
+        scale->nb_slices++;
+        scale->slice_sws[i] = sws_getContext(inlink ->w, slice_h, inlink ->format,
+                                             outlink->w, slice_h, outlink->format,
+                                             scale->flags, NULL, NULL, NULL);
+        if (!scale->slice_sws[i]) {
+            free_slice_contexts(scale);
+            return AVERROR(EINVAL);
+        }
+    }
+
+    return 0;
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -240,7 +311,8 @@ static int config_props(AVFilterLink *outlink)
         if (!scale->sws)
             return AVERROR(EINVAL);
     }
-
+    if ((ret = init_slice_contexts(ctx, inlink, outlink)) < 0)
+        return ret;
 
     if (inlink->sample_aspect_ratio.num)
         outlink->sample_aspect_ratio = av_mul_q((AVRational){outlink->h*inlink->w,
@@ -257,6 +329,36 @@ fail:
     return ret;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int scale_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleContext *scale = ctx->priv;
+    ThreadData *td = arg;
+    const AVPixFmtDescriptor *idesc = av_pix_fmt_desc_get(td->in ->format);
+    const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(td->out->format);
+    const uint8_t *src[4] = { NULL };
+    uint8_t *dst[4] = { NULL };
+    int y = jobnr * scale->slice_h;
+    int i;
+
+    for (i = 0; i < 4 && td->in->data[i]; i++) {
+        int vsub = (i == 1 || i == 2) ? idesc->log2_chroma_h : 0;
+        src[i] = td->in->data[i] + (y >> vsub) * td->in->linesize[i];
+    }
+    for (i = 0; i < 4 && td->out->data[i]; i++) {
+        int vsub = (i == 1 || i == 2) ? odesc->log2_chroma_h : 0;
+        dst[i] = td->out->data[i] + (y >> vsub) * td->out->linesize[i];
+    }
+
+    sws_scale(scale->slice_sws[jobnr], src, td->in->linesize,
+              0, FFMIN(scale->slice_h, td->out->height - y),
+              dst, td->out->linesize);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     ScaleContext *scale = link->dst->priv;
@@ -285,8 +387,13 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    sws_scale(scale->sws, in->data, in->linesize, 0, in->height,
-              out->data, out->linesize);
+    if (scale->nb_slices > 1) {
+        ThreadData td = { .in = in, .out = out };
+        link->dst->internal->execute(link->dst, scale_slice, &td, NULL,
+                                     scale->nb_slices);
+    } else
+        sws_scale(scale->sws, in->data, in->linesize, 0, in->height,
+                  out->data, out->linesize);
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
@@ -323,4 +430,7 @@ AVFilter avfilter_vf_scale = {
 
     .inputs    = avfilter_vf_scale_inputs,
     .outputs   = avfilter_vf_scale_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_KEEP_PTS |
+                 AVFILTER_FLAG_RECONFIG,
 };
@@ -225,6 +225,10 @@ static int select_frame(AVFilterContext *ctx, AVFrame *frame)
     return res;
 }
 
+/* No min_pts hint is set: the selection may depend on properties that are
+ * only known once the frame is decoded (pict_type, key, scene) and the
+ * expression need not be monotonic in time, so no timestamp below which all
+ * the frames are dropped can be derived from it. */
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     SelectContext *select = inlink->dst->priv;
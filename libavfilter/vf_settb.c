@@ -153,4 +153,5 @@ AVFilter avfilter_vf_settb = {
     .inputs    = avfilter_vf_settb_inputs,
 
     .outputs   = avfilter_vf_settb_outputs,
+    .flags     = AVFILTER_FLAG_RECONFIG,
 };
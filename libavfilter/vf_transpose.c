@@ -227,4 +227,5 @@ AVFilter avfilter_vf_transpose = {
 
     .inputs    = avfilter_vf_transpose_inputs,
     .outputs   = avfilter_vf_transpose_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
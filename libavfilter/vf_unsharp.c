@@ -58,20 +58,24 @@ typedef struct FilterParam {
     int steps_y;                             ///< vertical step count
     int scalebits;                           ///< bits to shift pixel
     int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[(MAX_SIZE * MAX_SIZE) - 1]; ///< finite state machine storage
 } FilterParam;
 
 typedef struct {
     FilterParam luma;   ///< luma parameters (width, height, amount)
     FilterParam chroma; ///< chroma parameters (width, height, amount)
     int hsub, vsub;
+    /**
+     * finite state machine storage, one per plane so that the planes
+     * can be filtered concurrently
+     */
+    uint32_t *sc[3][(MAX_SIZE * MAX_SIZE) - 1];
 } UnsharpContext;
 
 static void apply_unsharp(      uint8_t *dst, int dst_stride,
                           const uint8_t *src, int src_stride,
-                          int width, int height, FilterParam *fp)
+                          int width, int height, FilterParam *fp,
+                          uint32_t **sc)
 {
-    uint32_t **sc = fp->sc;
     uint32_t sr[(MAX_SIZE * MAX_SIZE) - 1], tmp1, tmp2;
 
     int32_t res;
@@ -170,57 +174,92 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type, int width)
+static void log_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type)
 {
-    int z;
     const char *effect;
 
     effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
+}
+
+static int alloc_state(FilterParam *fp, uint32_t **sc, int width)
+{
+    int z;
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + 2 * fp->steps_x));
+    for (z = 0; z < 2 * fp->steps_y; z++) {
+        av_freep(&sc[z]);
+        sc[z] = av_malloc(sizeof(*(sc[z])) * (width + 2 * fp->steps_x));
+        if (!sc[z])
+            return AVERROR(ENOMEM);
+    }
+    return 0;
 }
 
 static int config_props(AVFilterLink *link)
 {
     UnsharpContext *unsharp = link->dst->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+    int cw = SHIFTUP(link->w, desc->log2_chroma_w);
+    int ret;
 
     unsharp->hsub = desc->log2_chroma_w;
     unsharp->vsub = desc->log2_chroma_h;
 
-    init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w);
-    init_filter_param(link->dst, &unsharp->chroma, "chroma", SHIFTUP(link->w, unsharp->hsub));
+    log_filter_param(link->dst, &unsharp->luma,   "luma");
+    log_filter_param(link->dst, &unsharp->chroma, "chroma");
+
+    if ((ret = alloc_state(&unsharp->luma,   unsharp->sc[0], link->w)) < 0 ||
+        (ret = alloc_state(&unsharp->chroma, unsharp->sc[1], cw))      < 0 ||
+        (ret = alloc_state(&unsharp->chroma, unsharp->sc[2], cw))      < 0)
+        return ret;
 
     return 0;
 }
 
-static void free_filter_param(FilterParam *fp)
+static av_cold void uninit(AVFilterContext *ctx)
 {
-    int z;
+    UnsharpContext *unsharp = ctx->priv;
+    int i, z;
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        av_free(fp->sc[z]);
+    for (i = 0; i < FF_ARRAY_ELEMS(unsharp->sc); i++)
+        for (z = 0; z < FF_ARRAY_ELEMS(unsharp->sc[i]); z++)
+            av_freep(&unsharp->sc[i][z]);
 }
 
-static av_cold void uninit(AVFilterContext *ctx)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[3], h[3];
+} ThreadData;
+
+/* the state machine is recursive in both directions, so each plane
+   is a job on its own */
+static int unsharp_plane(AVFilterContext *ctx, void *arg, int plane, int nb_jobs)
 {
     UnsharpContext *unsharp = ctx->priv;
+    ThreadData *td = arg;
 
-    free_filter_param(&unsharp->luma);
-    free_filter_param(&unsharp->chroma);
+    apply_unsharp(td->out->data[plane], td->out->linesize[plane],
+                  td->in ->data[plane], td->in ->linesize[plane],
+                  td->w[plane], td->h[plane],
+                  plane ? &unsharp->chroma : &unsharp->luma, unsharp->sc[plane]);
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
-    UnsharpContext *unsharp = link->dst->priv;
-    AVFilterLink *outlink   = link->dst->outputs[0];
+    AVFilterContext *ctx    = link->dst;
+    UnsharpContext *unsharp = ctx->priv;
+    AVFilterLink *outlink   = ctx->outputs[0];
     AVFrame *out;
     int cw = SHIFTUP(link->w, unsharp->hsub);
     int ch = SHIFTUP(link->h, unsharp->vsub);
+    ThreadData td = {
+        .in = in,
+        .w  = { link->w, cw, cw },
+        .h  = { link->h, ch, ch },
+    };
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -228,10 +267,9 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         return AVERROR(ENOMEM);
     }
     av_frame_copy_props(out, in);
+    td.out = out;
 
-    apply_unsharp(out->data[0], out->linesize[0], in->data[0], in->linesize[0], link->w, link->h, &unsharp->luma);
-    apply_unsharp(out->data[1], out->linesize[1], in->data[1], in->linesize[1], cw,      ch,      &unsharp->chroma);
-    apply_unsharp(out->data[2], out->linesize[2], in->data[2], in->linesize[2], cw,      ch,      &unsharp->chroma);
+    ctx->internal->execute(ctx, unsharp_plane, &td, NULL, 3);
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
@@ -268,4 +306,6 @@ AVFilter avfilter_vf_unsharp = {
     .inputs    = avfilter_vf_unsharp_inputs,
 
     .outputs   = avfilter_vf_unsharp_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_KEEP_PTS,
 };
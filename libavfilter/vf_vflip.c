@@ -108,4 +108,5 @@ AVFilter avfilter_vf_vflip = {
 
     .inputs    = avfilter_vf_vflip_inputs,
     .outputs   = avfilter_vf_vflip_outputs,
+    .flags     = AVFILTER_FLAG_KEEP_PTS | AVFILTER_FLAG_RECONFIG,
 };
@@ -20,26 +20,114 @@
 #include <stdio.h>
 
 #include "libavutil/buffer.h"
+#include "libavutil/common.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
 #include "internal.h"
 #include "video.h"
 
+static AVFrame *get_video_buffer(AVFilterLink *link, int w, int h)
+{
+    AVFrame *ret = NULL;
+
+    av_unused char buf[16];
+    FF_DPRINTF_START(NULL, get_video_buffer); ff_dlog_link(NULL, link, 0);
+
+    if (link->dstpad->get_video_buffer)
+        ret = link->dstpad->get_video_buffer(link, w, h);
+
+    if (!ret)
+        ret = ff_default_get_video_buffer(link, w, h);
+
+    return ret;
+}
+
 AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
 {
-    return ff_get_video_buffer(link->dst->outputs[0], w, h);
+    return get_video_buffer(link->dst->outputs[0], w, h);
+}
+
+/**
+ * (Re)create the pools of the link for frames with the given parameters.
+ * The planes are laid out the same way as av_frame_get_buffer() does.
+ */
+static int update_frame_pool(AVFilterLink *link, int w, int h)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+    FFFramePool *pool = link->frame_pool;
+    AVFilterGraph *graph = link->dst->graph;
+    int i, ret, flags;
+
+    if (pool && pool->format == link->format &&
+        pool->width == w && pool->height == h)
+        return 0;
+
+    if (!desc)
+        return AVERROR(EINVAL);
+    if ((ret = av_image_check_size(w, h, 0, link)) < 0)
+        return ret;
+
+    if (!pool) {
+        pool = link->frame_pool = av_mallocz(sizeof(*pool));
+        if (!pool)
+            return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < 4; i++)
+        av_buffer_pool_uninit(&pool->pools[i]);
+    pool->format = -1;
+
+    memset(pool->linesize, 0, sizeof(pool->linesize));
+    if ((ret = av_image_fill_linesizes(pool->linesize, link->format, w)) < 0)
+        return ret;
+
+    flags = graph && graph->huge_pages ? AV_BUFFER_POOL_FLAG_HUGE_PAGES : 0;
+    for (i = 0; i < 4 && pool->linesize[i]; i++) {
+        int plane_h = h;
+
+        pool->linesize[i] = FFALIGN(pool->linesize[i], 32);
+        if (i == 1 || i == 2)
+            plane_h = -((-h) >> desc->log2_chroma_h);
+
+        pool->pools[i] = av_buffer_pool_init2(pool->linesize[i] * plane_h, NULL,
+                                              flags, 0);
+        if (!pool->pools[i])
+            goto fail;
+    }
+    if (desc->flags & PIX_FMT_PAL || desc->flags & PIX_FMT_PSEUDOPAL) {
+        pool->pools[1] = av_buffer_pool_init(1024, NULL);
+        if (!pool->pools[1])
+            goto fail;
+    }
+
+    pool->format = link->format;
+    pool->width  = w;
+    pool->height = h;
+
+    return 0;
+fail:
+    for (i = 0; i < 4; i++)
+        av_buffer_pool_uninit(&pool->pools[i]);
+    return AVERROR(ENOMEM);
 }
 
-/* TODO: set the buffer's priv member to a context structure for the whole
- * filter chain.  This will allow for a buffer pool instead of the constant
- * alloc & free cycle currently implemented. */
 AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 {
-    AVFrame *frame = av_frame_alloc();
-    int ret;
+    FFFramePool *pool;
+    AVFrame *frame;
+    int i, ret;
+    MEM_TAG_START(pool, "lavfi:frame pool");
+
+    ret = update_frame_pool(link, w, h);
+    MEM_TAG_STOP(pool);
+    if (ret < 0)
+        return NULL;
+    pool = link->frame_pool;
 
+    frame = av_frame_alloc();
     if (!frame)
         return NULL;
 
@@ -47,11 +135,43 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     frame->height = h;
     frame->format = link->format;
 
-    ret = av_frame_get_buffer(frame, 32);
-    if (ret < 0)
-        av_frame_free(&frame);
+    for (i = 0; i < 4 && pool->pools[i]; i++) {
+        frame->buf[i] = av_buffer_pool_get(pool->pools[i]);
+        if (!frame->buf[i])
+            goto fail;
+
+        frame->data[i]     = frame->buf[i]->data;
+        frame->linesize[i] = pool->linesize[i];
+    }
+    frame->extended_data = frame->data;
 
     return frame;
+fail:
+    av_frame_free(&frame);
+    return NULL;
+}
+
+AVFrame *ff_get_writable_video_buffer(AVFilterLink *link, AVFrame *in,
+                                      int copy_data)
+{
+    AVFrame *out;
+
+    if (av_frame_is_writable(in)) {
+        link->frame_count_inplace++;
+        return in;
+    }
+    link->frame_count_copied++;
+
+    out = ff_get_video_buffer(link, link->w, link->h);
+    if (!out)
+        return NULL;
+    av_frame_copy_props(out, in);
+
+    if (copy_data)
+        av_image_copy(out->data, out->linesize, in->data, in->linesize,
+                      in->format, in->width, in->height);
+
+    return out;
 }
 
 #if FF_API_AVFILTERBUFFER
@@ -103,16 +223,13 @@ fail:
 
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h)
 {
-    AVFrame *ret = NULL;
-
-    av_unused char buf[16];
-    FF_DPRINTF_START(NULL, get_video_buffer); ff_dlog_link(NULL, link, 0);
+    AVFrame *ret = get_video_buffer(link, w, h);
+    int i;
 
-    if (link->dstpad->get_video_buffer)
-        ret = link->dstpad->get_video_buffer(link, w, h);
-
-    if (!ret)
-        ret = ff_default_get_video_buffer(link, w, h);
+    /* account the buffers to the filter requesting them, not to the one
+     * passing the request on */
+    for (i = 0; ret && i < FF_ARRAY_ELEMS(ret->buf) && ret->buf[i]; i++)
+        link->stats.bytes_allocated += ret->buf[i]->size;
 
     return ret;
 }
@@ -36,4 +36,19 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h);
  */
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h);
 
+/**
+ * Get a frame a filter can write its output for the given input frame to.
+ * The input frame itself is returned if it is writable, otherwise a new
+ * buffer is requested from link and the properties of the input frame are
+ * copied to it.
+ *
+ * @param link      the input link the frame was received on
+ * @param in        the input frame
+ * @param copy_data copy the data of the input frame to the new buffer, for
+ *                  filters which only modify part of the frame
+ * @return in, a new frame, or NULL on error; in is never freed
+ */
+AVFrame *ff_get_writable_video_buffer(AVFilterLink *link, AVFrame *in,
+                                      int copy_data);
+
 #endif /* AVFILTER_VIDEO_H */
@@ -36,6 +36,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/time.h"
+#include "libavutil/timer.h"
 #include "riff.h"
 #include "audiointerleave.h"
 #include "url.h"
@@ -394,6 +395,7 @@ static int compute_pkt_fields2(AVFormatContext *s, AVStream *st, AVPacket *pkt)
 int av_write_frame(AVFormatContext *s, AVPacket *pkt)
 {
     int ret;
+    PROBE_START(mux);
 
     if (!pkt) {
         if (s->oformat->flags & AVFMT_ALLOW_FLUSH)
@@ -410,6 +412,7 @@ int av_write_frame(AVFormatContext *s, AVPacket *pkt)
 
     if (ret >= 0)
         s->streams[pkt->stream_index]->nb_frames++;
+    PROBE_STOP(mux, "av_write_frame");
     return ret;
 }
 
@@ -417,8 +420,10 @@ void ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
                               int (*compare)(AVFormatContext *, AVPacket *, AVPacket *))
 {
     AVPacketList **next_point, *this_pktl;
+    MEM_TAG_START(queue, "lavf:packet queue");
 
     this_pktl      = av_mallocz(sizeof(AVPacketList));
+    MEM_TAG_STOP(queue);
     this_pktl->pkt = *pkt;
 #if FF_API_DESTRUCT_PACKET
     pkt->destruct  = NULL;           // do not free original but only the copy
@@ -541,12 +546,14 @@ int av_interleaved_write_frame(AVFormatContext *s, AVPacket *pkt)
     for (;; ) {
         AVPacket opkt;
         int ret = interleave_packet(s, &opkt, pkt, flush);
+        PROBE_START(mux);
         if (ret <= 0) //FIXME cleanup needed for ret<0 ?
             return ret;
 
         ret = s->oformat->write_packet(s, &opkt);
         if (ret >= 0)
             s->streams[opkt.stream_index]->nb_frames++;
+        PROBE_STOP(mux, "av_interleaved_write_frame");
 
         av_free_packet(&opkt);
         pkt = NULL;
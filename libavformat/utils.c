@@ -449,7 +449,11 @@ static int init_input(AVFormatContext *s, const char *filename, AVDictionary **o
 
 static AVPacket *add_to_pktbuf(AVPacketList **packet_buffer, AVPacket *pkt,
                                AVPacketList **plast_pktl){
-    AVPacketList *pktl = av_mallocz(sizeof(AVPacketList));
+    AVPacketList *pktl;
+    MEM_TAG_START(queue, "lavf:packet queue");
+
+    pktl = av_mallocz(sizeof(AVPacketList));
+    MEM_TAG_STOP(queue);
     if (!pktl)
         return NULL;
 
@@ -1355,14 +1359,18 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
 {
     AVIndexEntry *entries, *ie;
     int index;
+    MEM_TAG_START(index, "lavf:index");
 
-    if((unsigned)*nb_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry))
+    if((unsigned)*nb_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry)) {
+        MEM_TAG_STOP(index);
         return -1;
+    }
 
     entries = av_fast_realloc(*index_entries,
                               index_entries_allocated_size,
                               (*nb_index_entries + 1) *
                               sizeof(AVIndexEntry));
+    MEM_TAG_STOP(index);
     if(!entries)
         return -1;
 
@@ -19,6 +19,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 #include "libavutil/common.h"
 #include "libavutil/libm.h"
@@ -27,6 +28,7 @@
 #include "internal.h"
 #include "audio_data.h"
 #include "audio_mix.h"
+#include "thread.h"
 
 static const char *coeff_type_names[] = { "q8", "q15", "flt" };
 
@@ -98,28 +100,48 @@ void ff_audio_mix_set_func(AudioMix *am, enum AVSampleFormat fmt,
 
 #define MIX_FUNC_NAME(fmt, cfmt) mix_any_ ## fmt ##_## cfmt ##_c
 
+/* number of samples processed per block in the any-to-any functions */
+#define MIX_BLOCK_SIZE 64
+
+/* The samples are mixed in blocks, one output channel at a time, so that the
+ * innermost loop is a multiply-accumulate over contiguous samples which the
+ * compiler can vectorize. Zero matrix coefficients are skipped, which avoids
+ * most of the work for sparse matrices such as remaps with gains. The sum for
+ * each output sample is accumulated in input channel order, so the result is
+ * the same as a straightforward per-sample loop. */
 #define MIX_FUNC_GENERIC(fmt, cfmt, stype, ctype, sumtype, expr)            \
 static void MIX_FUNC_NAME(fmt, cfmt)(stype **samples, ctype **matrix,       \
                                      int len, int out_ch, int in_ch)        \
 {                                                                           \
-    int i, in, out;                                                         \
-    stype temp[AVRESAMPLE_MAX_CHANNELS];                                    \
-    for (i = 0; i < len; i++) {                                             \
+    int i, in, out, offset;                                                 \
+    stype temp[AVRESAMPLE_MAX_CHANNELS][MIX_BLOCK_SIZE];                    \
+    sumtype sum[MIX_BLOCK_SIZE];                                            \
+    for (offset = 0; offset < len; offset += MIX_BLOCK_SIZE) {              \
+        int nb_samples = FFMIN(len - offset, MIX_BLOCK_SIZE);               \
         for (out = 0; out < out_ch; out++) {                                \
-            sumtype sum = 0;                                                \
-            for (in = 0; in < in_ch; in++)                                  \
-                sum += samples[in][i] * matrix[out][in];                    \
-            temp[out] = expr;                                               \
+            for (i = 0; i < nb_samples; i++)                                \
+                sum[i] = 0;                                                 \
+            for (in = 0; in < in_ch; in++) {                                \
+                const stype *src = samples[in] + offset;                    \
+                const ctype m    = matrix[out][in];                         \
+                if (!m)                                                     \
+                    continue;                                               \
+                for (i = 0; i < nb_samples; i++)                            \
+                    sum[i] += src[i] * m;                                   \
+            }                                                               \
+            for (i = 0; i < nb_samples; i++)                                \
+                temp[out][i] = expr;                                        \
         }                                                                   \
         for (out = 0; out < out_ch; out++)                                  \
-            samples[out][i] = temp[out];                                    \
+            memcpy(samples[out] + offset, temp[out],                        \
+                   nb_samples * sizeof(stype));                             \
     }                                                                       \
 }
 
-MIX_FUNC_GENERIC(FLTP, FLT, float,   float,   float,   sum)
-MIX_FUNC_GENERIC(S16P, FLT, int16_t, float,   float,   av_clip_int16(lrintf(sum)))
-MIX_FUNC_GENERIC(S16P, Q15, int16_t, int32_t, int64_t, av_clip_int16(sum >> 15))
-MIX_FUNC_GENERIC(S16P, Q8,  int16_t, int16_t, int32_t, av_clip_int16(sum >>  8))
+MIX_FUNC_GENERIC(FLTP, FLT, float,   float,   float,   sum[i])
+MIX_FUNC_GENERIC(S16P, FLT, int16_t, float,   float,   av_clip_int16(lrintf(sum[i])))
+MIX_FUNC_GENERIC(S16P, Q15, int16_t, int32_t, int64_t, av_clip_int16(sum[i] >> 15))
+MIX_FUNC_GENERIC(S16P, Q8,  int16_t, int16_t, int32_t, av_clip_int16(sum[i] >>  8))
 
 /* TODO: templatize the channel-specific C functions */
 
@@ -425,6 +447,34 @@ void ff_audio_mix_free(AudioMix **am_p)
     av_freep(am_p);
 }
 
+/* number of samples mixed by each job when mixing in parallel */
+#define MIX_JOB_SAMPLES 1024
+
+typedef struct MixThreadArg {
+    AudioMix *am;
+    uint8_t **data;
+    mix_func *mix;
+    int len;
+    int bps;
+} MixThreadArg;
+
+static int mix_samples(void *arg, int job)
+{
+    MixThreadArg *t = arg;
+    AudioMix *am    = t->am;
+    uint8_t *data[AVRESAMPLE_MAX_CHANNELS];
+    int offset = job * MIX_JOB_SAMPLES;
+    int len    = FFMIN(t->len - offset, MIX_JOB_SAMPLES);
+    int ch;
+
+    for (ch = 0; ch < FFMAX(am->in_matrix_channels, am->out_matrix_channels); ch++)
+        data[ch] = t->data[ch] + offset * t->bps;
+
+    t->mix(data, am->matrix, len, am->out_matrix_channels,
+           am->in_matrix_channels);
+    return 0;
+}
+
 int ff_audio_mix(AudioMix *am, AudioData *src)
 {
     int use_generic = 1;
@@ -461,12 +511,24 @@ int ff_audio_mix(AudioMix *am, AudioData *src)
             data = src->data;
         }
 
-        if (use_generic)
+        if (am->avr->thread && len > MIX_JOB_SAMPLES) {
+            /* each output sample only depends on the input samples at the
+               same position, so the samples are split into ranges that are
+               mixed in parallel */
+            MixThreadArg arg = { am, data,
+                                 use_generic ? am->mix_generic : am->mix,
+                                 len, av_get_bytes_per_sample(am->fmt) };
+
+            ff_audio_thread_execute(am->avr, mix_samples, &arg,
+                                    (len + MIX_JOB_SAMPLES - 1) / MIX_JOB_SAMPLES,
+                                    MIX_JOB_SAMPLES * am->in_matrix_channels);
+        } else if (use_generic) {
             am->mix_generic(data, am->matrix, len, am->out_matrix_channels,
                             am->in_matrix_channels);
-        else
+        } else {
             am->mix(data, am->matrix, len, am->out_matrix_channels,
                     am->in_matrix_channels);
+        }
     }
 
     if (am->out_matrix_channels < am->out_channels) {
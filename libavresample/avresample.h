@@ -67,6 +67,12 @@
  * avresample_get_delay(). At the end of conversion the resampling buffer can be
  * flushed by calling avresample_convert() with NULL input.
  *
+ * The "threads" option sets the number of threads used for resampling and
+ * mixing; the channel planes are resampled in parallel and the mixing is split
+ * into ranges of samples. Calls converting fewer than "thread_threshold"
+ * samples over all channels are processed in the calling thread. The output
+ * does not depend on the number of threads.
+ *
  * The following code demonstrates the conversion loop assuming the parameters
  * from above and caller-defined functions get_input() and handle_output():
  * @code
@@ -31,6 +31,7 @@ typedef struct AudioData AudioData;
 typedef struct AudioConvert AudioConvert;
 typedef struct AudioMix AudioMix;
 typedef struct ResampleContext ResampleContext;
+typedef struct AudioThreadContext AudioThreadContext;
 
 enum RemapPoint {
     REMAP_NONE,
@@ -73,6 +74,8 @@ struct AVAudioResampleContext {
     enum AVResampleFilterType filter_type;      /**< resampling filter type */
     int kaiser_beta;                            /**< beta value for Kaiser window (only applicable if filter_type == AV_FILTER_TYPE_KAISER) */
     enum AVResampleDitherMethod dither_method;  /**< dither method          */
+    int threads;                                /**< number of threads used for resampling and mixing */
+    int thread_threshold;                       /**< minimum number of samples, summed over all channels, processed in a single call for threads to be used */
 
     int in_channels;        /**< number of input channels                   */
     int out_channels;       /**< number of output channels                  */
@@ -94,6 +97,7 @@ struct AVAudioResampleContext {
     AudioConvert *ac_out;       /**< output sample format conversion context */
     ResampleContext *resample;  /**< resampling context                      */
     AudioMix *am;               /**< channel mixing context                  */
+    AudioThreadContext *thread; /**< worker threads                          */
     enum AVMatrixEncoding matrix_encoding;      /**< matrixed stereo encoding */
 
     /**
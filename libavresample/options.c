@@ -81,6 +81,8 @@ static const AVOption options[] = {
         {"triangular",    "Triangular Dither",                    0, AV_OPT_TYPE_CONST, { .i64 = AV_RESAMPLE_DITHER_TRIANGULAR    }, INT_MIN, INT_MAX, PARAM, "dither_method"},
         {"triangular_hp", "Triangular Dither With High Pass",     0, AV_OPT_TYPE_CONST, { .i64 = AV_RESAMPLE_DITHER_TRIANGULAR_HP }, INT_MIN, INT_MAX, PARAM, "dither_method"},
         {"triangular_ns", "Triangular Dither With Noise Shaping", 0, AV_OPT_TYPE_CONST, { .i64 = AV_RESAMPLE_DITHER_TRIANGULAR_NS }, INT_MIN, INT_MAX, PARAM, "dither_method"},
+    { "threads",                "Number of Threads",        OFFSET(threads),                AV_OPT_TYPE_INT,    { .i64 = 1              }, 1,                    AVRESAMPLE_MAX_CHANNELS, PARAM },
+    { "thread_threshold",       "Minimum Samples Per Call For Threading", OFFSET(thread_threshold), AV_OPT_TYPE_INT, { .i64 = 16384    }, 0,                    INT_MAX,                PARAM },
     { NULL },
 };
 
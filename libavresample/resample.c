@@ -19,16 +19,62 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 #include "libavutil/common.h"
 #include "libavutil/libm.h"
 #include "libavutil/log.h"
+#include "libavutil/mathematics.h"
 #include "internal.h"
 #include "resample.h"
 #include "audio_data.h"
+#include "thread.h"
+
+/* maximum number of output samples in one period of the phase sequence for
+   which the periodic resampling path is used */
+#define MAX_PERIOD 1024
+
+/* maximum number of unused filter banks kept in the cache */
+#define MAX_CACHED_BANKS 8
+
+/**
+ * Shared polyphase filter bank.
+ *
+ * Filter banks only depend on the filter parameters and the internal sample
+ * format, so contexts with identical parameters share a single read-only
+ * copy instead of each building their own.
+ */
+typedef struct FilterBank {
+    int filter_length;
+    int phase_shift;
+    double factor;
+    enum AVResampleFilterType filter_type;
+    int kaiser_beta;
+    enum AVSampleFormat sample_fmt;
+    uint8_t *data;
+    int refcount;
+    struct FilterBank *next;
+} FilterBank;
+
+#if HAVE_PTHREADS
+static pthread_mutex_t bank_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_BANKS 1
+#define LOCK_CACHE()   pthread_mutex_lock(&bank_cache_lock)
+#define UNLOCK_CACHE() pthread_mutex_unlock(&bank_cache_lock)
+#else
+#define CACHE_BANKS !HAVE_THREADS
+#define LOCK_CACHE()
+#define UNLOCK_CACHE()
+#endif
+
+static FilterBank *bank_cache;
 
 struct ResampleContext {
     AVAudioResampleContext *avr;
     AudioData *buffer;
+    FilterBank *bank;
     uint8_t *filter_bank;
     int filter_length;
     int ideal_dst_incr;
@@ -47,6 +93,20 @@ struct ResampleContext {
     void (*resample_one)(struct ResampleContext *c, int no_filter, void *dst0,
                          int dst_index, const void *src0, int src_size,
                          int index, int frac);
+    int (*resample_periodic)(struct ResampleContext *c, void *dst0,
+                             const void *src0, int src_size, int dst_size,
+                             int *start, int *pos);
+
+    /* Periodic resampling. When the rate ratio is such that the phase
+       sequence repeats every period_size output samples, the source sample
+       offset, filter phase and index offset of each position in the period
+       are precomputed, relative to the start of the period. */
+    int period_size;
+    int period_advance;
+    int period_pos;
+    int *period_sample;
+    int *period_filter;
+    int *period_index;
 };
 
 
@@ -143,6 +203,140 @@ static int build_filter(ResampleContext *c)
     return 0;
 }
 
+static void release_filter_bank(FilterBank **bank)
+{
+    FilterBank **b;
+    int cached = 0;
+
+    if (!*bank)
+        return;
+
+    if (!CACHE_BANKS) {
+        av_free((*bank)->data);
+        av_freep(bank);
+        return;
+    }
+
+    LOCK_CACHE();
+    (*bank)->refcount--;
+    /* keep the most recently used unreferenced banks around */
+    for (b = &bank_cache; *b; ) {
+        FilterBank *cur = *b;
+        if (!cur->refcount && ++cached > MAX_CACHED_BANKS) {
+            *b = cur->next;
+            av_free(cur->data);
+            av_free(cur);
+        } else {
+            b = &cur->next;
+        }
+    }
+    UNLOCK_CACHE();
+    *bank = NULL;
+}
+
+static FilterBank *get_filter_bank(ResampleContext *c,
+                                   enum AVSampleFormat sample_fmt)
+{
+    FilterBank *bank, **b;
+    int phase_count = 1 << c->phase_shift;
+    int felem_size  = av_get_bytes_per_sample(sample_fmt);
+
+    LOCK_CACHE();
+    for (b = &bank_cache; CACHE_BANKS && *b; b = &(*b)->next) {
+        bank = *b;
+        if (bank->filter_length == c->filter_length &&
+            bank->phase_shift   == c->phase_shift   &&
+            bank->factor        == c->factor        &&
+            bank->filter_type   == c->filter_type   &&
+            bank->kaiser_beta   == c->kaiser_beta   &&
+            bank->sample_fmt    == sample_fmt) {
+            /* move to the front of the list */
+            *b         = bank->next;
+            bank->next = bank_cache;
+            bank_cache = bank;
+            bank->refcount++;
+            UNLOCK_CACHE();
+            return bank;
+        }
+    }
+
+    bank = av_mallocz(sizeof(*bank));
+    if (!bank)
+        goto fail;
+    bank->filter_length = c->filter_length;
+    bank->phase_shift   = c->phase_shift;
+    bank->factor        = c->factor;
+    bank->filter_type   = c->filter_type;
+    bank->kaiser_beta   = c->kaiser_beta;
+    bank->sample_fmt    = sample_fmt;
+    bank->refcount      = 1;
+
+    bank->data = av_mallocz(c->filter_length * (phase_count + 1) * felem_size);
+    if (!bank->data)
+        goto fail;
+    c->filter_bank = bank->data;
+
+    if (build_filter(c) < 0)
+        goto fail;
+
+    memcpy(&bank->data[(c->filter_length * phase_count + 1) * felem_size],
+           bank->data, (c->filter_length - 1) * felem_size);
+    memcpy(&bank->data[c->filter_length * phase_count * felem_size],
+           &bank->data[(c->filter_length - 1) * felem_size], felem_size);
+
+    if (CACHE_BANKS) {
+        bank->next = bank_cache;
+        bank_cache = bank;
+    }
+    UNLOCK_CACHE();
+    return bank;
+
+fail:
+    UNLOCK_CACHE();
+    if (bank)
+        av_free(bank->data);
+    av_free(bank);
+    c->filter_bank = NULL;
+    return NULL;
+}
+
+/* Precompute the phase sequence for rate ratios where it repeats after a
+   small number of output samples, e.g. 2:1, 1:2, 3:2 or 160:147. */
+static int init_period(ResampleContext *c)
+{
+    int phase_count = 1 << c->phase_shift;
+    int64_t size;
+    int i;
+
+    if (c->linear || (c->filter_length == 1 && c->phase_shift == 0))
+        return 0;
+
+    /* the fractional part returns to 0 every src_incr output samples and the
+       phase returns to 0 once the index has advanced by a multiple of
+       phase_count */
+    size = c->src_incr * (int64_t)phase_count /
+           av_gcd(c->dst_incr, phase_count);
+    if (size > MAX_PERIOD)
+        return 0;
+
+    c->period_index = av_malloc(3 * size * sizeof(*c->period_index));
+    if (!c->period_index)
+        return AVERROR(ENOMEM);
+    c->period_sample  = c->period_index  + size;
+    c->period_filter  = c->period_sample + size;
+    c->period_size    = size;
+    c->period_advance = size * c->dst_incr / c->src_incr;
+    c->period_pos     = 0;
+
+    for (i = 0; i < size; i++) {
+        int index = i * (int64_t)c->dst_incr / c->src_incr;
+        c->period_index[i]  = index;
+        c->period_sample[i] = index >> c->phase_shift;
+        c->period_filter[i] = c->filter_length * (index & c->phase_mask);
+    }
+    return 0;
+}
+
 ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
 {
     ResampleContext *c;
@@ -150,7 +344,6 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
     int in_rate     = avr->in_sample_rate;
     double factor   = FFMIN(out_rate * avr->cutoff / in_rate, 1.0);
     int phase_count = 1 << avr->phase_shift;
-    int felem_size;
 
     if (avr->internal_sample_fmt != AV_SAMPLE_FMT_S16P &&
         avr->internal_sample_fmt != AV_SAMPLE_FMT_S32P &&
@@ -176,35 +369,31 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
 
     switch (avr->internal_sample_fmt) {
     case AV_SAMPLE_FMT_DBLP:
-        c->resample_one  = resample_one_dbl;
-        c->set_filter    = set_filter_dbl;
+        c->resample_one      = resample_one_dbl;
+        c->resample_periodic = resample_periodic_dbl;
+        c->set_filter        = set_filter_dbl;
         break;
     case AV_SAMPLE_FMT_FLTP:
-        c->resample_one  = resample_one_flt;
-        c->set_filter    = set_filter_flt;
+        c->resample_one      = resample_one_flt;
+        c->resample_periodic = resample_periodic_flt;
+        c->set_filter        = set_filter_flt;
         break;
     case AV_SAMPLE_FMT_S32P:
-        c->resample_one  = resample_one_s32;
-        c->set_filter    = set_filter_s32;
+        c->resample_one      = resample_one_s32;
+        c->resample_periodic = resample_periodic_s32;
+        c->set_filter        = set_filter_s32;
         break;
     case AV_SAMPLE_FMT_S16P:
-        c->resample_one  = resample_one_s16;
-        c->set_filter    = set_filter_s16;
+        c->resample_one      = resample_one_s16;
+        c->resample_periodic = resample_periodic_s16;
+        c->set_filter        = set_filter_s16;
         break;
     }
 
-    felem_size = av_get_bytes_per_sample(avr->internal_sample_fmt);
-    c->filter_bank = av_mallocz(c->filter_length * (phase_count + 1) * felem_size);
-    if (!c->filter_bank)
-        goto error;
-
-    if (build_filter(c) < 0)
+    c->bank = get_filter_bank(c, avr->internal_sample_fmt);
+    if (!c->bank)
         goto error;
-
-    memcpy(&c->filter_bank[(c->filter_length * phase_count + 1) * felem_size],
-           c->filter_bank, (c->filter_length - 1) * felem_size);
-    memcpy(&c->filter_bank[c->filter_length * phase_count * felem_size],
-           &c->filter_bank[(c->filter_length - 1) * felem_size], felem_size);
+    c->filter_bank = c->bank->data;
 
     c->compensation_distance = 0;
     if (!av_reduce(&c->src_incr, &c->dst_incr, out_rate,
@@ -215,6 +404,9 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
     c->index = -phase_count * ((c->filter_length - 1) / 2);
     c->frac  = 0;
 
+    if (init_period(c) < 0)
+        goto error;
+
     /* allocate internal buffer */
     c->buffer = ff_audio_data_alloc(avr->resample_channels, 0,
                                     avr->internal_sample_fmt,
@@ -222,15 +414,17 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
     if (!c->buffer)
         goto error;
 
-    av_log(avr, AV_LOG_DEBUG, "resample: %s from %d Hz to %d Hz\n",
+    av_log(avr, AV_LOG_DEBUG, "resample: %s from %d Hz to %d Hz%s\n",
            av_get_sample_fmt_name(avr->internal_sample_fmt),
-           avr->in_sample_rate, avr->out_sample_rate);
+           avr->in_sample_rate, avr->out_sample_rate,
+           c->period_size ? " (periodic)" : "");
 
     return c;
 
 error:
     ff_audio_data_free(&c->buffer);
-    av_free(c->filter_bank);
+    release_filter_bank(&c->bank);
+    av_free(c->period_index);
     av_free(c);
     return NULL;
 }
@@ -240,7 +434,8 @@ void ff_audio_resample_free(ResampleContext **c)
     if (!*c)
         return;
     ff_audio_data_free(&(*c)->buffer);
-    av_free((*c)->filter_bank);
+    release_filter_bank(&(*c)->bank);
+    av_free((*c)->period_index);
     av_freep(c);
 }
 
@@ -317,6 +512,8 @@ int avresample_set_compensation(AVAudioResampleContext *avr, int sample_delta,
     c = avr->resample;
     c->compensation_distance = compensation_distance;
     if (compensation_distance) {
+        /* the phase sequence no longer follows the precomputed period */
+        c->period_size = 0;
         c->dst_incr = c->ideal_dst_incr - c->ideal_dst_incr *
                       (int64_t)sample_delta / compensation_distance;
     } else {
@@ -361,6 +558,14 @@ static int resample(ResampleContext *c, void *dst, const void *src,
         index += dst_index * dst_incr;
         index += (frac + dst_index * (int64_t)dst_incr_frac) / c->src_incr;
         frac   = (frac + dst_index * (int64_t)dst_incr_frac) % c->src_incr;
+    } else if (dst && c->period_size && compensation_distance == 0) {
+        int pos   = c->period_pos;
+        int start = index - c->period_index[pos];
+
+        dst_index = c->resample_periodic(c, dst, src, src_size, dst_size,
+                                         &start, &pos);
+        index = start + c->period_index[pos];
+        frac  = pos * (int64_t)c->dst_incr % c->src_incr;
     } else {
         for (dst_index = 0; dst_index < dst_size; dst_index++) {
             int sample_index = index >> c->phase_shift;
@@ -389,6 +594,8 @@ static int resample(ResampleContext *c, void *dst, const void *src,
         *consumed = FFMAX(index, 0) >> c->phase_shift;
 
     if (update_ctx) {
+        if (c->period_size)
+            c->period_pos = (c->period_pos + dst_index) % c->period_size;
         if (index >= 0)
             index &= c->phase_mask;
 
@@ -406,6 +613,27 @@ static int resample(ResampleContext *c, void *dst, const void *src,
     return dst_index;
 }
 
+typedef struct ResampleThreadArg {
+    ResampleContext *c;
+    AudioData *dst;
+    int out_samples;
+} ResampleThreadArg;
+
+static int resample_channel(void *arg, int ch)
+{
+    ResampleThreadArg *t = arg;
+    ResampleContext *c   = t->c;
+    int ret;
+
+    ret = resample(c, (void *)t->dst->data[ch],
+                   (const void *)c->buffer->data[ch], NULL,
+                   c->buffer->nb_samples, t->dst->allocated_samples, 0);
+    if (ret < 0)
+        return ret;
+    t->out_samples = ret;
+    return 0;
+}
+
 int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src)
 {
     int ch, in_samples, in_leftover, consumed = 0, out_samples = 0;
@@ -438,12 +666,25 @@ int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src)
         }
     }
 
-    /* resample each channel plane */
-    for (ch = 0; ch < c->buffer->channels; ch++) {
-        out_samples = resample(c, (void *)dst->data[ch],
-                               (const void *)c->buffer->data[ch], &consumed,
-                               c->buffer->nb_samples, dst->allocated_samples,
-                               ch + 1 == c->buffer->channels);
+    if (c->avr->thread) {
+        ResampleThreadArg arg = { c, dst, 0 };
+
+        /* resample the channel planes in parallel without touching the
+           context state, then advance the state with a dry run */
+        ret = ff_audio_thread_execute(c->avr, resample_channel, &arg,
+                                      c->buffer->channels,
+                                      c->buffer->nb_samples);
+        out_samples = ret < 0 ? ret :
+                      resample(c, NULL, NULL, &consumed, c->buffer->nb_samples,
+                               arg.out_samples, 1);
+    } else {
+        /* resample each channel plane */
+        for (ch = 0; ch < c->buffer->channels; ch++) {
+            out_samples = resample(c, (void *)dst->data[ch],
+                                   (const void *)c->buffer->data[ch], &consumed,
+                                   c->buffer->nb_samples, dst->allocated_samples,
+                                   ch + 1 == c->buffer->channels);
+        }
     }
     if (out_samples < 0) {
         av_log(c->avr, AV_LOG_ERROR, "error during resampling\n");
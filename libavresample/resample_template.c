@@ -84,6 +84,48 @@ static void SET_TYPE(resample_one)(ResampleContext *c, int no_filter,
     }
 }
 
+static int SET_TYPE(resample_periodic)(ResampleContext *c, void *dst0,
+                                      const void *src0, int src_size,
+                                      int dst_size, int *start, int *pos)
+{
+    FELEM *dst = dst0;
+    const FELEM *src = src0;
+    const FELEM *bank = (const FELEM *)c->filter_bank;
+    int filter_length = c->filter_length;
+    int start_sample  = *start >> c->phase_shift;
+    int p = *pos;
+    int dst_index, i;
+
+    for (dst_index = 0; dst_index < dst_size; dst_index++) {
+        int sample_index = start_sample + c->period_sample[p];
+
+        if (sample_index + filter_length > src_size ||
+            -sample_index >= src_size)
+            break;
+
+        if (sample_index < 0) {
+            SET_TYPE(resample_one)(c, 0, dst, dst_index, src, src_size,
+                                   *start + c->period_index[p], 0);
+        } else {
+            const FELEM *filter = bank + c->period_filter[p];
+            const FELEM *s      = src  + sample_index;
+            FELEM2 val = 0;
+            for (i = 0; i < filter_length; i++)
+                val += s[i] * (FELEM2)filter[i];
+            OUT(dst[dst_index], val);
+        }
+
+        if (++p == c->period_size) {
+            p             = 0;
+            *start       += c->period_advance;
+            start_sample  = *start >> c->phase_shift;
+        }
+    }
+    *pos = p;
+
+    return dst_index;
+}
+
 static void SET_TYPE(set_filter)(void *filter0, double *tab, int phase,
                                  int tap_count)
 {
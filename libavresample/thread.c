@@ -0,0 +1,218 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Worker threads for processing independent channels or sample ranges
+ * in parallel.
+ */
+
+#include "config.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "internal.h"
+#include "thread.h"
+
+#if HAVE_PTHREADS
+
+struct AudioThreadContext {
+    pthread_t *workers;
+    int nb_workers;
+
+    audio_thread_func *func;
+    void *arg;
+    int nb_jobs;
+    int next_job;
+    int jobs_done;
+    int ret;
+    int done;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+};
+
+/* run queued jobs until there are none left, must be called with the lock
+   held */
+static void run_jobs(AudioThreadContext *t)
+{
+    while (t->next_job < t->nb_jobs) {
+        int job = t->next_job++;
+        int ret;
+
+        pthread_mutex_unlock(&t->lock);
+        ret = t->func(t->arg, job);
+        pthread_mutex_lock(&t->lock);
+
+        if (ret < 0 && t->ret >= 0)
+            t->ret = ret;
+        if (++t->jobs_done == t->nb_jobs)
+            pthread_cond_signal(&t->done_cond);
+    }
+}
+
+static void *attribute_align_arg worker(void *arg)
+{
+    AudioThreadContext *t = arg;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        while (!t->done && t->next_job >= t->nb_jobs)
+            pthread_cond_wait(&t->job_cond, &t->lock);
+        if (t->done)
+            break;
+        run_jobs(t);
+    }
+    pthread_mutex_unlock(&t->lock);
+
+    return NULL;
+}
+
+int ff_audio_thread_init(AVAudioResampleContext *avr)
+{
+    AudioThreadContext *t;
+    int i, ret;
+
+    if (avr->threads <= 1)
+        return 0;
+
+    t = av_mallocz(sizeof(*t));
+    if (!t)
+        return AVERROR(ENOMEM);
+    t->workers = av_mallocz((avr->threads - 1) * sizeof(*t->workers));
+    if (!t->workers) {
+        av_free(t);
+        return AVERROR(ENOMEM);
+    }
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->job_cond, NULL);
+    pthread_cond_init(&t->done_cond, NULL);
+    avr->thread = t;
+
+    /* the calling thread runs jobs as well */
+    for (i = 0; i < avr->threads - 1; i++) {
+        ret = pthread_create(&t->workers[i], NULL, worker, t);
+        if (ret) {
+            av_log(avr, AV_LOG_ERROR, "error creating worker thread\n");
+            ff_audio_thread_free(avr);
+            return AVERROR(ret);
+        }
+        t->nb_workers++;
+    }
+
+    av_log(avr, AV_LOG_DEBUG, "using %d threads\n", avr->threads);
+    return 0;
+}
+
+void ff_audio_thread_free(AVAudioResampleContext *avr)
+{
+    AudioThreadContext *t = avr->thread;
+    int i;
+
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    t->done = 1;
+    pthread_cond_broadcast(&t->job_cond);
+    pthread_mutex_unlock(&t->lock);
+
+    for (i = 0; i < t->nb_workers; i++)
+        pthread_join(t->workers[i], NULL);
+
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->job_cond);
+    pthread_cond_destroy(&t->done_cond);
+    av_free(t->workers);
+    av_freep(&avr->thread);
+}
+
+int ff_audio_thread_execute(AVAudioResampleContext *avr,
+                            audio_thread_func *func, void *arg,
+                            int nb_jobs, int nb_samples)
+{
+    AudioThreadContext *t = avr->thread;
+    int i, ret;
+
+    if (!t || nb_jobs < 2 ||
+        nb_jobs * (int64_t)nb_samples < avr->thread_threshold) {
+        for (i = 0; i < nb_jobs; i++) {
+            ret = func(arg, i);
+            if (ret < 0)
+                return ret;
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&t->lock);
+    t->func      = func;
+    t->arg       = arg;
+    t->nb_jobs   = nb_jobs;
+    t->next_job  = 0;
+    t->jobs_done = 0;
+    t->ret       = 0;
+    pthread_cond_broadcast(&t->job_cond);
+
+    run_jobs(t);
+    while (t->jobs_done < t->nb_jobs)
+        pthread_cond_wait(&t->done_cond, &t->lock);
+
+    ret        = t->ret;
+    t->nb_jobs = 0;
+    pthread_mutex_unlock(&t->lock);
+
+    return ret;
+}
+
+#else
+
+int ff_audio_thread_init(AVAudioResampleContext *avr)
+{
+    if (avr->threads > 1)
+        av_log(avr, AV_LOG_WARNING, "threads are not supported in this "
+               "build, using a single thread\n");
+    return 0;
+}
+
+void ff_audio_thread_free(AVAudioResampleContext *avr)
+{
+}
+
+int ff_audio_thread_execute(AVAudioResampleContext *avr,
+                            audio_thread_func *func, void *arg,
+                            int nb_jobs, int nb_samples)
+{
+    int i, ret;
+
+    for (i = 0; i < nb_jobs; i++) {
+        ret = func(arg, i);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+#endif /* HAVE_PTHREADS */
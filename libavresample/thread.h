@@ -0,0 +1,69 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVRESAMPLE_THREAD_H
+#define AVRESAMPLE_THREAD_H
+
+#include "internal.h"
+
+/**
+ * Job function run by ff_audio_thread_execute().
+ *
+ * @param arg  opaque pointer passed to ff_audio_thread_execute()
+ * @param job  job index, from 0 to nb_jobs - 1
+ * @return     0 on success, negative AVERROR code on failure
+ */
+typedef int (audio_thread_func)(void *arg, int job);
+
+/**
+ * Start the worker threads, if more than one thread was requested with the
+ * "threads" option.
+ *
+ * @param avr  AVAudioResampleContext
+ * @return     0 on success, negative AVERROR code on failure
+ */
+int ff_audio_thread_init(AVAudioResampleContext *avr);
+
+/**
+ * Stop the worker threads and free the thread context.
+ *
+ * @param avr  AVAudioResampleContext
+ */
+void ff_audio_thread_free(AVAudioResampleContext *avr);
+
+/**
+ * Run a set of independent jobs.
+ *
+ * The jobs are distributed over the worker threads if there are any and the
+ * total amount of work, nb_jobs * nb_samples, is at least the value of the
+ * "thread_threshold" option. Otherwise they are run in order on the calling
+ * thread.
+ *
+ * @param avr         AVAudioResampleContext
+ * @param func        job function
+ * @param arg         opaque pointer passed to func
+ * @param nb_jobs     number of jobs
+ * @param nb_samples  number of samples processed by each job
+ * @return            0 on success, the first negative value returned by func
+ *                    on failure
+ */
+int ff_audio_thread_execute(AVAudioResampleContext *avr,
+                            audio_thread_func *func, void *arg,
+                            int nb_jobs, int nb_samples);
+
+#endif /* AVRESAMPLE_THREAD_H */
@@ -31,6 +31,7 @@
 #include "audio_convert.h"
 #include "audio_mix.h"
 #include "resample.h"
+#include "thread.h"
 
 int avresample_open(AVAudioResampleContext *avr)
 {
@@ -246,6 +247,11 @@ int avresample_open(AVAudioResampleContext *avr)
             goto error;
         }
     }
+    if (avr->resample_needed || avr->mixing_needed) {
+        ret = ff_audio_thread_init(avr);
+        if (ret < 0)
+            goto error;
+    }
 
     return 0;
 
@@ -265,6 +271,7 @@ void avresample_close(AVAudioResampleContext *avr)
     ff_audio_convert_free(&avr->ac_out);
     ff_audio_resample_free(&avr->resample);
     ff_audio_mix_free(&avr->am);
+    ff_audio_thread_free(avr);
     av_freep(&avr->mix_matrix);
 
     avr->use_channel_map = 0;
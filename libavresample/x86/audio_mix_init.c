@@ -18,9 +18,15 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
 #include "config.h"
+#include "libavutil/common.h"
 #include "libavutil/cpu.h"
+#include "libavutil/internal.h"
+#include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
+#include "libavresample/avresample.h"
 #include "libavresample/audio_mix.h"
 
 extern void ff_mix_2_to_1_fltp_flt_sse(float **src, float **matrix, int len,
@@ -171,11 +177,67 @@ DEFINE_MIX_3_8_TO_1_2(8)
                               ff_mix_ ## chan ## _to_2_s16p_flt_fma4);      \
     }
 
+#if HAVE_SSE_INLINE
+/* number of samples processed per block in mix_any_fltp_flt_sse() */
+#define MIX_BLOCK_SIZE 64
+
+/* sum[i] += src[i] * m, len is a multiple of 4 and both pointers are aligned */
+static void mix_mac_block_sse(float *sum, const float *src, float m, int len)
+{
+    x86_reg i = -len * 4;
+    __asm__ volatile (
+        "shufps      $0, %1, %1     \n"
+        "1:                         \n"
+        "movaps (%3, %0), %%xmm0    \n"
+        "mulps        %1, %%xmm0    \n"
+        "addps  (%2, %0), %%xmm0    \n"
+        "movaps   %%xmm0, (%2, %0)  \n"
+        "add         $16, %0        \n"
+        "jl           1b            \n"
+        : "+r"(i), "+x"(m)
+        : "r"(sum + len), "r"(src + len)
+        : XMM_CLOBBERS("%xmm0",) "memory"
+    );
+}
+
+/* Same block structure as the C any-to-any function: zero coefficients are
+ * skipped and each output sample is accumulated in input channel order, so the
+ * output is bit-exact with mix_any_FLTP_FLT_c(). */
+static void mix_any_fltp_flt_sse(float **samples, float **matrix, int len,
+                                 int out_ch, int in_ch)
+{
+    int in, out, offset;
+    LOCAL_ALIGNED_16(float, temp, [AVRESAMPLE_MAX_CHANNELS], [MIX_BLOCK_SIZE]);
+
+    for (offset = 0; offset < len; offset += MIX_BLOCK_SIZE) {
+        int nb_samples = FFMIN(len - offset, MIX_BLOCK_SIZE);
+        for (out = 0; out < out_ch; out++) {
+            memset(temp[out], 0, nb_samples * sizeof(float));
+            for (in = 0; in < in_ch; in++) {
+                const float m = matrix[out][in];
+                if (!m)
+                    continue;
+                mix_mac_block_sse(temp[out], samples[in] + offset, m,
+                                  nb_samples);
+            }
+        }
+        for (out = 0; out < out_ch; out++)
+            memcpy(samples[out] + offset, temp[out],
+                   nb_samples * sizeof(float));
+    }
+}
+#endif /* HAVE_SSE_INLINE */
+
 av_cold void ff_audio_mix_init_x86(AudioMix *am)
 {
-#if HAVE_YASM
     int mm_flags = av_get_cpu_flags();
 
+#if HAVE_SSE_INLINE
+    if (INLINE_SSE(mm_flags))
+        ff_audio_mix_set_func(am, AV_SAMPLE_FMT_FLTP, AV_MIX_COEFF_TYPE_FLT,
+                              0, 0, 16, 4, "SSE", mix_any_fltp_flt_sse);
+#endif
+#if HAVE_YASM
     if (EXTERNAL_SSE(mm_flags)) {
         ff_audio_mix_set_func(am, AV_SAMPLE_FMT_FLTP, AV_MIX_COEFF_TYPE_FLT,
                               2, 1, 16, 8, "SSE", ff_mix_2_to_1_fltp_flt_sse);
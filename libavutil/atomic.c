@@ -58,6 +58,17 @@ int avpriv_atomic_int_add_and_fetch(volatile int *ptr, int inc)
     return res;
 }
 
+int avpriv_atomic_int_cas(volatile int *ptr, int oldval, int newval)
+{
+    int ret;
+    pthread_mutex_lock(&atomic_lock);
+    ret = *ptr;
+    if (*ptr == oldval)
+        *ptr = newval;
+    pthread_mutex_unlock(&atomic_lock);
+    return ret;
+}
+
 void *avpriv_atomic_ptr_cas(void * volatile *ptr, void *oldval, void *newval)
 {
     void *ret;
@@ -87,6 +98,15 @@ int avpriv_atomic_int_add_and_fetch(volatile int *ptr, int inc)
     return *ptr;
 }
 
+int avpriv_atomic_int_cas(volatile int *ptr, int oldval, int newval)
+{
+    if (*ptr == oldval) {
+        *ptr = newval;
+        return oldval;
+    }
+    return *ptr;
+}
+
 void *avpriv_atomic_ptr_cas(void * volatile *ptr, void *oldval, void *newval)
 {
     if (*ptr == oldval) {
@@ -117,6 +137,10 @@ int main(void)
     avpriv_atomic_int_set(&val, 3);
     res = avpriv_atomic_int_get(&val);
     assert(res == 3);
+    res = avpriv_atomic_int_cas(&val, 2, 4);
+    assert(res == 3 && val == 3);
+    res = avpriv_atomic_int_cas(&val, 3, 4);
+    assert(res == 3 && val == 4);
 
     return 0;
 }
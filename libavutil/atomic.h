@@ -60,6 +60,17 @@ void avpriv_atomic_int_set(volatile int *ptr, int val);
  */
 int avpriv_atomic_int_add_and_fetch(volatile int *ptr, int inc);
 
+/**
+ * Atomic integer compare and swap.
+ *
+ * @param ptr atomic integer
+ * @param oldval do the swap if the current value of *ptr equals to oldval
+ * @param newval value to replace *ptr with
+ * @return the value of *ptr before comparison
+ * @note This acts as a memory barrier.
+ */
+int avpriv_atomic_int_cas(volatile int *ptr, int oldval, int newval);
+
 /**
  * Atomic pointer compare and swap.
  *
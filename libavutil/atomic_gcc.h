@@ -45,6 +45,12 @@ static inline int atomic_int_add_and_fetch_gcc(volatile int *ptr, int inc)
     return __sync_add_and_fetch(ptr, inc);
 }
 
+#define avpriv_atomic_int_cas atomic_int_cas_gcc
+static inline int atomic_int_cas_gcc(volatile int *ptr, int oldval, int newval)
+{
+    return __sync_val_compare_and_swap(ptr, oldval, newval);
+}
+
 #define avpriv_atomic_ptr_cas atomic_ptr_cas_gcc
 static inline void *atomic_ptr_cas_gcc(void * volatile *ptr,
                                        void *oldval, void *newval)
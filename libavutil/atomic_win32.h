@@ -45,6 +45,12 @@ static inline int atomic_int_add_and_fetch_win32(volatile int *ptr, int inc)
     return inc + InterlockedExchangeAdd(ptr, inc);
 }
 
+#define avpriv_atomic_int_cas atomic_int_cas_win32
+static inline int atomic_int_cas_win32(volatile int *ptr, int oldval, int newval)
+{
+    return InterlockedCompareExchange((volatile LONG *)ptr, newval, oldval);
+}
+
 #define avpriv_atomic_ptr_cas atomic_ptr_cas_win32
 static inline void *atomic_ptr_cas_win32(void * volatile *ptr,
                                          void *oldval, void *newval)
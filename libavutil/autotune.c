@@ -0,0 +1,372 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "autotune_internal.h"
+#include "avstring.h"
+#include "common.h"
+#include "cpu.h"
+#include "error.h"
+#include "log.h"
+#include "mem.h"
+#include "time.h"
+#include "timer.h"
+#if ARCH_X86
+#include "x86/cpu.h"
+#endif
+
+#define MAX_ENTRIES 256
+
+/* each implementation is timed over BENCH_RUNS calls, the best of
+ * BENCH_REPEATS series is kept */
+#define BENCH_RUNS    16
+#define BENCH_REPEATS 32
+
+/* the default implementation is kept unless another one is faster by more
+ * than this many percent, so that the noise does not change the choice */
+#define BENCH_MARGIN  3
+
+typedef struct AutotuneEntry {
+    char *func;
+    char *impl;
+} AutotuneEntry;
+
+static AutotuneEntry forced[MAX_ENTRIES];
+static AutotuneEntry cache[MAX_ENTRIES];
+static int  nb_forced, nb_cache;
+static int  enabled, cache_loaded;
+static char *cache_file;
+static char cpu_key[128];
+
+#if HAVE_PTHREADS
+static pthread_mutex_t autotune_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK()   pthread_mutex_lock(&autotune_lock)
+#define UNLOCK() pthread_mutex_unlock(&autotune_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+static int set_entry(AutotuneEntry *entries, int *nb_entries,
+                     const char *func, const char *impl)
+{
+    char *s;
+    int i;
+
+    for (i = 0; i < *nb_entries; i++)
+        if (!strcmp(entries[i].func, func))
+            break;
+    if (i == MAX_ENTRIES)
+        return AVERROR(ENOMEM);
+
+    if (!(s = av_strdup(impl)))
+        return AVERROR(ENOMEM);
+    if (i == *nb_entries) {
+        if (!(entries[i].func = av_strdup(func))) {
+            av_free(s);
+            return AVERROR(ENOMEM);
+        }
+        (*nb_entries)++;
+    } else {
+        av_free(entries[i].impl);
+    }
+    entries[i].impl = s;
+
+    return 0;
+}
+
+static const char *get_entry(const AutotuneEntry *entries, int nb_entries,
+                             const char *func)
+{
+    int i;
+
+    for (i = 0; i < nb_entries; i++)
+        if (!strcmp(entries[i].func, func))
+            return entries[i].impl;
+    return NULL;
+}
+
+static int find_impl(const char * const *names, int nb_impls, const char *impl)
+{
+    int i;
+
+    for (i = 0; i < nb_impls; i++)
+        if (!strcmp(names[i], impl))
+            return i;
+    return -1;
+}
+
+/* the cpu flags are part of the key, as they may be masked by the user */
+static void init_cpu_key(void)
+{
+    char model[64] = "unknown";
+
+#if ARCH_X86
+    ff_get_cpu_model_x86(model, sizeof(model));
+#endif
+    snprintf(cpu_key, sizeof(cpu_key), "%s/%x", model, av_get_cpu_flags());
+}
+
+static void load_cache(void)
+{
+    char line[512], func[128], impl[32], key[256];
+    FILE *f;
+
+    cache_loaded = 1;
+    init_cpu_key();
+
+    if (!cache_file || !(f = fopen(cache_file, "r")))
+        return;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%127s %31s %255[^\n]", func, impl, key) != 3 ||
+            strcmp(key, cpu_key))
+            continue;
+        if (set_entry(cache, &nb_cache, func, impl) < 0)
+            break;
+    }
+    fclose(f);
+}
+
+static void save_entry(const char *func, const char *impl)
+{
+    FILE *f;
+
+    if (!cache_file)
+        return;
+    if (!(f = fopen(cache_file, "a"))) {
+        av_log(NULL, AV_LOG_WARNING, "Cannot write the autotune cache %s\n",
+               cache_file);
+        return;
+    }
+    fprintf(f, "%s %s %s\n", func, impl, cpu_key);
+    fclose(f);
+}
+
+static uint64_t bench_time(void)
+{
+#ifdef AV_READ_TIME
+    return AV_READ_TIME();
+#else
+    return av_gettime();
+#endif
+}
+
+static int benchmark(const char * const *names, int nb_impls, int def,
+                     void (*run)(void *opaque, int impl), void *opaque)
+{
+    uint64_t best[AUTOTUNE_MAX_IMPLS];
+    int i, j, k, fastest = def;
+
+    for (i = 0; i < nb_impls; i++) {
+        best[i] = UINT64_MAX;
+        /* warm up the caches */
+        run(opaque, i);
+    }
+
+    /* alternate the implementations so that they are all equally affected
+     * by frequency changes and other processes */
+    for (k = 0; k < BENCH_REPEATS; k++) {
+        for (i = 0; i < nb_impls; i++) {
+            uint64_t t = bench_time();
+            for (j = 0; j < BENCH_RUNS; j++)
+                run(opaque, i);
+            best[i] = FFMIN(best[i], bench_time() - t);
+        }
+    }
+
+    for (i = 0; i < nb_impls; i++) {
+        av_log(NULL, AV_LOG_DEBUG, "  %-12s %"PRIu64"\n", names[i], best[i]);
+        if (best[i] < best[fastest])
+            fastest = i;
+    }
+    if (best[def] * 100 <= best[fastest] * (100 + BENCH_MARGIN))
+        fastest = def;
+
+    return fastest;
+}
+
+/* the cache entries are keyed by the function and its candidates, so that
+ * a choice made among fewer candidates, e.g. by an older build, is not
+ * reused once new ones are available */
+static void get_cache_key(char *key, int size, const char *func,
+                          const char * const *names, int nb_impls)
+{
+    int i;
+
+    snprintf(key, size, "%s:%s", func, names[0]);
+    for (i = 1; i < nb_impls; i++)
+        av_strlcatf(key, size, ",%s", names[i]);
+}
+
+int avpriv_autotune(const char *func, const char * const *names, int nb_impls,
+                    int def, int strict, void (*run)(void *opaque, int impl),
+                    void *opaque)
+{
+    char key[128];
+    const char *impl;
+    int ret;
+
+    if ((!enabled && !nb_forced) || nb_impls > AUTOTUNE_MAX_IMPLS)
+        return def;
+
+    LOCK();
+    if ((impl = get_entry(forced, nb_forced, func))) {
+        if ((ret = find_impl(names, nb_impls, impl)) >= 0)
+            goto end;
+        av_log(NULL, AV_LOG_WARNING, "Implementation %s of %s is not "
+               "available, ignoring it\n", impl, func);
+    }
+
+    /* the implementations may not give the same results, the choice must not
+     * depend on the timings when the output has to be reproducible */
+    ret = def;
+    if (!enabled || strict || nb_impls < 2)
+        goto end;
+
+    if (!cache_loaded)
+        load_cache();
+    get_cache_key(key, sizeof(key), func, names, nb_impls);
+    if ((impl = get_entry(cache, nb_cache, key)) &&
+        (ret = find_impl(names, nb_impls, impl)) >= 0) {
+        av_log(NULL, AV_LOG_VERBOSE, "Autotune: using cached %s for %s\n",
+               names[ret], func);
+        goto end;
+    }
+
+    ret = benchmark(names, nb_impls, def, run, opaque);
+    av_log(NULL, AV_LOG_VERBOSE, "Autotune: using %s for %s\n",
+           names[ret], func);
+    if (set_entry(cache, &nb_cache, key, names[ret]) >= 0)
+        save_entry(key, names[ret]);
+
+end:
+    UNLOCK();
+    return ret;
+}
+
+int av_autotune_enable(const char *file)
+{
+    av_freep(&cache_file);
+    if (file && !(cache_file = av_strdup(file)))
+        return AVERROR(ENOMEM);
+    enabled = 1;
+    return 0;
+}
+
+int av_autotune_force(const char *func, const char *impl)
+{
+    return set_entry(forced, &nb_forced, func, impl);
+}
+
+#ifdef TEST
+#include "avassert.h"
+
+#define CACHE_FILE "autotune-test.cache"
+
+static void run_test(void *opaque, int impl)
+{
+    volatile int i, n = impl ? 0 : 10000;
+
+    for (i = 0; i < n; i++);
+}
+
+static void reset_cache(void)
+{
+    int i;
+
+    for (i = 0; i < nb_cache; i++) {
+        av_freep(&cache[i].func);
+        av_freep(&cache[i].impl);
+    }
+    nb_cache     = 0;
+    cache_loaded = 0;
+}
+
+static int cache_has(const char *str)
+{
+    char line[512];
+    FILE *f = fopen(CACHE_FILE, "r");
+    int found = 0;
+
+    av_assert0(f);
+    while (!found && fgets(line, sizeof(line), f))
+        found = !!strstr(line, str);
+    fclose(f);
+    return found;
+}
+
+int main(void)
+{
+    static const char * const names[]  = { "slow", "fast" };
+    static const char * const names3[] = { "slow", "fast", "new" };
+    FILE *f;
+
+    /* overrides, with and without autotuning */
+    av_assert0(avpriv_autotune("test.func", names, 2, 0, 0, run_test, NULL) == 0);
+    av_assert0(!av_autotune_force("test.forced", "fast"));
+    av_assert0(avpriv_autotune("test.forced", names, 2, 0, 0, run_test, NULL) == 1);
+    av_assert0(avpriv_autotune("test.forced", names, 2, 0, 1, run_test, NULL) == 1);
+    av_assert0(!av_autotune_force("test.forced", "none"));
+    av_assert0(avpriv_autotune("test.forced", names, 2, 0, 0, run_test, NULL) == 0);
+
+    /* the entries for another cpu or another candidate list and the
+     * malformed ones are ignored */
+    init_cpu_key();
+    f = fopen(CACHE_FILE, "w");
+    av_assert0(f);
+    fprintf(f, "test.cached:slow,fast slow %s\n", cpu_key);
+    fprintf(f, "test.cpu:slow,fast slow other-cpu/0\n");
+    fprintf(f, "test.list:slow slow %s\n", cpu_key);
+    fprintf(f, "test.new:slow,fast slow %s\n", cpu_key);
+    fprintf(f, "test.bad:slow,fast\n");
+    fclose(f);
+
+    av_assert0(!av_autotune_enable(CACHE_FILE));
+    av_assert0(avpriv_autotune("test.cached", names, 2, 1, 0, NULL, NULL) == 0);
+    av_assert0(avpriv_autotune("test.cpu",  names, 2, 0, 0, run_test, NULL) == 1);
+    av_assert0(avpriv_autotune("test.list", names, 2, 0, 0, run_test, NULL) == 1);
+    av_assert0(avpriv_autotune("test.bad",  names, 2, 0, 0, run_test, NULL) == 1);
+    av_assert0(avpriv_autotune("test.new", names3, 3, 1, 0, run_test, NULL) != 0);
+
+    /* nothing is benchmarked nor saved in strict mode */
+    av_assert0(avpriv_autotune("test.strict", names, 2, 0, 1, NULL, NULL) == 0);
+    av_assert0(!cache_has("test.strict"));
+
+    /* the choices are read back from the file */
+    reset_cache();
+    av_assert0(avpriv_autotune("test.cpu", names, 2, 0, 0, NULL, NULL) == 1);
+    av_assert0(avpriv_autotune("test.new", names,  2, 1, 0, NULL, NULL) == 0);
+    av_assert0(cache_has("test.new:slow,fast,new "));
+
+    reset_cache();
+    av_freep(&cache_file);
+    remove(CACHE_FILE);
+
+    return 0;
+}
+#endif
@@ -0,0 +1,73 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * runtime selection of the optimized functions
+ */
+
+#ifndef AVUTIL_AUTOTUNE_H
+#define AVUTIL_AUTOTUNE_H
+
+/**
+ * @defgroup lavu_autotune Autotuning
+ * @ingroup lavu_misc
+ *
+ * @{
+ * By default the optimized version of a function is chosen from the CPU
+ * flags alone. For some functions several versions may be usable on the
+ * same CPU, e.g. SSE2 versions which are slower than the MMX ones on some
+ * processors. When autotuning is enabled, the first initialization of such a
+ * function benchmarks the candidate versions and keeps the fastest one.
+ *
+ * The choices are saved in a cache file, keyed by the CPU model and flags
+ * and by the candidate versions, so that the benchmarks are only run once on
+ * a given machine. The functions used where the output must be reproducible,
+ * e.g. with CODEC_FLAG_BITEXACT, are not benchmarked.
+ */
+
+/**
+ * Enable autotuning.
+ *
+ * This function is not thread-safe, it must be called before any codec or
+ * other context using the tuned functions is initialized.
+ *
+ * @param cache_file file the choices are loaded from and appended to, it is
+ *                   created if it does not exist; NULL to keep the choices
+ *                   in memory only
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_autotune_enable(const char *cache_file);
+
+/**
+ * Force the implementation of a function, whether autotuning is enabled or
+ * not. It has the same thread-safety requirements as av_autotune_enable().
+ *
+ * @param func name of the function, e.g. "float_dsp.scalarproduct_float"
+ * @param impl name of the implementation, e.g. "c" or "sse2"; if it is not
+ *             available for the function a warning is printed when the
+ *             function is initialized and the override is ignored
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_autotune_force(const char *func, const char *impl);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_AUTOTUNE_H */
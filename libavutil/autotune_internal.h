@@ -0,0 +1,49 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_AUTOTUNE_INTERNAL_H
+#define AVUTIL_AUTOTUNE_INTERNAL_H
+
+#include "autotune.h"
+
+#define AUTOTUNE_MAX_IMPLS 8
+
+/**
+ * Pick one of several implementations of a function.
+ *
+ * The default is kept unless an implementation is forced with
+ * av_autotune_force() or autotuning is enabled, in which case the cached
+ * choice for this CPU and these candidates is used or the implementations are
+ * benchmarked.
+ *
+ * @param func     name of the function, "<context>.<function>"
+ * @param names    names of the implementations, e.g. "c", "mmx", "sse2"
+ * @param nb_impls number of implementations, at most AUTOTUNE_MAX_IMPLS
+ * @param def      index of the implementation chosen from the CPU flags
+ * @param strict   if set, e.g. for CODEC_FLAG_BITEXACT, the implementations
+ *                 are not benchmarked, only a forced one replaces the default
+ * @param run      callback running the implementation of index impl once on
+ *                 representative data
+ * @param opaque   passed to run
+ * @return the index of the implementation to use
+ */
+int avpriv_autotune(const char *func, const char * const *names, int nb_impls,
+                    int def, int strict, void (*run)(void *opaque, int impl),
+                    void *opaque);
+
+#endif /* AVUTIL_AUTOTUNE_INTERNAL_H */
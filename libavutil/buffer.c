@@ -19,9 +19,15 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "atomic.h"
 #include "buffer_internal.h"
 #include "common.h"
+#include "cpu.h"
 #include "mem.h"
 
 AVBufferRef *av_buffer_create(uint8_t *data, int size,
@@ -62,12 +68,12 @@ void av_buffer_default_free(void *opaque, uint8_t *data)
     av_free(data);
 }
 
-AVBufferRef *av_buffer_alloc(int size)
+static AVBufferRef *buffer_alloc(int size, int flags)
 {
     AVBufferRef *ret = NULL;
     uint8_t    *data = NULL;
 
-    data = av_malloc(size);
+    data = av_malloc_flags(size, flags);
     if (!data)
         return NULL;
 
@@ -78,6 +84,16 @@ AVBufferRef *av_buffer_alloc(int size)
     return ret;
 }
 
+AVBufferRef *av_buffer_alloc(int size)
+{
+    return buffer_alloc(size, 0);
+}
+
+static AVBufferRef *buffer_alloc_huge(int size)
+{
+    return buffer_alloc(size, AV_MALLOC_HUGE_PAGES);
+}
+
 AVBufferRef *av_buffer_allocz(int size)
 {
     AVBufferRef *ret = av_buffer_alloc(size);
@@ -193,33 +209,112 @@ int av_buffer_realloc(AVBufferRef **pbuf, int size)
     return 0;
 }
 
-AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
+#if HAVE_PTHREADS
+static pthread_once_t thread_slot_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  thread_slot_key;
+static int            thread_slot_key_ok;
+static volatile int   nb_thread_slots;
+
+static void thread_slot_init(void)
+{
+    thread_slot_key_ok = !pthread_key_create(&thread_slot_key, NULL);
+}
+
+/* return a number identifying the calling thread, assigned on first use */
+static int get_thread_slot(void)
+{
+    intptr_t slot;
+
+    pthread_once(&thread_slot_once, thread_slot_init);
+    if (!thread_slot_key_ok)
+        return 0;
+
+    slot = (intptr_t)pthread_getspecific(thread_slot_key);
+    if (!slot) {
+        slot = avpriv_atomic_int_add_and_fetch(&nb_thread_slots, 1);
+        pthread_setspecific(thread_slot_key, (void *)slot);
+    }
+    return slot - 1;
+}
+#else
+static int get_thread_slot(void)
+{
+    return 0;
+}
+#endif
+
+AVBufferPool *av_buffer_pool_init2(int size, AVBufferRef* (*alloc)(int size),
+                                   int flags, int max_idle)
 {
     AVBufferPool *pool = av_mallocz(sizeof(*pool));
     if (!pool)
         return NULL;
 
     pool->size     = size;
-    pool->alloc    = alloc ? alloc : av_buffer_alloc;
+    pool->alloc    = alloc ? alloc :
+                     flags & AV_BUFFER_POOL_FLAG_HUGE_PAGES ? buffer_alloc_huge :
+                                                              av_buffer_alloc;
+    pool->max_idle = FFMAX(max_idle, 0);
+    pool->flags    = flags;
+    pool->mem_tag  = av_mem_tag_get();
+
+    if (HAVE_THREADS && (flags & AV_BUFFER_POOL_FLAG_THREAD_CACHES)) {
+        int nb_caches = 1;
+        int nb_wanted = av_clip(2 * av_cpu_count(), MIN_CACHES, MAX_CACHES);
+
+        while (nb_caches < nb_wanted)
+            nb_caches <<= 1;
+
+        /* av_malloc() does not align to a cache line */
+        pool->caches_buf = av_mallocz(nb_caches * sizeof(*pool->caches) +
+                                      CACHE_LINE_SIZE - 1);
+        if (!pool->caches_buf) {
+            av_freep(&pool);
+            return NULL;
+        }
+        pool->caches    = (BufferPoolCache *)FFALIGN((uintptr_t)pool->caches_buf,
+                                                     CACHE_LINE_SIZE);
+        pool->nb_caches = nb_caches;
+    }
 
     avpriv_atomic_int_set(&pool->refcount, 1);
 
     return pool;
 }
 
+AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
+{
+    return av_buffer_pool_init2(size, alloc, 0, 0);
+}
+
+/* free all the buffers of a list, return their number */
+static int free_list(BufferPoolEntry *buf)
+{
+    int nb = 0;
+
+    while (buf) {
+        BufferPoolEntry *next = buf->next;
+
+        buf->free(buf->opaque, buf->data);
+        av_free(buf);
+        buf = next;
+        nb++;
+    }
+    return nb;
+}
+
 /*
  * This function gets called when the pool has been uninited and
  * all the buffers returned to it.
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    int i;
 
-        buf->free(buf->opaque, buf->data);
-        av_freep(&buf);
-    }
+    free_list(pool->pool);
+    for (i = 0; i < pool->nb_caches; i++)
+        free_list(pool->caches[i].list);
+    av_freep(&pool->caches_buf);
     av_freep(&pool);
 }
 
@@ -236,14 +331,14 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
         buffer_pool_free(pool);
 }
 
-/* remove the whole buffer list from the pool and return it */
-static BufferPoolEntry *get_pool(AVBufferPool *pool)
+/* remove the whole buffer list and return it */
+static BufferPoolEntry *get_list(BufferPoolEntry * volatile *list)
 {
     BufferPoolEntry *cur = NULL, *last = NULL;
 
     do {
         FFSWAP(BufferPoolEntry*, cur, last);
-        cur = avpriv_atomic_ptr_cas((void * volatile *)&pool->pool, last, NULL);
+        cur = avpriv_atomic_ptr_cas((void * volatile *)list, last, NULL);
         if (!cur)
             return NULL;
     } while (cur != last);
@@ -251,32 +346,66 @@ static BufferPoolEntry *get_pool(AVBufferPool *pool)
     return cur;
 }
 
-static void add_to_pool(BufferPoolEntry *buf)
+static void add_to_list(BufferPoolEntry * volatile *list, BufferPoolEntry *buf)
 {
-    AVBufferPool *pool;
     BufferPoolEntry *cur, *end = buf;
 
     if (!buf)
         return;
-    pool = buf->pool;
 
     while (end->next)
         end = end->next;
 
-    while ((cur = avpriv_atomic_ptr_cas((void * volatile *)&pool->pool, NULL, buf))) {
-        /* pool is not empty, retrieve it and append it to our list */
-        cur = get_pool(pool);
+    while ((cur = avpriv_atomic_ptr_cas((void * volatile *)list, NULL, buf))) {
+        /* list is not empty, retrieve it and append it to ours */
+        cur = get_list(list);
         end->next = cur;
         while (end->next)
             end = end->next;
     }
 }
 
+/* the list the calling thread gets its buffers from and returns them to */
+static BufferPoolEntry * volatile *thread_list(AVBufferPool *pool, int *cache)
+{
+    if (!pool->nb_caches)
+        return &pool->pool;
+    *cache = get_thread_slot() & (pool->nb_caches - 1);
+    return &pool->caches[*cache].list;
+}
+
+/* refill an empty cache by taking over the whole content of another one */
+static BufferPoolEntry *steal_list(AVBufferPool *pool, int cache)
+{
+    int i;
+
+    for (i = 1; i < pool->nb_caches; i++) {
+        int idx = (cache + i) & (pool->nb_caches - 1);
+        BufferPoolEntry *buf;
+
+        if (!pool->caches[idx].list)
+            continue;
+        if ((buf = get_list(&pool->caches[idx].list)))
+            return buf;
+    }
+    return NULL;
+}
+
 static void pool_release_buffer(void *opaque, uint8_t *data)
 {
     BufferPoolEntry *buf = opaque;
     AVBufferPool *pool = buf->pool;
-    add_to_pool(buf);
+    int cache = 0;
+
+    if (pool->max_idle &&
+        avpriv_atomic_int_add_and_fetch(&pool->nb_idle, 1) > pool->max_idle) {
+        avpriv_atomic_int_add_and_fetch(&pool->nb_idle, -1);
+        free_list(buf);
+    } else if (pool->nb_caches && (pool->flags & AV_BUFFER_POOL_FLAG_LOCAL))
+        add_to_list(&pool->caches[buf->cache].list, buf);
+    else
+        add_to_list(thread_list(pool, &cache), buf);
+
     if (!avpriv_atomic_int_add_and_fetch(&pool->refcount, -1))
         buffer_pool_free(pool);
 }
@@ -287,8 +416,11 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 {
     BufferPoolEntry *buf;
     AVBufferRef     *ret;
+    int cache = 0;
+    int mem_tag = av_mem_tag_set(pool->mem_tag);
 
     ret = pool->alloc(pool->size);
+    av_mem_tag_set(mem_tag);
     if (!ret)
         return NULL;
 
@@ -302,6 +434,8 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
     buf->opaque = ret->buffer->opaque;
     buf->free   = ret->buffer->free;
     buf->pool   = pool;
+    thread_list(pool, &cache);
+    buf->cache  = cache;
 
     ret->buffer->opaque = buf;
     ret->buffer->free   = pool_release_buffer;
@@ -315,23 +449,43 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
     AVBufferRef *ret;
     BufferPoolEntry *buf;
+    BufferPoolEntry * volatile *list;
+    int cache = 0;
+
+    list = thread_list(pool, &cache);
 
     /* check whether the pool is empty */
-    buf = get_pool(pool);
+    buf = get_list(list);
+    if (!buf && pool->nb_caches && !(pool->flags & AV_BUFFER_POOL_FLAG_LOCAL))
+        buf = steal_list(pool, cache);
     if (!buf)
         return pool_alloc_buffer(pool);
 
     /* keep the first entry, return the rest of the list to the pool */
-    add_to_pool(buf->next);
+    add_to_list(list, buf->next);
     buf->next = NULL;
 
     ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                            buf, 0);
     if (!ret) {
-        add_to_pool(buf);
+        add_to_list(list, buf);
         return NULL;
     }
+    if (pool->max_idle)
+        avpriv_atomic_int_add_and_fetch(&pool->nb_idle, -1);
     avpriv_atomic_int_add_and_fetch(&pool->refcount, 1);
 
     return ret;
 }
+
+void av_buffer_pool_trim(AVBufferPool *pool)
+{
+    int i, nb;
+
+    nb = free_list(get_list(&pool->pool));
+    for (i = 0; i < pool->nb_caches; i++)
+        nb += free_list(get_list(&pool->caches[i].list));
+
+    if (pool->max_idle)
+        avpriv_atomic_int_add_and_fetch(&pool->nb_idle, -nb);
+}
@@ -241,6 +241,45 @@ typedef struct AVBufferPool AVBufferPool;
  */
 AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size));
 
+/**
+ * Give each thread using the pool its own cache of free buffers, so that
+ * threads allocating and releasing buffers concurrently do not contend on
+ * a single list. A thread whose cache is empty takes over the content of
+ * another one before allocating a new buffer.
+ */
+#define AV_BUFFER_POOL_FLAG_THREAD_CACHES (1 << 0)
+
+/**
+ * Allocate the buffers with the AV_MALLOC_HUGE_PAGES hint, when the pool
+ * uses the default allocator.
+ */
+#define AV_BUFFER_POOL_FLAG_HUGE_PAGES (1 << 1)
+
+/**
+ * Keep the buffers with the thread that allocated them: a released buffer
+ * goes back to the cache of that thread rather than to the cache of the
+ * releasing thread, and the threads never take over the buffers of another
+ * cache. When the memory is placed on the NUMA node of the thread first
+ * touching it, the buffers used by a worker thread pinned to a node then stay
+ * local to that node. Only meaningful with AV_BUFFER_POOL_FLAG_THREAD_CACHES.
+ */
+#define AV_BUFFER_POOL_FLAG_LOCAL (1 << 2)
+
+/**
+ * Allocate and initialize a buffer pool with additional parameters.
+ *
+ * @param size size of each buffer in this pool
+ * @param alloc a function that will be used to allocate new buffers when the
+ * pool is empty. May be NULL, then the default allocator will be used
+ * (av_buffer_alloc()).
+ * @param flags a combination of AV_BUFFER_POOL_FLAG_*
+ * @param max_idle maximum number of unused buffers kept in the pool, the
+ * buffers released beyond that number are freed. 0 means no limit.
+ * @return newly created buffer pool on success, NULL on error.
+ */
+AVBufferPool *av_buffer_pool_init2(int size, AVBufferRef* (*alloc)(int size),
+                                   int flags, int max_idle);
+
 /**
  * Mark the pool as being available for freeing. It will actually be freed only
  * once all the allocated buffers associated with the pool are released. Thus it
@@ -260,6 +299,14 @@ void av_buffer_pool_uninit(AVBufferPool **pool);
  */
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool);
 
+/**
+ * Free the buffers that are currently unused in the pool. The buffers in use
+ * are not affected and return to the pool as usual when released.
+ * This function may be called simultaneously with av_buffer_pool_get() and
+ * with the release of the buffers from other threads.
+ */
+void av_buffer_pool_trim(AVBufferPool *pool);
+
 /**
  * @}
  */
@@ -69,9 +69,29 @@ typedef struct BufferPoolEntry {
 
     AVBufferPool *pool;
     struct BufferPoolEntry * volatile next;
+
+    /* cache of the thread that allocated the buffer */
+    int cache;
 } BufferPoolEntry;
 
+/* bounds of the number of per-thread caches of a pool, which is otherwise
+ * twice the number of CPUs */
+#define MIN_CACHES 16
+#define MAX_CACHES 64
+
+#define CACHE_LINE_SIZE 64
+
+/*
+ * A list of buffers used by a subset of the threads, padded and aligned so
+ * that the lists of different threads do not share a cache line.
+ */
+typedef struct BufferPoolCache {
+    BufferPoolEntry * volatile list;
+    uint8_t pad[CACHE_LINE_SIZE - sizeof(BufferPoolEntry *)];
+} BufferPoolCache;
+
 struct AVBufferPool {
+    /* the buffers available for reuse, when there are no per-thread caches */
     BufferPoolEntry * volatile pool;
 
     /*
@@ -87,6 +107,28 @@ struct AVBufferPool {
 
     int size;
     AVBufferRef* (*alloc)(int size);
+
+    /*
+     * Per-thread caches the buffers are taken from and returned to, a thread
+     * uses the cache at the index given by its slot number modulo nb_caches.
+     * nb_caches is a power of two, 0 when the caches are disabled.
+     */
+    BufferPoolCache *caches;
+    int           nb_caches;
+    uint8_t      *caches_buf;   ///< allocation caches is aligned within
+
+    /*
+     * Maximum number of unused buffers kept in the pool, the buffers released
+     * above it are freed. nb_idle is only maintained when max_idle is set.
+     */
+    int          max_idle;
+    volatile int nb_idle;
+
+    /* a combination of AV_BUFFER_POOL_FLAG_* */
+    int flags;
+
+    /* memory tag the buffers are accounted to, the one current at init */
+    int mem_tag;
 };
 
 #endif /* AVUTIL_BUFFER_INTERNAL_H */
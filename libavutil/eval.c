@@ -123,23 +123,50 @@ static int strmatch(const char *s, const char *prefix)
     return !IS_IDENTIFIER_CHAR(s[i]);
 }
 
+enum ExprType {
+    e_value, e_const, e_func0, e_func1, e_func2,
+    e_squish, e_gauss, e_ld, e_isnan, e_isinf,
+    e_mod, e_max, e_min, e_eq, e_gt, e_gte,
+    e_pow, e_mul, e_div, e_add,
+    e_last, e_st, e_while, e_floor, e_ceil, e_trunc,
+    e_sqrt, e_not,
+    /* only used in compiled expressions */
+    e_nan, e_jz, e_jmp,
+};
+
+typedef union ExprArg {
+    int const_index;
+    int target;                 ///< instruction index for e_jz and e_jmp
+    double (*func0)(double);
+    double (*func1)(void *, double);
+    double (*func2)(void *, double, double);
+} ExprArg;
+
+/**
+ * One instruction of a compiled expression. It computes the same thing as an
+ * AVExpr node of the same type, reading its operands from registers src[]
+ * instead of evaluating subexpressions, and writes the result to register
+ * dst.
+ */
+typedef struct ExprInsn {
+    enum ExprType type;
+    double value;
+    ExprArg a;
+    int dst, src[2];
+} ExprInsn;
+
+#define MAX_REGS 32
+
 struct AVExpr {
-    enum {
-        e_value, e_const, e_func0, e_func1, e_func2,
-        e_squish, e_gauss, e_ld, e_isnan, e_isinf,
-        e_mod, e_max, e_min, e_eq, e_gt, e_gte,
-        e_pow, e_mul, e_div, e_add,
-        e_last, e_st, e_while, e_floor, e_ceil, e_trunc,
-        e_sqrt, e_not,
-    } type;
+    enum ExprType type;
     double value; // is sign in other types
-    union {
-        int const_index;
-        double (*func0)(double);
-        double (*func1)(void *, double);
-        double (*func2)(void *, double, double);
-    } a;
+    ExprArg a;
     struct AVExpr *param[2];
+
+    /* compiled form of the expression, only set on the root node */
+    ExprInsn *code;
+    int nb_code;
+    int uses_vars;
 };
 
 static double eval_expr(Parser *p, AVExpr *e)
@@ -195,6 +222,7 @@ void av_expr_free(AVExpr *e)
     if (!e) return;
     av_expr_free(e->param[0]);
     av_expr_free(e->param[1]);
+    av_freep(&e->code);
     av_freep(&e);
 }
 
@@ -487,11 +515,234 @@ static int verify_expr(AVExpr *e)
     }
 }
 
-int av_expr_parse(AVExpr **expr, const char *s,
-                  const char * const *const_names,
-                  const char * const *func1_names, double (* const *funcs1)(void *, double),
-                  const char * const *func2_names, double (* const *funcs2)(void *, double, double),
-                  int log_offset, void *log_ctx)
+/**
+ * Check whether a node only depends on its parameters, so it can be
+ * evaluated once when its parameters are constant.
+ */
+static int is_pure(AVExpr *e)
+{
+    switch (e->type) {
+        case e_const:
+        case e_func1:
+        case e_func2:
+        case e_ld:
+        case e_st:
+        case e_while:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Replace the subexpressions whose value does not depend on the constants,
+ * the functions or the variables by their value.
+ */
+static void fold_constants(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i;
+
+    if (!e || e->type == e_value)
+        return;
+
+    fold_constants(e->param[0]);
+    fold_constants(e->param[1]);
+
+    if (!is_pure(e))
+        return;
+    for (i = 0; i < 2; i++)
+        if (e->param[i] && e->param[i]->type != e_value)
+            return;
+
+    e->value = eval_expr(&p, e);
+    e->type  = e_value;
+    for (i = 0; i < 2; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+}
+
+static int is_unary(AVExpr *e)
+{
+    switch (e->type) {
+        case e_func0:
+        case e_func1:
+        case e_squish:
+        case e_gauss:
+        case e_ld:
+        case e_isnan:
+        case e_isinf:
+        case e_floor:
+        case e_ceil:
+        case e_trunc:
+        case e_sqrt:
+        case e_not:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int count_insns(AVExpr *e)
+{
+    switch (e->type) {
+        case e_value:
+        case e_const:  return 1;
+        case e_while:  return 3 + count_insns(e->param[0]) + count_insns(e->param[1]);
+        default:
+            if (is_unary(e))
+                return 1 + count_insns(e->param[0]);
+            return 1 + count_insns(e->param[0]) + count_insns(e->param[1]);
+    }
+}
+
+static ExprInsn *emit(AVExpr *root, enum ExprType type, double value,
+                      int dst, int src0, int src1)
+{
+    ExprInsn *insn = &root->code[root->nb_code++];
+
+    insn->type   = type;
+    insn->value  = value;
+    insn->dst    = dst;
+    insn->src[0] = src0;
+    insn->src[1] = src1;
+    return insn;
+}
+
+/**
+ * Append the code evaluating e into register reg. Parameters are evaluated
+ * into the following registers, so the number of registers needed is the
+ * depth of the expression tree.
+ */
+static int compile_expr(AVExpr *root, AVExpr *e, int reg)
+{
+    ExprInsn *insn;
+    int start;
+
+    if (reg + 1 >= MAX_REGS)
+        return AVERROR(ENOSYS);
+
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+        root->uses_vars = 1;
+        break;
+    case e_value:
+    case e_const:
+        insn = emit(root, e->type, e->value, reg, 0, 0);
+        insn->a = e->a;
+        return 0;
+    case e_while:
+        emit(root, e_nan, 0, reg, 0, 0);
+        start = root->nb_code;
+        if (compile_expr(root, e->param[0], reg + 1) < 0)
+            return AVERROR(ENOSYS);
+        insn = emit(root, e_jz, 0, 0, reg + 1, 0);
+        if (compile_expr(root, e->param[1], reg) < 0)
+            return AVERROR(ENOSYS);
+        emit(root, e_jmp, 0, 0, 0, 0)->a.target = start;
+        insn->a.target = root->nb_code;
+        return 0;
+    }
+
+    if (compile_expr(root, e->param[0], reg) < 0)
+        return AVERROR(ENOSYS);
+    if (!is_unary(e) && compile_expr(root, e->param[1], reg + 1) < 0)
+        return AVERROR(ENOSYS);
+    insn = emit(root, e->type, e->value, reg, reg, reg + 1);
+    insn->a = e->a;
+    return 0;
+}
+
+/**
+ * Translate the expression tree into a flat list of instructions working on
+ * a small register file, which is much cheaper to evaluate than walking the
+ * tree recursively. The tree is kept for the expressions that are too deep
+ * to be compiled.
+ */
+static void compile(AVExpr *e)
+{
+    int nb_insns = count_insns(e);
+
+    if (!(e->code = av_malloc(nb_insns * sizeof(*e->code))))
+        return;
+    e->nb_code = 0;
+
+    if (compile_expr(e, e, 0) < 0) {
+        av_freep(&e->code);
+        e->nb_code = 0;
+    }
+}
+
+static double eval_code(const AVExpr *e, const double *const_values, void *opaque)
+{
+    double reg[MAX_REGS], var[VARS];
+    const ExprInsn *insn = e->code, *end = e->code + e->nb_code;
+
+    if (e->uses_vars)
+        memset(var, 0, sizeof(var));
+
+#define D  reg[insn->src[0]]
+#define D2 reg[insn->src[1]]
+    while (insn < end) {
+        double *dst = &reg[insn->dst];
+
+        switch (insn->type) {
+        case e_value:  *dst = insn->value; break;
+        case e_const:  *dst = insn->value * const_values[insn->a.const_index]; break;
+        case e_func0:  *dst = insn->value * insn->a.func0(D); break;
+        case e_func1:  *dst = insn->value * insn->a.func1(opaque, D); break;
+        case e_func2:  *dst = insn->value * insn->a.func2(opaque, D, D2); break;
+        case e_squish: *dst = 1/(1+exp(4*D)); break;
+        case e_gauss:  *dst = exp(-D*D/2)/sqrt(2*M_PI); break;
+        case e_ld:     *dst = insn->value * var[av_clip(D, 0, VARS-1)]; break;
+        case e_isnan:  *dst = insn->value * !!isnan(D); break;
+        case e_isinf:  *dst = insn->value * !!isinf(D); break;
+        case e_floor:  *dst = insn->value * floor(D); break;
+        case e_ceil:   *dst = insn->value * ceil (D); break;
+        case e_trunc:  *dst = insn->value * trunc(D); break;
+        case e_sqrt:   *dst = insn->value * sqrt (D); break;
+        case e_not:    *dst = insn->value * D == 0; break;
+        case e_mod:    *dst = insn->value * (D - floor(D/D2)*D2); break;
+        case e_max:    *dst = insn->value * (D >  D2 ?   D : D2); break;
+        case e_min:    *dst = insn->value * (D <  D2 ?   D : D2); break;
+        case e_eq:     *dst = insn->value * (D == D2 ? 1.0 : 0.0); break;
+        case e_gt:     *dst = insn->value * (D >  D2 ? 1.0 : 0.0); break;
+        case e_gte:    *dst = insn->value * (D >= D2 ? 1.0 : 0.0); break;
+        case e_pow:    *dst = insn->value * pow(D, D2); break;
+        case e_mul:    *dst = insn->value * (D * D2); break;
+        case e_div:    *dst = insn->value * (D / D2); break;
+        case e_add:    *dst = insn->value * (D + D2); break;
+        case e_last:   *dst = insn->value * D2; break;
+        case e_st:     *dst = insn->value * (var[av_clip(D, 0, VARS-1)] = D2); break;
+        case e_nan:    *dst = NAN; break;
+        case e_jz:
+            if (!D) {
+                insn = e->code + insn->a.target;
+                continue;
+            }
+            break;
+        case e_jmp:
+            insn = e->code + insn->a.target;
+            continue;
+        default:
+            return NAN;
+        }
+        insn++;
+    }
+
+#undef D
+#undef D2
+
+    return reg[0];
+}
+
+static int expr_parse(AVExpr **expr, const char *s,
+                      const char * const *const_names,
+                      const char * const *func1_names, double (* const *funcs1)(void *, double),
+                      const char * const *func2_names, double (* const *funcs2)(void *, double, double),
+                      int log_offset, void *log_ctx, int compile_code)
 {
     Parser p = { 0 };
     AVExpr *e = NULL;
@@ -531,16 +782,32 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_constants(e);
+    if (compile_code)
+        compile(e);
     *expr = e;
 end:
     av_free(w);
     return ret;
 }
 
+int av_expr_parse(AVExpr **expr, const char *s,
+                  const char * const *const_names,
+                  const char * const *func1_names, double (* const *funcs1)(void *, double),
+                  const char * const *func2_names, double (* const *funcs2)(void *, double, double),
+                  int log_offset, void *log_ctx)
+{
+    return expr_parse(expr, s, const_names, func1_names, funcs1,
+                      func2_names, funcs2, log_offset, log_ctx, 1);
+}
+
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
 {
     Parser p = { 0 };
 
+    if (e->code)
+        return eval_code(e, const_values, opaque);
+
     p.const_values = const_values;
     p.opaque     = opaque;
     return eval_expr(&p, e);
@@ -553,7 +820,8 @@ int av_expr_parse_and_eval(double *d, const char *s,
                            void *opaque, int log_offset, void *log_ctx)
 {
     AVExpr *e = NULL;
-    int ret = av_expr_parse(&e, s, const_names, func1_names, funcs1, func2_names, funcs2, log_offset, log_ctx);
+    /* evaluated only once, not worth compiling */
+    int ret = expr_parse(&e, s, const_names, func1_names, funcs1, func2_names, funcs2, log_offset, log_ctx, 0);
 
     if (ret < 0) {
         *d = NAN;
@@ -567,6 +835,9 @@ int av_expr_parse_and_eval(double *d, const char *s,
 #ifdef TEST
 #include <string.h>
 
+#include "time.h"
+#include "timer.h"
+
 static const double const_values[] = {
     M_PI,
     M_E,
@@ -653,8 +924,17 @@ int main(int argc, char **argv)
         "-3.0103dB",
         NULL
     };
+    static const char *const bench_exprs[] = {
+        "PI-2*E",
+        "max(min(PI*(1+1/2)-16*E/8,235),16)",
+        "PI/(E*25)+2*(3-1)",
+        "gte(PI,E)*not(mod(PI,2))+lt(E*E,100)",
+        NULL
+    };
 
     for (expr = exprs; *expr; expr++) {
+        AVExpr *e;
+
         printf("Evaluating '%s'\n", *expr);
         av_expr_parse_and_eval(&d, *expr,
                                const_names, const_values,
@@ -663,6 +943,15 @@ int main(int argc, char **argv)
             printf("'%s' -> nan\n\n", *expr);
         else
             printf("'%s' -> %f\n\n", *expr, d);
+
+        /* the compiled expression must give the same result */
+        if (av_expr_parse(&e, *expr, const_names,
+                          NULL, NULL, NULL, NULL, 0, NULL) >= 0) {
+            double d2 = av_expr_eval(e, const_values, NULL);
+            if (d2 != d && !(isnan(d) && isnan(d2)))
+                printf("'%s' -> %f when compiled\n\n", *expr, d2);
+            av_expr_free(e);
+        }
     }
 
     av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
@@ -682,6 +971,33 @@ int main(int argc, char **argv)
                                    NULL, NULL, NULL, NULL, NULL, 0, NULL);
             STOP_TIMER("av_expr_parse_and_eval");
         }
+
+        /* expressions of the kind evaluated per frame or per pixel by the
+         * filters, with PI and E standing for the variables */
+        for (expr = bench_exprs; *expr; expr++) {
+            AVExpr *e;
+            uint64_t t;
+
+            if (av_expr_parse(&e, *expr, const_names,
+                              NULL, NULL, NULL, NULL, 0, NULL) < 0)
+                return 1;
+#ifdef AV_READ_TIME
+            t = AV_READ_TIME();
+#else
+            t = av_gettime();
+#endif
+            for (i = 0; i < 100000; i++)
+                d += av_expr_eval(e, const_values, NULL);
+#ifdef AV_READ_TIME
+            t = AV_READ_TIME() - t;
+            printf("%"PRIu64" decicycles per av_expr_eval in %s\n",
+                   t / 10000, *expr);
+#else
+            t = av_gettime() - t;
+            printf("%"PRIu64" ns per av_expr_eval in %s\n", t / 100, *expr);
+#endif
+            av_expr_free(e);
+        }
     }
 
     return 0;
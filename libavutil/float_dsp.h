@@ -159,6 +159,22 @@ typedef struct AVFloatDSPContext {
      * @return sum of elementwise products
      */
     float (*scalarproduct_float)(const float *v1, const float *v2, int len);
+
+    /**
+     * Clip each element of a vector of floats to the range [min, max].
+     * Source and destination vectors must overlap exactly or not at all.
+     *
+     * @param dst output vector
+     *            constraints: 16-byte aligned
+     * @param src input vector
+     *            constraints: 16-byte aligned
+     * @param min lower bound
+     * @param max upper bound
+     * @param len number of elements
+     *            constraints: multiple of 16
+     */
+    void (*vector_clipf)(float *dst, const float *src, float min, float max,
+                         int len);
 } AVFloatDSPContext;
 
 /**
@@ -183,6 +199,6 @@ void avpriv_float_dsp_init(AVFloatDSPContext *fdsp, int strict);
 
 void ff_float_dsp_init_arm(AVFloatDSPContext *fdsp);
 void ff_float_dsp_init_ppc(AVFloatDSPContext *fdsp, int strict);
-void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp);
+void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp, int strict);
 
 #endif /* AVUTIL_FLOAT_DSP_H */
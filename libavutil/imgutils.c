@@ -21,10 +21,18 @@
  * misc image utilities
  */
 
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "common.h"
+#include "cpu.h"
 #include "imgutils.h"
+#include "imgutils_internal.h"
 #include "internal.h"
 #include "log.h"
+#include "mem.h"
 #include "pixdesc.h"
 
 void av_image_fill_max_pixsteps(int max_pixsteps[4], int max_pixstep_comps[4],
@@ -228,12 +236,46 @@ int av_image_check_size(unsigned int w, unsigned int h, int log_offset, void *lo
     return AVERROR(EINVAL);
 }
 
-void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
+/* planes at least this large are written with non-temporal stores, they
+ * would not stay in the cache anyway */
+#define STREAM_COPY_MIN_SIZE (1 << 22)
+/* minimum number of bytes copied by each thread */
+#define THREAD_COPY_MIN_SIZE (1 << 21)
+#define MAX_COPY_THREADS     16
+
+#if HAVE_PTHREADS
+typedef struct CopySlice {
+    uint8_t       *dst;
+    const uint8_t *src;
+    int height;
+} CopySlice;
+#endif
+
+struct AVImageCopyContext {
+    int nb_threads;
+#if HAVE_PTHREADS
+    pthread_t workers[MAX_COPY_THREADS - 1];
+    int nb_workers;
+
+    ImageCopyPlaneFunc copy;
+    CopySlice slices[MAX_COPY_THREADS];
+    int dst_linesize, src_linesize;
+    int bytewidth;
+    int nb_slices;
+    int next_slice;
+    int slices_done;
+    int done;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+#endif
+};
+
+static void copy_plane_c(uint8_t       *dst, int dst_linesize,
                          const uint8_t *src, int src_linesize,
                          int bytewidth, int height)
 {
-    if (!dst || !src)
-        return;
     for (;height > 0; height--) {
         memcpy(dst, src, bytewidth);
         dst += dst_linesize;
@@ -241,9 +283,176 @@ void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
     }
 }
 
-void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
-                   const uint8_t *src_data[4], const int src_linesizes[4],
-                   enum AVPixelFormat pix_fmt, int width, int height)
+#if HAVE_PTHREADS
+/* copy queued slices until there are none left, must be called with the lock
+ * held */
+static void copy_slices(AVImageCopyContext *c)
+{
+    while (c->next_slice < c->nb_slices) {
+        CopySlice *s = &c->slices[c->next_slice++];
+
+        pthread_mutex_unlock(&c->lock);
+        c->copy(s->dst, c->dst_linesize, s->src, c->src_linesize,
+                c->bytewidth, s->height);
+        pthread_mutex_lock(&c->lock);
+
+        if (++c->slices_done == c->nb_slices)
+            pthread_cond_signal(&c->done_cond);
+    }
+}
+
+static void *attribute_align_arg copy_worker(void *arg)
+{
+    AVImageCopyContext *c = arg;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        while (!c->done && c->next_slice >= c->nb_slices)
+            pthread_cond_wait(&c->job_cond, &c->lock);
+        if (c->done)
+            break;
+        copy_slices(c);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    return NULL;
+}
+
+/* split the lines between nb_slices slices, copied by the workers and the
+ * calling thread */
+static void copy_plane_threads(AVImageCopyContext *c, ImageCopyPlaneFunc copy,
+                               int nb_slices,
+                               uint8_t       *dst, int dst_linesize,
+                               const uint8_t *src, int src_linesize,
+                               int bytewidth, int height)
+{
+    int i, y = 0;
+
+    pthread_mutex_lock(&c->lock);
+    for (i = 0; i < nb_slices; i++) {
+        int next = height * (i + 1) / nb_slices;
+
+        c->slices[i].dst    = dst + (ptrdiff_t)y * dst_linesize;
+        c->slices[i].src    = src + (ptrdiff_t)y * src_linesize;
+        c->slices[i].height = next - y;
+        y = next;
+    }
+    c->copy         = copy;
+    c->dst_linesize = dst_linesize;
+    c->src_linesize = src_linesize;
+    c->bytewidth    = bytewidth;
+    c->nb_slices    = nb_slices;
+    c->next_slice   = 0;
+    c->slices_done  = 0;
+    pthread_cond_broadcast(&c->job_cond);
+
+    copy_slices(c);
+    while (c->slices_done < c->nb_slices)
+        pthread_cond_wait(&c->done_cond, &c->lock);
+    pthread_mutex_unlock(&c->lock);
+}
+#endif
+
+AVImageCopyContext *av_image_copy_context_alloc(int nb_threads)
+{
+    AVImageCopyContext *c = av_mallocz(sizeof(*c));
+
+    if (!c)
+        return NULL;
+
+    if (nb_threads <= 0)
+        nb_threads = av_cpu_count();
+    c->nb_threads = av_clip(nb_threads, 1, MAX_COPY_THREADS);
+
+#if HAVE_PTHREADS
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->job_cond, NULL);
+    pthread_cond_init(&c->done_cond, NULL);
+
+    /* the calling thread copies as well */
+    for (; c->nb_workers < c->nb_threads - 1; c->nb_workers++) {
+        if (pthread_create(&c->workers[c->nb_workers], NULL, copy_worker, c)) {
+            av_image_copy_context_free(&c);
+            return NULL;
+        }
+    }
+#else
+    c->nb_threads = 1;
+#endif
+    return c;
+}
+
+void av_image_copy_context_free(AVImageCopyContext **pc)
+{
+    AVImageCopyContext *c = *pc;
+#if HAVE_PTHREADS
+    int i;
+#endif
+
+    if (!c)
+        return;
+
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&c->lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->job_cond);
+    pthread_mutex_unlock(&c->lock);
+
+    for (i = 0; i < c->nb_workers; i++)
+        pthread_join(c->workers[i], NULL);
+
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->job_cond);
+    pthread_cond_destroy(&c->done_cond);
+#endif
+    av_freep(pc);
+}
+
+void av_image_copy_plane2(AVImageCopyContext *c,
+                          uint8_t       *dst, int dst_linesize,
+                          const uint8_t *src, int src_linesize,
+                          int bytewidth, int height)
+{
+    ImageCopyPlaneFunc copy = copy_plane_c;
+    int64_t size = (int64_t)bytewidth * height;
+
+    if (!dst || !src || bytewidth <= 0 || height <= 0)
+        return;
+
+#if ARCH_X86
+    if (size >= STREAM_COPY_MIN_SIZE) {
+        ImageCopyPlaneFunc stream_copy =
+            ff_image_copy_plane_stream_x86(av_get_cpu_flags());
+        if (stream_copy)
+            copy = stream_copy;
+    }
+#endif
+
+#if HAVE_PTHREADS
+    if (c && c->nb_threads > 1 && size >= 2 * THREAD_COPY_MIN_SIZE &&
+        height > 1) {
+        int nb_slices = FFMIN(c->nb_threads, size / THREAD_COPY_MIN_SIZE);
+        nb_slices = FFMIN(nb_slices, height);
+        copy_plane_threads(c, copy, nb_slices, dst, dst_linesize,
+                           src, src_linesize, bytewidth, height);
+        return;
+    }
+#endif
+    copy(dst, dst_linesize, src, src_linesize, bytewidth, height);
+}
+
+void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
+                         const uint8_t *src, int src_linesize,
+                         int bytewidth, int height)
+{
+    av_image_copy_plane2(NULL, dst, dst_linesize, src, src_linesize,
+                         bytewidth, height);
+}
+
+void av_image_copy2(AVImageCopyContext *c,
+                    uint8_t *dst_data[4], int dst_linesizes[4],
+                    const uint8_t *src_data[4], const int src_linesizes[4],
+                    enum AVPixelFormat pix_fmt, int width, int height)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
 
@@ -252,9 +461,9 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
 
     if (desc->flags & PIX_FMT_PAL ||
         desc->flags & PIX_FMT_PSEUDOPAL) {
-        av_image_copy_plane(dst_data[0], dst_linesizes[0],
-                            src_data[0], src_linesizes[0],
-                            width, height);
+        av_image_copy_plane2(c, dst_data[0], dst_linesizes[0],
+                             src_data[0], src_linesizes[0],
+                             width, height);
         /* copy the palette */
         memcpy(dst_data[1], src_data[1], 4*256);
     } else {
@@ -269,9 +478,97 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
             if (i == 1 || i == 2) {
                 h= -((-height)>>desc->log2_chroma_h);
             }
-            av_image_copy_plane(dst_data[i], dst_linesizes[i],
-                                src_data[i], src_linesizes[i],
-                                bwidth, h);
+            av_image_copy_plane2(c, dst_data[i], dst_linesizes[i],
+                                 src_data[i], src_linesizes[i],
+                                 bwidth, h);
         }
     }
 }
+
+void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
+                   const uint8_t *src_data[4], const int src_linesizes[4],
+                   enum AVPixelFormat pix_fmt, int width, int height)
+{
+    av_image_copy2(NULL, dst_data, dst_linesizes, src_data, src_linesizes,
+                   pix_fmt, width, height);
+}
+
+#ifdef TEST
+#include "avassert.h"
+
+/* copy a plane with copy and with copy_plane_c into two buffers filled
+ * alike, the whole buffers must match so that writes outside the plane are
+ * caught as well */
+static void check_copy(AVImageCopyContext *c, ImageCopyPlaneFunc copy,
+                       int bytewidth, int height, int src_offset,
+                       int dst_offset, int flip)
+{
+    int linesize = FFALIGN(bytewidth + 64, 64);
+    int size     = linesize * height + 64;
+    uint8_t *src = av_malloc(size);
+    uint8_t *ref = av_malloc(size);
+    uint8_t *dst = av_malloc(size);
+    /* with flip, the planes start with the last line of the buffers */
+    int start    = src_offset + (flip ? linesize * (height - 1) : 0);
+    int step     = flip ? -linesize : linesize;
+    int i;
+
+    av_assert0(src && ref && dst);
+    for (i = 0; i < size; i++)
+        src[i] = i * 7 + (i >> 8);
+    memset(ref, 0xAA, size);
+    memset(dst, 0xAA, size);
+
+    copy_plane_c(ref + start - src_offset + dst_offset, step,
+                 src + start, step, bytewidth, height);
+    if (copy)
+        copy(dst + start - src_offset + dst_offset, step,
+             src + start, step, bytewidth, height);
+    else
+        av_image_copy_plane2(c, dst + start - src_offset + dst_offset, step,
+                             src + start, step, bytewidth, height);
+    av_assert0(!memcmp(ref, dst, size));
+
+    av_free(src);
+    av_free(ref);
+    av_free(dst);
+}
+
+int main(void)
+{
+    static const int widths[] = { 1, 15, 16, 63, 64, 65, 127, 200, 1023 };
+    AVImageCopyContext *c;
+    int i, offset, flip;
+
+#if ARCH_X86
+    ImageCopyPlaneFunc stream_copy =
+        ff_image_copy_plane_stream_x86(av_get_cpu_flags());
+
+    /* the streaming copy on unaligned heads and tails, odd widths and
+     * negative linesizes */
+    if (stream_copy) {
+        for (i = 0; i < FF_ARRAY_ELEMS(widths); i++)
+            for (offset = 0; offset < 16; offset += 5)
+                for (flip = 0; flip < 2; flip++) {
+                    check_copy(NULL, stream_copy, widths[i], 5,
+                               offset, 0, flip);
+                    check_copy(NULL, stream_copy, widths[i], 5,
+                               3, offset, flip);
+                }
+    }
+#endif
+
+    /* large planes, copied with the streaming copy and the threads */
+    c = av_image_copy_context_alloc(4);
+    av_assert0(c);
+    for (flip = 0; flip < 2; flip++) {
+        check_copy(NULL, NULL, 4093, 1500, 1, 3, flip);
+        check_copy(c,    NULL, 4093, 1500, 1, 3, flip);
+        check_copy(c,    NULL, 4096, 1100, 0, 0, flip);
+    }
+    av_image_copy_context_free(&c);
+    av_assert0(!c);
+
+    return 0;
+}
+#endif
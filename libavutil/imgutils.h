@@ -106,6 +106,42 @@ void av_image_copy_plane(uint8_t       *dst, int dst_linesize,
                          const uint8_t *src, int src_linesize,
                          int bytewidth, int height);
 
+/**
+ * Context for splitting the copy of large planes between several threads,
+ * see av_image_copy_plane2(). The threads are started when the context is
+ * allocated and reused by every copy made with it.
+ */
+typedef struct AVImageCopyContext AVImageCopyContext;
+
+/**
+ * Allocate an AVImageCopyContext.
+ *
+ * @param nb_threads number of threads copying, the calling one included,
+ *                   0 for one per CPU
+ * @return the context, or NULL on failure
+ */
+AVImageCopyContext *av_image_copy_context_alloc(int nb_threads);
+
+/**
+ * Stop the threads of an AVImageCopyContext and free it.
+ *
+ * @param ctx the context to free, set to NULL
+ */
+void av_image_copy_context_free(AVImageCopyContext **ctx);
+
+/**
+ * Copy image plane from src to dst like av_image_copy_plane(), splitting the
+ * copy of a large plane between the threads of ctx.
+ *
+ * A context must not be used by several copies at once.
+ *
+ * @param ctx the threads to use, or NULL to copy in the calling thread only
+ */
+void av_image_copy_plane2(AVImageCopyContext *ctx,
+                          uint8_t       *dst, int dst_linesize,
+                          const uint8_t *src, int src_linesize,
+                          int bytewidth, int height);
+
 /**
  * Copy image in src_data to dst_data.
  *
@@ -116,6 +152,17 @@ void av_image_copy(uint8_t *dst_data[4], int dst_linesizes[4],
                    const uint8_t *src_data[4], const int src_linesizes[4],
                    enum AVPixelFormat pix_fmt, int width, int height);
 
+/**
+ * Copy image in src_data to dst_data like av_image_copy(), splitting the
+ * copy of the large planes between the threads of ctx.
+ *
+ * @param ctx the threads to use, or NULL to copy in the calling thread only
+ */
+void av_image_copy2(AVImageCopyContext *ctx,
+                    uint8_t *dst_data[4], int dst_linesizes[4],
+                    const uint8_t *src_data[4], const int src_linesizes[4],
+                    enum AVPixelFormat pix_fmt, int width, int height);
+
 /**
  * Check if the given dimension of an image is valid, meaning that all
  * bytes of the image can be addressed with a signed int.
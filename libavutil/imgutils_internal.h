@@ -0,0 +1,36 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_IMGUTILS_INTERNAL_H
+#define AVUTIL_IMGUTILS_INTERNAL_H
+
+#include <stdint.h>
+
+typedef void (*ImageCopyPlaneFunc)(uint8_t       *dst, int dst_linesize,
+                                   const uint8_t *src, int src_linesize,
+                                   int bytewidth, int height);
+
+/**
+ * Get a plane copy function writing the destination with non-temporal
+ * stores, so that copying a large plane does not evict the whole cache.
+ *
+ * @return the function, or NULL if the CPU has no such stores
+ */
+ImageCopyPlaneFunc ff_image_copy_plane_stream_x86(int cpu_flags);
+
+#endif /* AVUTIL_IMGUTILS_INTERNAL_H */
@@ -91,6 +91,12 @@
 #   define LOCAL_ALIGNED_16(t, v, ...) LOCAL_ALIGNED(16, t, v, __VA_ARGS__)
 #endif
 
+#if HAVE_LOCAL_ALIGNED_32
+#   define LOCAL_ALIGNED_32(t, v, ...) E1(LOCAL_ALIGNED_D(32, t, v, __VA_ARGS__,,))
+#else
+#   define LOCAL_ALIGNED_32(t, v, ...) LOCAL_ALIGNED(32, t, v, __VA_ARGS__)
+#endif
+
 #define FF_ALLOC_OR_GOTO(ctx, p, size, label)\
 {\
     p = av_malloc(size);\
@@ -109,6 +115,23 @@
     }\
 }
 
+/*
+ * MEM_TAG_START(var, name) must be the last declaration of its block, the
+ * memory allocated by the calling thread until MEM_TAG_STOP(var) is then
+ * accounted to the memory tag called name.
+ */
+#if CONFIG_MEMORY_STATS
+#define MEM_TAG_START(var, name)                                          \
+    static int mem_tag_id_##var;                                          \
+    int mem_tag_prev_##var = av_mem_tag_set(mem_tag_id_##var ?            \
+        mem_tag_id_##var : (mem_tag_id_##var = av_mem_tag_register(name)))
+
+#define MEM_TAG_STOP(var) av_mem_tag_set(mem_tag_prev_##var)
+#else
+#define MEM_TAG_START(var, name)
+#define MEM_TAG_STOP(var) do { } while (0)
+#endif
+
 #include "libm.h"
 
 /**
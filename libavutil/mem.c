@@ -26,6 +26,11 @@
 
 #include "config.h"
 
+#if HAVE_MADVISE
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#endif
+#include <inttypes.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -33,8 +38,14 @@
 #if HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#if CONFIG_MEMORY_STATS && HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
+#include "avstring.h"
 #include "avutil.h"
+#include "common.h"
+#include "error.h"
 #include "intreadwrite.h"
 #include "mem.h"
 
@@ -54,11 +65,12 @@ void  free(void *ptr);
 
 #endif /* MALLOC_PREFIX */
 
-/* You can redefine av_malloc and av_free in your project to use your
- * memory allocator. You do not need to suppress this file because the
- * linker will do it automatically. */
+#if HAVE_POSIX_MEMALIGN && HAVE_MADVISE && defined(MADV_HUGEPAGE) && \
+    !CONFIG_MEMALIGN_HACK
+#define HUGE_PAGE_SIZE (2 << 20)
+#endif
 
-void *av_malloc(size_t size)
+static void *mem_alloc(size_t size, int flags)
 {
     void *ptr = NULL;
 #if CONFIG_MEMALIGN_HACK
@@ -69,6 +81,17 @@ void *av_malloc(size_t size)
     if (size > (INT_MAX - 32) || !size)
         return NULL;
 
+#ifdef HUGE_PAGE_SIZE
+    /* align the block on a huge page so that the kernel can back all of it
+     * but its tail with huge pages, the smaller blocks cannot use them */
+    if ((flags & AV_MALLOC_HUGE_PAGES) && size >= HUGE_PAGE_SIZE) {
+        if (posix_memalign(&ptr, HUGE_PAGE_SIZE, size))
+            return NULL;
+        madvise(ptr, size, MADV_HUGEPAGE);
+        return ptr;
+    }
+#endif
+
 #if CONFIG_MEMALIGN_HACK
     ptr = malloc(size + 32);
     if (!ptr)
@@ -113,7 +136,7 @@ void *av_malloc(size_t size)
     return ptr;
 }
 
-void *av_realloc(void *ptr, size_t size)
+static void *mem_realloc(void *ptr, size_t size)
 {
 #if CONFIG_MEMALIGN_HACK
     int diff;
@@ -126,7 +149,7 @@ void *av_realloc(void *ptr, size_t size)
 #if CONFIG_MEMALIGN_HACK
     //FIXME this isn't aligned correctly, though it probably isn't needed
     if (!ptr)
-        return av_malloc(size);
+        return mem_alloc(size, 0);
     diff = ((char *)ptr)[-1];
     return (char *)realloc((char *)ptr - diff, size + diff) + diff;
 #elif HAVE_ALIGNED_MALLOC
@@ -136,7 +159,7 @@ void *av_realloc(void *ptr, size_t size)
 #endif
 }
 
-void av_free(void *ptr)
+static void mem_free(void *ptr)
 {
 #if CONFIG_MEMALIGN_HACK
     if (ptr)
@@ -148,6 +171,310 @@ void av_free(void *ptr)
 #endif
 }
 
+#if CONFIG_MEMORY_STATS
+
+#define MAX_MEM_TAGS 64
+
+/*
+ * Every block starts with a header recording its size and the tag it is
+ * accounted to, the header size keeps the alignment of the user data.
+ */
+#define MEM_HEADER_SIZE 32
+
+typedef struct MemHeader {
+    size_t size;
+    int tag;            /* -1 if the block is not accounted */
+} MemHeader;
+
+static const char    *tag_names[MAX_MEM_TAGS] = { "other" };
+static AVMemTagStats  tag_stats[MAX_MEM_TAGS];
+static int            nb_tags = 1;
+static volatile int   stats_enabled;
+
+#if HAVE_PTHREADS
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  mem_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   mem_key;
+static int             mem_key_ok;
+
+static void mem_key_init(void)
+{
+    mem_key_ok = !pthread_key_create(&mem_key, NULL);
+}
+
+#define LOCK()   pthread_mutex_lock(&mem_lock)
+#define UNLOCK() pthread_mutex_unlock(&mem_lock)
+#else
+static int current_tag;
+
+#define LOCK()
+#define UNLOCK()
+#endif
+
+void av_mem_stats_enable(int enable)
+{
+    stats_enabled = enable;
+}
+
+int av_mem_tag_register(const char *name)
+{
+    int i, ret;
+
+    LOCK();
+    for (i = 0; i < nb_tags; i++)
+        if (!strcmp(tag_names[i], name))
+            break;
+    if (i == nb_tags && nb_tags < MAX_MEM_TAGS)
+        tag_names[nb_tags++] = name;
+    ret = i < nb_tags ? i : AVERROR(ENOMEM);
+    UNLOCK();
+
+    return ret;
+}
+
+int av_mem_tag_get(void)
+{
+    if (!stats_enabled)
+        return 0;
+#if HAVE_PTHREADS
+    if (!mem_key_ok)
+        return 0;
+    return (intptr_t)pthread_getspecific(mem_key);
+#else
+    return current_tag;
+#endif
+}
+
+int av_mem_tag_set(int tag)
+{
+    int prev;
+
+    if (!stats_enabled)
+        return 0;
+    if (tag < 0 || tag >= MAX_MEM_TAGS)
+        tag = 0;
+
+#if HAVE_PTHREADS
+    pthread_once(&mem_once, mem_key_init);
+    if (!mem_key_ok)
+        return 0;
+    prev = (intptr_t)pthread_getspecific(mem_key);
+    pthread_setspecific(mem_key, (void *)(intptr_t)tag);
+#else
+    prev        = current_tag;
+    current_tag = tag;
+#endif
+
+    return prev;
+}
+
+static void account_alloc(MemHeader *h, size_t size, int tag)
+{
+    AVMemTagStats *s;
+
+    h->size = size;
+    h->tag  = stats_enabled ? tag : -1;
+    if (h->tag < 0)
+        return;
+
+    s = &tag_stats[h->tag];
+    LOCK();
+    s->live += size;
+    s->peak  = FFMAX(s->peak, s->live);
+    s->nb_allocs++;
+    UNLOCK();
+}
+
+static void account_free(MemHeader *h)
+{
+    AVMemTagStats *s;
+
+    if (h->tag < 0)
+        return;
+
+    s = &tag_stats[h->tag];
+    LOCK();
+    s->live -= h->size;
+    s->nb_frees++;
+    UNLOCK();
+}
+
+int av_mem_get_stats(AVMemTagStats **pstats)
+{
+    AVMemTagStats *stats;
+    int i, nb;
+
+    /* allocated before taking the lock, the tags registered in the meantime
+     * are simply not reported */
+    nb = nb_tags;
+    if (!(stats = av_malloc(nb * sizeof(*stats)))) {
+        *pstats = NULL;
+        return AVERROR(ENOMEM);
+    }
+
+    LOCK();
+    for (i = 0; i < nb; i++) {
+        stats[i]      = tag_stats[i];
+        stats[i].name = tag_names[i];
+    }
+    UNLOCK();
+
+    *pstats = stats;
+    return nb;
+}
+
+void *av_malloc_flags(size_t size, int flags)
+{
+    MemHeader *h;
+
+    if (size > INT_MAX - 32 - MEM_HEADER_SIZE || !size)
+        return NULL;
+
+    h = mem_alloc(size + MEM_HEADER_SIZE, flags);
+    if (!h)
+        return NULL;
+    account_alloc(h, size, av_mem_tag_get());
+
+    return (uint8_t *)h + MEM_HEADER_SIZE;
+}
+
+void *av_realloc(void *ptr, size_t size)
+{
+    MemHeader *h = NULL;
+    int tag = -1;
+
+    if (size > INT_MAX - 16 - MEM_HEADER_SIZE)
+        return NULL;
+
+    if (ptr) {
+        h = (MemHeader *)((uint8_t *)ptr - MEM_HEADER_SIZE);
+        account_free(h);
+        tag = h->tag;
+    }
+    /* the block keeps its tag, unless it was not accounted until now */
+    if (tag < 0)
+        tag = av_mem_tag_get();
+
+    ptr = mem_realloc(h, size + MEM_HEADER_SIZE);
+    if (!ptr) {
+        /* the old block is still valid */
+        if (h && h->tag >= 0) {
+            LOCK();
+            tag_stats[h->tag].live += h->size;
+            tag_stats[h->tag].nb_frees--;
+            UNLOCK();
+        }
+        return NULL;
+    }
+    h = ptr;
+    account_alloc(h, size, tag);
+
+    return (uint8_t *)h + MEM_HEADER_SIZE;
+}
+
+void av_free(void *ptr)
+{
+    MemHeader *h;
+
+    if (!ptr)
+        return;
+
+    h = (MemHeader *)((uint8_t *)ptr - MEM_HEADER_SIZE);
+    account_free(h);
+    mem_free(h);
+}
+
+#else
+
+/* You can redefine av_malloc and av_free in your project to use your
+ * memory allocator. You do not need to suppress this file because the
+ * linker will do it automatically. */
+
+void *av_malloc_flags(size_t size, int flags)
+{
+    return mem_alloc(size, flags);
+}
+
+void *av_realloc(void *ptr, size_t size)
+{
+    return mem_realloc(ptr, size);
+}
+
+void av_free(void *ptr)
+{
+    mem_free(ptr);
+}
+
+void av_mem_stats_enable(int enable)
+{
+}
+
+int av_mem_tag_register(const char *name)
+{
+    return AVERROR(ENOSYS);
+}
+
+int av_mem_tag_get(void)
+{
+    return 0;
+}
+
+int av_mem_tag_set(int tag)
+{
+    return 0;
+}
+
+int av_mem_get_stats(AVMemTagStats **stats)
+{
+    *stats = NULL;
+    return 0;
+}
+
+#endif /* CONFIG_MEMORY_STATS */
+
+char *av_mem_dump_stats(void)
+{
+    AVMemTagStats *stats;
+    char *buf;
+    size_t size;
+    int nb, i, first = 1;
+
+    if ((nb = av_mem_get_stats(&stats)) <= 0)
+        return NULL;
+
+    size = 128 * (nb + 1);
+    if (!(buf = av_malloc(size))) {
+        av_free(stats);
+        return NULL;
+    }
+    buf[0] = 0;
+
+    av_strlcatf(buf, size, "%-32s %14s %14s %12s %12s\n",
+                "memory tag", "live bytes", "peak bytes", "allocs", "frees");
+    for (i = 0; i < nb; i++) {
+        AVMemTagStats *s = &stats[i];
+
+        if (!s->nb_allocs)
+            continue;
+        av_strlcatf(buf, size, "%-32s %14"PRId64" %14"PRId64" %12"PRIu64
+                    " %12"PRIu64"\n", s->name, s->live, s->peak,
+                    s->nb_allocs, s->nb_frees);
+        first = 0;
+    }
+
+    av_free(stats);
+    if (first) {
+        av_free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+void *av_malloc(size_t size)
+{
+    return av_malloc_flags(size, 0);
+}
+
 void av_freep(void *arg)
 {
     void **ptr = (void **)arg;
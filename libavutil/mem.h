@@ -81,6 +81,22 @@
  */
 void *av_malloc(size_t size) av_malloc_attrib av_alloc_size(1);
 
+/**
+ * Back the block with huge pages if the system supports it, which saves TLB
+ * misses when accessing large blocks such as video frames. It is only a hint,
+ * it is ignored for blocks smaller than a huge page (usually 2 MiB).
+ */
+#define AV_MALLOC_HUGE_PAGES (1 << 0)
+
+/**
+ * Allocate a block of size bytes like av_malloc(), with additional hints
+ * about its use. The block can be reallocated and freed like any block
+ * allocated with av_malloc().
+ * @param flags a combination of AV_MALLOC_*
+ * @see av_malloc()
+ */
+void *av_malloc_flags(size_t size, int flags) av_malloc_attrib av_alloc_size(1);
+
 /**
  * Helper function to allocate a block of size * nmemb bytes with
  * using av_malloc()
@@ -176,6 +192,89 @@ void av_freep(void *ptr);
  */
 void av_memcpy_backptr(uint8_t *dst, int back, int cnt);
 
+/**
+ * @defgroup lavu_mem_stats Memory statistics
+ * @{
+ * When Libav is configured with --enable-memory-stats, the memory allocated
+ * by av_malloc() and av_realloc() can be accounted per memory tag, e.g. to
+ * find out whether the frame pools, the packet queues or the index entries are
+ * responsible for the memory usage of a process. The accounting must be
+ * enabled at runtime with av_mem_stats_enable(), only the blocks allocated
+ * while it is enabled are accounted.
+ *
+ * Each thread has a current memory tag, the blocks it allocates are accounted
+ * to that tag. The libraries tag their main data structures, the memory that
+ * was allocated without any tag is accounted to the "other" tag. The functions
+ * below do nothing when the memory statistics are not compiled in.
+ */
+
+typedef struct AVMemTagStats {
+    /**
+     * Name of the memory tag.
+     */
+    const char *name;
+    /**
+     * Number of bytes currently allocated and highest value it reached.
+     */
+    int64_t live;
+    int64_t peak;
+    /**
+     * Number of blocks allocated and freed.
+     */
+    uint64_t nb_allocs;
+    uint64_t nb_frees;
+} AVMemTagStats;
+
+/**
+ * Enable or disable the accounting of the allocated memory. It should be
+ * enabled as early as possible, before other threads are started.
+ */
+void av_mem_stats_enable(int enable);
+
+/**
+ * Get the identifier of a memory tag, registering it if needed.
+ *
+ * @param name name of the tag, the string must stay valid until the process
+ *             exits
+ * @return the tag identifier (>= 0) or a negative AVERROR code on failure
+ */
+int av_mem_tag_register(const char *name);
+
+/**
+ * Set the memory tag of the calling thread.
+ *
+ * @return the previous memory tag of the thread, to be restored when the
+ *         tagged allocations are done
+ */
+int av_mem_tag_set(int tag);
+
+/**
+ * @return the memory tag of the calling thread
+ */
+int av_mem_tag_get(void);
+
+/**
+ * Get the statistics of all the memory tags.
+ *
+ * @param stats pointer to be set to a newly allocated array of statistics,
+ *              which must be freed with av_free()
+ * @return the number of tags (possibly 0, then *stats is NULL), or a negative
+ *         AVERROR code on failure
+ */
+int av_mem_get_stats(AVMemTagStats **stats);
+
+/**
+ * Format the statistics of all the memory tags that were used.
+ *
+ * @return a newly allocated string, which must be freed with av_free(), or
+ *         NULL if there is nothing to report or on allocation failure
+ */
+char *av_mem_dump_stats(void);
+
+/**
+ * @}
+ */
+
 /**
  * @}
  */
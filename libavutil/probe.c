@@ -0,0 +1,278 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#if CONFIG_PROBES && HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "avstring.h"
+#include "common.h"
+#include "error.h"
+#include "mem.h"
+#include "probe.h"
+#include "timer.h"
+
+const char *av_probe_time_unit(void)
+{
+#ifdef AV_READ_TIME
+    return "cycles";
+#else
+    return "us";
+#endif
+}
+
+#if CONFIG_PROBES
+
+#define MAX_PROBES 64
+
+/* the measurements of one thread, they are never freed so that the
+ * statistics of the threads that exited remain available */
+typedef struct ProbeThread {
+    struct ProbeThread *next;
+    AVProbeStats stats[MAX_PROBES];
+} ProbeThread;
+
+static const char  *probe_names[MAX_PROBES];
+static volatile int nb_probes;
+static ProbeThread *threads;
+
+#if HAVE_PTHREADS
+static pthread_mutex_t probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  probe_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   probe_key;
+static int             probe_key_ok;
+
+static void probe_key_init(void)
+{
+    probe_key_ok = !pthread_key_create(&probe_key, NULL);
+}
+
+#define LOCK()   pthread_mutex_lock(&probe_lock)
+#define UNLOCK() pthread_mutex_unlock(&probe_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
+
+static ProbeThread *get_thread(void)
+{
+    ProbeThread *th;
+
+#if HAVE_PTHREADS
+    pthread_once(&probe_once, probe_key_init);
+    if (!probe_key_ok)
+        return NULL;
+    if ((th = pthread_getspecific(probe_key)))
+        return th;
+#else
+    if ((th = threads))
+        return th;
+#endif
+
+    if (!(th = av_mallocz(sizeof(*th))))
+        return NULL;
+#if HAVE_PTHREADS
+    pthread_setspecific(probe_key, th);
+#endif
+    LOCK();
+    th->next = threads;
+    threads  = th;
+    UNLOCK();
+
+    return th;
+}
+
+int avpriv_probe_register(const char *name)
+{
+    int i, ret;
+
+    LOCK();
+    for (i = 0; i < nb_probes; i++)
+        if (!strcmp(probe_names[i], name))
+            break;
+    if (i == nb_probes && nb_probes < MAX_PROBES)
+        probe_names[nb_probes++] = name;
+    ret = i < nb_probes ? i + 1 : -1;
+    UNLOCK();
+
+    return ret;
+}
+
+void avpriv_probe_record(int id, uint64_t duration)
+{
+    ProbeThread *th;
+    AVProbeStats *s;
+    int bucket;
+
+    if (id <= 0 || !(th = get_thread()))
+        return;
+    s = &th->stats[id - 1];
+
+    if (!s->count || duration < s->min)
+        s->min = duration;
+    if (duration > s->max)
+        s->max = duration;
+    s->count++;
+    s->total += duration;
+
+    bucket = duration >> 32 ? 32 + av_log2(duration >> 32) : av_log2(duration);
+    s->histogram[bucket]++;
+}
+
+int av_probe_get_stats(AVProbeStats **pstats)
+{
+    AVProbeStats *stats;
+    ProbeThread *th;
+    int i, j, nb;
+
+    *pstats = NULL;
+
+    LOCK();
+    if (!(nb = nb_probes)) {
+        UNLOCK();
+        return 0;
+    }
+    if (!(stats = av_mallocz(nb * sizeof(*stats)))) {
+        UNLOCK();
+        return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < nb; i++)
+        stats[i].name = probe_names[i];
+    for (th = threads; th; th = th->next) {
+        for (i = 0; i < nb; i++) {
+            AVProbeStats *dst = &stats[i], *src = &th->stats[i];
+
+            if (!src->count)
+                continue;
+            if (!dst->count || src->min < dst->min)
+                dst->min = src->min;
+            dst->max    = FFMAX(dst->max, src->max);
+            dst->count += src->count;
+            dst->total += src->total;
+            for (j = 0; j < AV_PROBE_HISTOGRAM_SIZE; j++)
+                dst->histogram[j] += src->histogram[j];
+        }
+    }
+    UNLOCK();
+
+    *pstats = stats;
+    return nb;
+}
+
+void av_probe_reset(void)
+{
+    ProbeThread *th;
+
+    LOCK();
+    for (th = threads; th; th = th->next)
+        memset(th->stats, 0, sizeof(th->stats));
+    UNLOCK();
+}
+
+#else
+
+int avpriv_probe_register(const char *name)
+{
+    return -1;
+}
+
+void avpriv_probe_record(int id, uint64_t duration)
+{
+}
+
+int av_probe_get_stats(AVProbeStats **stats)
+{
+    *stats = NULL;
+    return 0;
+}
+
+void av_probe_reset(void)
+{
+}
+
+#endif /* CONFIG_PROBES */
+
+/* enough for one probe with its histogram, in either format */
+#define DUMP_PROBE_SIZE (256 + AV_PROBE_HISTOGRAM_SIZE * 24)
+
+char *av_probe_dump(enum AVProbeDumpFormat format)
+{
+    AVProbeStats *stats;
+    char *buf;
+    size_t size;
+    int nb, i, j, first = 1;
+
+    if ((nb = av_probe_get_stats(&stats)) <= 0)
+        return NULL;
+
+    size = 64 + nb * DUMP_PROBE_SIZE;
+    if (!(buf = av_malloc(size))) {
+        av_free(stats);
+        return NULL;
+    }
+    buf[0] = 0;
+
+    if (format == AV_PROBE_DUMP_JSON)
+        av_strlcatf(buf, size, "{ \"unit\": \"%s\", \"probes\": [",
+                    av_probe_time_unit());
+    else
+        av_strlcatf(buf, size, "%-32s %10s %14s %12s %12s %12s\n",
+                    "probe", "count", "total", "average", "min", "max");
+
+    for (i = 0; i < nb; i++) {
+        AVProbeStats *s = &stats[i];
+
+        if (!s->count)
+            continue;
+
+        if (format == AV_PROBE_DUMP_JSON) {
+            av_strlcatf(buf, size, "%s\n  { \"name\": \"%s\", "
+                        "\"count\": %"PRIu64", \"total\": %"PRIu64", "
+                        "\"min\": %"PRIu64", \"max\": %"PRIu64", "
+                        "\"histogram\": [", first ? "" : ",", s->name,
+                        s->count, s->total, s->min, s->max);
+            for (j = 0; j < AV_PROBE_HISTOGRAM_SIZE; j++)
+                av_strlcatf(buf, size, "%s%"PRIu64, j ? ", " : "",
+                            s->histogram[j]);
+            av_strlcatf(buf, size, "] }");
+        } else {
+            av_strlcatf(buf, size, "%-32s %10"PRIu64" %14"PRIu64" %12"PRIu64
+                        " %12"PRIu64" %12"PRIu64"\n", s->name, s->count,
+                        s->total, s->total / s->count, s->min, s->max);
+        }
+        first = 0;
+    }
+
+    if (format == AV_PROBE_DUMP_JSON)
+        av_strlcatf(buf, size, "\n] }\n");
+    else
+        av_strlcatf(buf, size, "(durations in %s)\n", av_probe_time_unit());
+
+    av_free(stats);
+    if (first) {
+        av_free(buf);
+        return NULL;
+    }
+    return buf;
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * statistics of the instrumentation probes
+ */
+
+#ifndef AVUTIL_PROBE_H
+#define AVUTIL_PROBE_H
+
+#include <stdint.h>
+
+/**
+ * @defgroup lavu_probe Instrumentation probes
+ * @ingroup lavu_misc
+ *
+ * @{
+ * The libraries contain named probes measuring the time spent in some of
+ * their functions, e.g. the decoding and encoding calls. The probes are only
+ * compiled in when Libav is configured with --enable-probes, otherwise the
+ * functions below report no probe at all.
+ *
+ * The measurements are accumulated separately by each thread and aggregated
+ * when the statistics are requested. The durations are expressed in CPU
+ * cycles when the platform provides a cycle counter, in microseconds
+ * otherwise, see av_probe_time_unit().
+ */
+
+/**
+ * Number of buckets in the histogram of the durations.
+ */
+#define AV_PROBE_HISTOGRAM_SIZE 64
+
+typedef struct AVProbeStats {
+    /**
+     * Name of the probe.
+     */
+    const char *name;
+    /**
+     * Number of measurements.
+     */
+    uint64_t count;
+    /**
+     * Sum, minimum and maximum of the measured durations.
+     */
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    /**
+     * Log-scale histogram of the durations: histogram[0] counts the durations
+     * below 2, histogram[i] the durations d with 2^i <= d < 2^(i + 1).
+     */
+    uint64_t histogram[AV_PROBE_HISTOGRAM_SIZE];
+} AVProbeStats;
+
+enum AVProbeDumpFormat {
+    AV_PROBE_DUMP_TEXT,
+    AV_PROBE_DUMP_JSON,
+};
+
+/**
+ * Get the statistics of all the probes, aggregated over all the threads.
+ *
+ * @param stats pointer to be set to a newly allocated array of statistics,
+ *              which must be freed with av_free()
+ * @return the number of probes (possibly 0, then *stats is NULL), or a
+ *         negative AVERROR code on failure
+ */
+int av_probe_get_stats(AVProbeStats **stats);
+
+/**
+ * Clear the statistics of all the probes. It should be called while no probe
+ * is being updated.
+ */
+void av_probe_reset(void);
+
+/**
+ * @return the unit of the durations measured by the probes, "cycles" or "us"
+ */
+const char *av_probe_time_unit(void);
+
+/**
+ * Format the statistics of all the probes that were hit at least once.
+ *
+ * @return a newly allocated string, which must be freed with av_free(), or
+ *         NULL if there is nothing to report or on allocation failure
+ */
+char *av_probe_dump(enum AVProbeDumpFormat format);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_PROBE_H */
@@ -0,0 +1,353 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "atomic.h"
+#include "common.h"
+#include "error.h"
+#include "mem.h"
+#include "ring.h"
+#include "time.h"
+
+#define CACHE_LINE_SIZE 64
+
+/* each slot starts with its sequence number, followed by the element */
+#define SLOT_HEADER_SIZE 8
+
+/*
+ * The slots carry sequence numbers: slot i holds the element written at
+ * position pos (pos & mask == i) when its sequence number is pos + 1 and is
+ * free for writing at position pos when its sequence number is pos. Reading
+ * the element at pos sets it to pos + nb_slots, making the slot available for
+ * the next round. The positions only grow and are compared modulo 2^32.
+ */
+struct AVRing {
+    /* next position to write at, shared by the producers */
+    volatile int tail;
+    uint8_t pad0[CACHE_LINE_SIZE - sizeof(int)];
+
+    /* next position to read from, only accessed by the consumer */
+    unsigned head;
+    uint8_t pad1[CACHE_LINE_SIZE - sizeof(int)];
+
+    uint8_t *slots;
+    unsigned mask;
+    unsigned elem_size;
+    unsigned slot_size;
+    int flags;
+
+    volatile int err_write;
+    volatile int err_read;
+
+    /* number of threads waiting on cond */
+    volatile int nb_waiters;
+#if HAVE_PTHREADS
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif
+};
+
+static volatile int *slot_seq(AVRing *ring, unsigned pos)
+{
+    return (volatile int *)(ring->slots + (pos & ring->mask) * ring->slot_size);
+}
+
+static uint8_t *slot_data(AVRing *ring, unsigned pos)
+{
+    return ring->slots + (pos & ring->mask) * ring->slot_size + SLOT_HEADER_SIZE;
+}
+
+AVRing *av_ring_alloc(unsigned nb_elems, unsigned elem_size, int flags)
+{
+    AVRing *ring;
+    unsigned nb_slots = 1, i;
+
+    if (!nb_elems || nb_elems > 1 << 30 || !elem_size ||
+        elem_size > INT_MAX - 2 * SLOT_HEADER_SIZE)
+        return NULL;
+    while (nb_slots < nb_elems)
+        nb_slots <<= 1;
+
+    ring = av_mallocz(sizeof(*ring));
+    if (!ring)
+        return NULL;
+
+    ring->mask      = nb_slots - 1;
+    ring->elem_size = elem_size;
+    ring->slot_size = FFALIGN(SLOT_HEADER_SIZE + elem_size, SLOT_HEADER_SIZE);
+    ring->flags     = flags;
+
+    if (ring->slot_size > INT_MAX / nb_slots ||
+        !(ring->slots = av_malloc(nb_slots * ring->slot_size))) {
+        av_freep(&ring);
+        return NULL;
+    }
+    for (i = 0; i < nb_slots; i++)
+        *slot_seq(ring, i) = i;
+
+#if HAVE_PTHREADS
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->cond, NULL);
+#endif
+
+    return ring;
+}
+
+void av_ring_free(AVRing **pring)
+{
+    AVRing *ring = *pring;
+
+    if (!ring)
+        return;
+
+#if HAVE_PTHREADS
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->cond);
+#endif
+    av_freep(&ring->slots);
+    av_freep(pring);
+}
+
+static int can_write(AVRing *ring)
+{
+    unsigned pos = avpriv_atomic_int_get(&ring->tail);
+    return (int)(avpriv_atomic_int_get(slot_seq(ring, pos)) - pos) >= 0;
+}
+
+static int can_read(AVRing *ring)
+{
+    unsigned pos = ring->head;
+    return avpriv_atomic_int_get(slot_seq(ring, pos)) == (int)(pos + 1);
+}
+
+static int try_write(AVRing *ring, const void *elem)
+{
+    volatile int *seq;
+    unsigned pos;
+
+    if (ring->err_write)
+        return ring->err_write;
+
+    for (;;) {
+        int diff;
+
+        pos  = avpriv_atomic_int_get(&ring->tail);
+        seq  = slot_seq(ring, pos);
+        diff = avpriv_atomic_int_get(seq) - pos;
+
+        if (diff < 0)
+            return AVERROR(EAGAIN);
+        if (!diff) {
+            if (!(ring->flags & AV_RING_MULTI_PRODUCER)) {
+                avpriv_atomic_int_set(&ring->tail, pos + 1);
+                break;
+            }
+            if (avpriv_atomic_int_cas(&ring->tail, pos, pos + 1) == (int)pos)
+                break;
+        }
+        /* another producer took this slot, retry with the next one */
+    }
+
+    memcpy(slot_data(ring, pos), elem, ring->elem_size);
+    avpriv_atomic_int_set(seq, pos + 1);
+
+    return 0;
+}
+
+static int try_read(AVRing *ring, void *elem)
+{
+    unsigned pos = ring->head;
+    volatile int *seq = slot_seq(ring, pos);
+
+    if (avpriv_atomic_int_get(seq) != (int)(pos + 1)) {
+        int err = avpriv_atomic_int_get(&ring->err_read);
+        if (!err)
+            return AVERROR(EAGAIN);
+        /* an element may have been written right before the error was set */
+        if (avpriv_atomic_int_get(seq) != (int)(pos + 1))
+            return err;
+    }
+
+    memcpy(elem, slot_data(ring, pos), ring->elem_size);
+    avpriv_atomic_int_set(seq, pos + ring->mask + 1);
+    ring->head = pos + 1;
+
+    return 0;
+}
+
+/* wait until the operation may succeed or an error is set */
+static int ring_wait(AVRing *ring, int write)
+{
+#if HAVE_PTHREADS
+    avpriv_atomic_int_add_and_fetch(&ring->nb_waiters, 1);
+    pthread_mutex_lock(&ring->lock);
+    while (write ? !can_write(ring) && !ring->err_write :
+                   !can_read(ring)  && !ring->err_read)
+        pthread_cond_wait(&ring->cond, &ring->lock);
+    pthread_mutex_unlock(&ring->lock);
+    avpriv_atomic_int_add_and_fetch(&ring->nb_waiters, -1);
+    return 0;
+#elif HAVE_THREADS
+    av_usleep(1000);
+    return 0;
+#else
+    return AVERROR(EAGAIN);
+#endif
+}
+
+static void ring_wake(AVRing *ring)
+{
+#if HAVE_PTHREADS
+    if (avpriv_atomic_int_get(&ring->nb_waiters)) {
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_broadcast(&ring->cond);
+        pthread_mutex_unlock(&ring->lock);
+    }
+#endif
+}
+
+int av_ring_write(AVRing *ring, const void *elem, int flags)
+{
+    int ret;
+
+    while ((ret = try_write(ring, elem)) == AVERROR(EAGAIN) &&
+           !(flags & AV_RING_NONBLOCK))
+        if ((ret = ring_wait(ring, 1)) < 0)
+            return ret;
+
+    if (!ret)
+        ring_wake(ring);
+    return ret;
+}
+
+int av_ring_read(AVRing *ring, void *elem, int flags)
+{
+    int ret;
+
+    while ((ret = try_read(ring, elem)) == AVERROR(EAGAIN) &&
+           !(flags & AV_RING_NONBLOCK))
+        if ((ret = ring_wait(ring, 0)) < 0)
+            return ret;
+
+    if (!ret)
+        ring_wake(ring);
+    return ret;
+}
+
+static void set_err(AVRing *ring, volatile int *err_ptr, int err)
+{
+    avpriv_atomic_int_set(err_ptr, err);
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+#endif
+}
+
+void av_ring_set_err_write(AVRing *ring, int err)
+{
+    set_err(ring, &ring->err_write, err);
+}
+
+void av_ring_set_err_read(AVRing *ring, int err)
+{
+    set_err(ring, &ring->err_read, err);
+}
+
+#ifdef TEST
+#include "avassert.h"
+
+#define NB_PRODUCERS 4
+#define NB_ELEMS     100000
+
+static AVRing *test_ring;
+
+static void *producer(void *arg)
+{
+    int id = (intptr_t)arg, i;
+
+    for (i = 0; i < NB_ELEMS; i++) {
+        int val = id * NB_ELEMS + i;
+        if (av_ring_write(test_ring, &val, 0) < 0)
+            break;
+    }
+    return NULL;
+}
+
+static void test_threads(int nb_producers)
+{
+#if HAVE_PTHREADS
+    pthread_t threads[NB_PRODUCERS];
+    int next[NB_PRODUCERS] = { 0 };
+    int i, val;
+
+    test_ring = av_ring_alloc(16, sizeof(int),
+                              nb_producers > 1 ? AV_RING_MULTI_PRODUCER : 0);
+    av_assert0(test_ring);
+
+    for (i = 0; i < nb_producers; i++)
+        pthread_create(&threads[i], NULL, producer, (void *)(intptr_t)i);
+
+    /* the elements of each producer must arrive in order */
+    for (i = 0; i < nb_producers * NB_ELEMS; i++) {
+        av_assert0(!av_ring_read(test_ring, &val, 0));
+        av_assert0(val % NB_ELEMS == next[val / NB_ELEMS]++);
+    }
+
+    for (i = 0; i < nb_producers; i++)
+        pthread_join(threads[i], NULL);
+
+    av_ring_set_err_read(test_ring, AVERROR_EOF);
+    av_assert0(av_ring_read(test_ring, &val, 0) == AVERROR_EOF);
+    av_ring_free(&test_ring);
+#endif
+}
+
+int main(void)
+{
+    AVRing *ring = av_ring_alloc(5, sizeof(int), 0);
+    int i, val;
+
+    /* the size is rounded up to 8 */
+    for (i = 0; i < 8; i++)
+        av_assert0(!av_ring_write(ring, &i, AV_RING_NONBLOCK));
+    av_assert0(av_ring_write(ring, &i, AV_RING_NONBLOCK) == AVERROR(EAGAIN));
+
+    for (i = 0; i < 8; i++) {
+        av_assert0(!av_ring_read(ring, &val, AV_RING_NONBLOCK));
+        av_assert0(val == i);
+    }
+    av_assert0(av_ring_read(ring, &val, AV_RING_NONBLOCK) == AVERROR(EAGAIN));
+
+    av_ring_set_err_write(ring, AVERROR_EXIT);
+    av_assert0(av_ring_write(ring, &i, 0) == AVERROR_EXIT);
+    av_ring_free(&ring);
+
+    test_threads(1);
+    test_threads(NB_PRODUCERS);
+
+    return 0;
+}
+#endif
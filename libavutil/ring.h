@@ -0,0 +1,110 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * a lock-free ring buffer for passing fixed size elements between threads
+ */
+
+#ifndef AVUTIL_RING_H
+#define AVUTIL_RING_H
+
+/**
+ * @defgroup lavu_ring Ring buffer
+ * @ingroup lavu_data
+ *
+ * @{
+ * A bounded queue of fixed size elements, for handing data from one or several
+ * producer threads to a single consumer thread.
+ *
+ * Writing and reading elements does not take any lock as long as the ring is
+ * neither full nor empty. The blocking variants of the operations only fall
+ * back to waiting on a condition variable when they have to wait for the
+ * other side.
+ *
+ * Only one thread may read from a ring at any time. Only one thread may write
+ * to it as well, unless it was allocated with AV_RING_MULTI_PRODUCER.
+ */
+
+/**
+ * The ring may be written to by several threads simultaneously.
+ */
+#define AV_RING_MULTI_PRODUCER (1 << 0)
+
+/**
+ * Return AVERROR(EAGAIN) instead of waiting when the ring is full (for
+ * writing) or empty (for reading).
+ */
+#define AV_RING_NONBLOCK (1 << 0)
+
+typedef struct AVRing AVRing;
+
+/**
+ * Allocate a ring buffer.
+ *
+ * @param nb_elems minimum number of elements the ring can hold, it is
+ *                 rounded up to a power of two
+ * @param elem_size size of each element in bytes
+ * @param flags a combination of AV_RING_MULTI_PRODUCER
+ * @return the newly allocated ring or NULL on failure
+ */
+AVRing *av_ring_alloc(unsigned nb_elems, unsigned elem_size, int flags);
+
+/**
+ * Free a ring buffer and set the pointer to it to NULL. The elements still
+ * present in the ring are discarded, no thread may be using the ring.
+ */
+void av_ring_free(AVRing **ring);
+
+/**
+ * Copy an element into the ring.
+ *
+ * @param flags a combination of AV_RING_NONBLOCK
+ * @return 0 on success, AVERROR(EAGAIN) if the ring is full and
+ *         AV_RING_NONBLOCK was given, or the error code set with
+ *         av_ring_set_err_write()
+ */
+int av_ring_write(AVRing *ring, const void *elem, int flags);
+
+/**
+ * Copy the oldest element of the ring to elem and remove it from the ring.
+ *
+ * @param flags a combination of AV_RING_NONBLOCK
+ * @return 0 on success, AVERROR(EAGAIN) if the ring is empty and
+ *         AV_RING_NONBLOCK was given, or the error code set with
+ *         av_ring_set_err_read() once the ring is empty
+ */
+int av_ring_read(AVRing *ring, void *elem, int flags);
+
+/**
+ * Make all the current and future av_ring_write() calls fail with err, e.g.
+ * to stop the producers when the consumer is going away.
+ */
+void av_ring_set_err_write(AVRing *ring, int err);
+
+/**
+ * Make av_ring_read() fail with err once the ring is empty, e.g. to signal
+ * the consumer that the producer reached the end of its stream.
+ */
+void av_ring_set_err_read(AVRing *ring, int err);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_RING_H */
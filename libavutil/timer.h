@@ -31,6 +31,7 @@
 #include <inttypes.h>
 
 #include "config.h"
+#include "time.h"
 
 #if   ARCH_ARM
 #   include "arm/timer.h"
@@ -75,4 +76,45 @@
 #define STOP_TIMER(id) { }
 #endif
 
+/**
+ * Register a probe, the probes registered under the same name share their
+ * statistics.
+ *
+ * @return the identifier of the probe, negative if it cannot be registered
+ */
+int avpriv_probe_register(const char *name);
+
+/**
+ * Add a measured duration to the statistics of a probe, for the calling
+ * thread.
+ */
+void avpriv_probe_record(int id, uint64_t duration);
+
+#ifdef AV_READ_TIME
+#define PROBE_TIME() AV_READ_TIME()
+#else
+#define PROBE_TIME() av_gettime()
+#endif
+
+/*
+ * PROBE_START(var) must be the last declaration of its block, the time spent
+ * until PROBE_STOP(var, name) is then recorded in the probe called name.
+ */
+#if CONFIG_PROBES
+#define PROBE_START(var) uint64_t probe_start_##var = PROBE_TIME()
+
+#define PROBE_STOP(var, name)                                             \
+    do {                                                                  \
+        static int probe_id_##var;                                        \
+        uint64_t probe_end_##var = PROBE_TIME();                          \
+        if (!probe_id_##var)                                              \
+            probe_id_##var = avpriv_probe_register(name);                 \
+        avpriv_probe_record(probe_id_##var,                               \
+                            probe_end_##var - probe_start_##var);         \
+    } while (0)
+#else
+#define PROBE_START(var)
+#define PROBE_STOP(var, name) do { } while (0)
+#endif
+
 #endif /* AVUTIL_TIMER_H */
@@ -25,7 +25,10 @@
 
 #include "libavutil/x86/asm.h"
 #include "libavutil/x86/cpu.h"
+#include "libavutil/avstring.h"
+#include "libavutil/common.h"
 #include "libavutil/cpu.h"
+#include "libavutil/error.h"
 
 #if HAVE_YASM
 
@@ -44,7 +47,7 @@
         "cpuid                       \n\t"                      \
         "xchg   %%"REG_b", %%"REG_S                             \
         : "=a" (eax), "=S" (ebx), "=c" (ecx), "=d" (edx)        \
-        : "0" (index))
+        : "0" (index), "2" (0))
 
 #define xgetbv(index, eax, edx)                                 \
     __asm__ (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c" (index))
@@ -133,10 +136,23 @@ int ff_get_cpu_flags_x86(void)
             if ((eax & 0x6) == 0x6)
                 rval |= AV_CPU_FLAG_AVX;
         }
+#if HAVE_FMA3
+        /* FMA3 uses the AVX instruction coding scheme as well */
+        if ((rval & AV_CPU_FLAG_AVX) && (ecx & 0x00001000))
+            rval |= AV_CPU_FLAG_FMA3;
+#endif /* HAVE_FMA3 */
 #endif /* HAVE_AVX */
 #endif /* HAVE_SSE */
     }
 
+#if HAVE_AVX2
+    if (max_std_level >= 7) {
+        cpuid(7, eax, ebx, ecx, edx);
+        if ((rval & AV_CPU_FLAG_AVX) && (ebx & 0x00000020))
+            rval |= AV_CPU_FLAG_AVX2;
+    }
+#endif /* HAVE_AVX2 */
+
     cpuid(0x80000000, max_ext_level, ebx, ecx, edx);
 
     if (max_ext_level >= 0x80000001) {
@@ -199,3 +215,29 @@ int ff_get_cpu_flags_x86(void)
 
     return rval;
 }
+
+int ff_get_cpu_model_x86(char *buf, int size)
+{
+#ifdef cpuid
+    union { int i[12]; char c[48]; } brand;
+    int max_ext_level, ebx, ecx, edx, i;
+
+    if (!cpuid_test())
+        return AVERROR(ENOSYS);
+
+    cpuid(0x80000000, max_ext_level, ebx, ecx, edx);
+    if ((unsigned)max_ext_level < 0x80000004)
+        return AVERROR(ENOSYS);
+
+    for (i = 0; i < 3; i++)
+        cpuid(0x80000002 + i, brand.i[4 * i],     brand.i[4 * i + 1],
+                              brand.i[4 * i + 2], brand.i[4 * i + 3]);
+
+    /* the brand string is padded with spaces on some processors */
+    i = strspn(brand.c, " ");
+    av_strlcpy(buf, brand.c + i, FFMIN(size, 49 - i));
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif /* cpuid */
+}
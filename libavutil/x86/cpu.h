@@ -39,6 +39,8 @@
 #define EXTERNAL_SSE4(flags)        CPUEXT(flags, _EXTERNAL, SSE4)
 #define EXTERNAL_SSE42(flags)       CPUEXT(flags, _EXTERNAL, SSE42)
 #define EXTERNAL_AVX(flags)         CPUEXT(flags, _EXTERNAL, AVX)
+#define EXTERNAL_AVX2(flags)        CPUEXT(flags, _EXTERNAL, AVX2)
+#define EXTERNAL_FMA3(flags)        CPUEXT(flags, _EXTERNAL, FMA3)
 #define EXTERNAL_FMA4(flags)        CPUEXT(flags, _EXTERNAL, FMA4)
 
 #define INLINE_AMD3DNOW(flags)      CPUEXT(flags, _INLINE, AMD3DNOW)
@@ -52,10 +54,19 @@
 #define INLINE_SSE4(flags)          CPUEXT(flags, _INLINE, SSE4)
 #define INLINE_SSE42(flags)         CPUEXT(flags, _INLINE, SSE42)
 #define INLINE_AVX(flags)           CPUEXT(flags, _INLINE, AVX)
+#define INLINE_AVX2(flags)          CPUEXT(flags, _INLINE, AVX2)
+#define INLINE_FMA3(flags)          CPUEXT(flags, _INLINE, FMA3)
 #define INLINE_FMA4(flags)          CPUEXT(flags, _INLINE, FMA4)
 
 void ff_cpu_cpuid(int index, int *eax, int *ebx, int *ecx, int *edx);
 void ff_cpu_xgetbv(int op, int *eax, int *edx);
 int  ff_cpu_cpuid_test(void);
 
+/**
+ * Get the brand string of the processor.
+ *
+ * @return 0 on success, a negative AVERROR code if it is not available
+ */
+int ff_get_cpu_model_x86(char *buf, int size);
+
 #endif /* AVUTIL_X86_CPU_H */
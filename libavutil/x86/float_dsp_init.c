@@ -18,8 +18,13 @@
 
 #include "config.h"
 
+#include "libavutil/attributes.h"
+#include "libavutil/autotune_internal.h"
+#include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/float_dsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
 #include "cpu.h"
 #include "asm.h"
 
@@ -119,7 +124,175 @@ static void vector_fmul_window_sse(float *dst, const float *src0,
 }
 #endif /* HAVE_6REGS && HAVE_INLINE_ASM */
 
-void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
+#if HAVE_SSE_INLINE
+static void vector_clipf_sse(float *dst, const float *src,
+                             float min, float max, int len)
+{
+    x86_reg i = (len - 16) * 4;
+    __asm__ volatile (
+        "movss          %3, %%xmm4      \n"
+        "movss          %4, %%xmm5      \n"
+        "shufps $0, %%xmm4, %%xmm4      \n"
+        "shufps $0, %%xmm5, %%xmm5      \n"
+        "1:                             \n"
+        "movaps   (%2, %0), %%xmm0      \n" // 3/1 on intel
+        "movaps 16(%2, %0), %%xmm1      \n"
+        "movaps 32(%2, %0), %%xmm2      \n"
+        "movaps 48(%2, %0), %%xmm3      \n"
+        "maxps      %%xmm4, %%xmm0      \n"
+        "maxps      %%xmm4, %%xmm1      \n"
+        "maxps      %%xmm4, %%xmm2      \n"
+        "maxps      %%xmm4, %%xmm3      \n"
+        "minps      %%xmm5, %%xmm0      \n"
+        "minps      %%xmm5, %%xmm1      \n"
+        "minps      %%xmm5, %%xmm2      \n"
+        "minps      %%xmm5, %%xmm3      \n"
+        "movaps     %%xmm0,   (%1, %0)  \n"
+        "movaps     %%xmm1, 16(%1, %0)  \n"
+        "movaps     %%xmm2, 32(%1, %0)  \n"
+        "movaps     %%xmm3, 48(%1, %0)  \n"
+        "sub           $64, %0          \n"
+        "jge            1b              \n"
+        : "+&r"(i)
+        : "r"(dst), "r"(src), "m"(min), "m"(max)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5",)
+          "memory"
+    );
+}
+#endif /* HAVE_SSE_INLINE */
+
+#if HAVE_FMA3_INLINE
+static void vector_fmac_scalar_fma3(float *dst, const float *src, float mul,
+                                    int len)
+{
+    x86_reg i = -len * 4;
+    __asm__ volatile (
+        "vbroadcastss          %3, %%ymm2           \n"
+        "1:                                         \n"
+        "vmovaps         (%1, %0), %%ymm0           \n"
+        "vmovaps       32(%1, %0), %%ymm1           \n"
+        "vfmadd231ps     (%2, %0), %%ymm2, %%ymm0   \n" // dst += src * mul
+        "vfmadd231ps   32(%2, %0), %%ymm2, %%ymm1   \n"
+        "vmovaps           %%ymm0,   (%1, %0)       \n"
+        "vmovaps           %%ymm1, 32(%1, %0)       \n"
+        "add                  $64, %0               \n"
+        "jl                    1b                   \n"
+        "vzeroupper                                 \n"
+        : "+r"(i)
+        : "r"(dst + len), "r"(src + len), "m"(mul)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2",) "memory"
+    );
+}
+
+static void vector_fmul_add_fma3(float *dst, const float *src0,
+                                 const float *src1, const float *src2, int len)
+{
+    x86_reg i = -len * 4;
+    __asm__ volatile (
+        "1:                                         \n"
+        "vmovaps         (%2, %0), %%ymm0           \n"
+        "vmovaps       32(%2, %0), %%ymm1           \n"
+        "vmovaps         (%3, %0), %%ymm2           \n"
+        "vmovaps       32(%3, %0), %%ymm3           \n"
+        "vfmadd213ps     (%4, %0), %%ymm2, %%ymm0   \n" // src0 * src1 + src2
+        "vfmadd213ps   32(%4, %0), %%ymm3, %%ymm1   \n"
+        "vmovaps           %%ymm0,   (%1, %0)       \n"
+        "vmovaps           %%ymm1, 32(%1, %0)       \n"
+        "add                  $64, %0               \n"
+        "jl                    1b                   \n"
+        "vzeroupper                                 \n"
+        : "+r"(i)
+        : "r"(dst + len), "r"(src0 + len), "r"(src1 + len), "r"(src2 + len)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",) "memory"
+    );
+}
+
+static float scalarproduct_float_fma3(const float *v1, const float *v2,
+                                      int len)
+{
+    int n = len & ~15;
+    x86_reg i = -n * 4;
+    float p = 0.0f;
+
+    if (n) {
+        /* two independent accumulators hide the latency of the fma */
+        __asm__ volatile (
+            "vxorps        %%ymm0, %%ymm0, %%ymm0       \n"
+            "vxorps        %%ymm1, %%ymm1, %%ymm1       \n"
+            "1:                                         \n"
+            "vmovups       (%2, %0), %%ymm2             \n"
+            "vmovups     32(%2, %0), %%ymm3             \n"
+            "vfmadd231ps   (%3, %0), %%ymm2, %%ymm0     \n"
+            "vfmadd231ps 32(%3, %0), %%ymm3, %%ymm1     \n"
+            "add                $64, %0                 \n"
+            "jl                  1b                     \n"
+            "vaddps        %%ymm1, %%ymm0, %%ymm0       \n"
+            "vextractf128  $1, %%ymm0, %%xmm1           \n"
+            "vaddps        %%xmm1, %%xmm0, %%xmm0       \n"
+            "vmovhlps      %%xmm0, %%xmm0, %%xmm1       \n"
+            "vaddps        %%xmm1, %%xmm0, %%xmm0       \n"
+            "vmovshdup     %%xmm0, %%xmm1               \n"
+            "vaddss        %%xmm1, %%xmm0, %%xmm0       \n"
+            "vmovss        %%xmm0, %1                   \n"
+            "vzeroupper                                 \n"
+            : "+r"(i), "=m"(p)
+            : "r"(v1 + n), "r"(v2 + n)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",) "memory"
+        );
+    }
+    for (; n < len; n++)
+        p += v1[n] * v2[n];
+
+    return p;
+}
+#endif /* HAVE_FMA3_INLINE */
+
+#define SCALARPRODUCT_LEN 1024
+
+typedef struct ScalarproductBench {
+    float (*funcs[3])(const float *v1, const float *v2, int len);
+    float (*v)[SCALARPRODUCT_LEN];
+} ScalarproductBench;
+
+static void run_scalarproduct(void *opaque, int impl)
+{
+    ScalarproductBench *b = opaque;
+    b->funcs[impl](b->v[0], b->v[1], SCALARPRODUCT_LEN);
+}
+
+static av_cold void tune_scalarproduct(AVFloatDSPContext *fdsp, int mm_flags,
+                                       int strict)
+{
+    LOCAL_ALIGNED_32(float, v, [2], [SCALARPRODUCT_LEN]);
+    const char *names[3] = { "c" };
+    ScalarproductBench b = { { avpriv_scalarproduct_float_c }, v };
+    int i, nb_impls = 1, def = 0;
+
+    for (i = 0; i < SCALARPRODUCT_LEN; i++) {
+        v[0][i] = i & 15;
+        v[1][i] = 1.0f / (i + 1);
+    }
+
+    if (EXTERNAL_SSE(mm_flags)) {
+        names[nb_impls]     = "sse";
+        b.funcs[nb_impls++] = ff_scalarproduct_float_sse;
+    }
+#if HAVE_FMA3_INLINE
+    if (INLINE_FMA3(mm_flags) && !strict) {
+        names[nb_impls]     = "fma3";
+        b.funcs[nb_impls++] = scalarproduct_float_fma3;
+    }
+#endif
+    for (i = 0; i < nb_impls; i++)
+        if (b.funcs[i] == fdsp->scalarproduct_float)
+            def = i;
+
+    i = avpriv_autotune("float_dsp.scalarproduct_float", names, nb_impls, def,
+                        strict, run_scalarproduct, &b);
+    fdsp->scalarproduct_float = b.funcs[i];
+}
+
+void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp, int strict)
 {
     int mm_flags = av_get_cpu_flags();
 
@@ -149,4 +322,18 @@ void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
         fdsp->vector_fmul_add    = ff_vector_fmul_add_avx;
         fdsp->vector_fmul_reverse = ff_vector_fmul_reverse_avx;
     }
+#if HAVE_SSE_INLINE
+    if (INLINE_SSE(mm_flags)) {
+        fdsp->vector_clipf = vector_clipf_sse;
+    }
+#endif
+#if HAVE_FMA3_INLINE
+    /* the fused operations are not rounded like separate ones */
+    if (INLINE_FMA3(mm_flags) && !strict) {
+        fdsp->vector_fmac_scalar  = vector_fmac_scalar_fma3;
+        fdsp->vector_fmul_add     = vector_fmul_add_fma3;
+        fdsp->scalarproduct_float = scalarproduct_float_fma3;
+    }
+#endif
+    tune_scalarproduct(fdsp, mm_flags, strict);
 }
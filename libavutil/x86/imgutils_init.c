@@ -0,0 +1,77 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils_internal.h"
+#include "cpu.h"
+#include "asm.h"
+
+#if HAVE_SSE2_INLINE
+/* copy the lines with non-temporal stores, 64 bytes at a time once the
+ * destination is aligned, the remaining bytes with memcpy() */
+static void copy_plane_stream_sse2(uint8_t       *dst, int dst_linesize,
+                                   const uint8_t *src, int src_linesize,
+                                   int bytewidth, int height)
+{
+    for (; height > 0; height--) {
+        int head = FFMIN(-(intptr_t)dst & 15, bytewidth);
+        int size = (bytewidth - head) & ~63;
+        x86_reg i = -size;
+
+        memcpy(dst, src, head);
+        if (size) {
+            __asm__ volatile (
+                "1:                              \n\t"
+                "movdqu     (%1, %0), %%xmm0     \n\t"
+                "movdqu   16(%1, %0), %%xmm1     \n\t"
+                "movdqu   32(%1, %0), %%xmm2     \n\t"
+                "movdqu   48(%1, %0), %%xmm3     \n\t"
+                "movntdq  %%xmm0,   (%2, %0)     \n\t"
+                "movntdq  %%xmm1, 16(%2, %0)     \n\t"
+                "movntdq  %%xmm2, 32(%2, %0)     \n\t"
+                "movntdq  %%xmm3, 48(%2, %0)     \n\t"
+                "add      $64, %0                \n\t"
+                "jl       1b                     \n\t"
+                : "+r"(i)
+                : "r"(src + head + size), "r"(dst + head + size)
+                : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",) "memory"
+            );
+        }
+        memcpy(dst + head + size, src + head + size, bytewidth - head - size);
+
+        dst += dst_linesize;
+        src += src_linesize;
+    }
+    /* order the non-temporal stores before any later access to dst */
+    __asm__ volatile ("sfence" ::: "memory");
+}
+#endif /* HAVE_SSE2_INLINE */
+
+ImageCopyPlaneFunc ff_image_copy_plane_stream_x86(int cpu_flags)
+{
+#if HAVE_SSE2_INLINE
+    if (INLINE_SSE2(cpu_flags))
+        return copy_plane_stream_sse2;
+#endif
+    return NULL;
+}
@@ -1223,7 +1223,6 @@ yuv2rgb_full_X_c_template(SwsContext *c, const int16_t *lumFilter,
             dest[1] = B >> 22;
             dest[2] = G >> 22;
             dest[3] = R >> 22;
-            dest += 4;
             break;
         case AV_PIX_FMT_BGR24:
             dest[0] = B >> 22;
@@ -341,12 +341,13 @@ typedef struct SwsContext {
     int vChrFilterSize;           ///< Vertical   filter size for chroma     pixels.
     //@}
 
-    int lumMmxextFilterCodeSize;  ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code size for luma/alpha planes.
-    int chrMmxextFilterCodeSize;  ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code size for chroma planes.
-    uint8_t *lumMmxextFilterCode; ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code for luma/alpha planes.
-    uint8_t *chrMmxextFilterCode; ///< Runtime-generated MMXEXT horizontal fast bilinear scaler code for chroma planes.
+    int lumFastBilinearCodeSize;  ///< Runtime-generated horizontal fast bilinear scaler code size for luma/alpha planes.
+    int chrFastBilinearCodeSize;  ///< Runtime-generated horizontal fast bilinear scaler code size for chroma planes.
+    uint8_t *lumFastBilinearCode; ///< Runtime-generated MMXEXT or SSE2 horizontal fast bilinear scaler code for luma/alpha planes.
+    uint8_t *chrFastBilinearCode; ///< Runtime-generated MMXEXT or SSE2 horizontal fast bilinear scaler code for chroma planes.
 
-    int canMMXEXTBeUsed;
+    int canMMXEXTBeUsed;          ///< The runtime-generated fast bilinear scaler can be used for this context.
+    int canSSE2BeUsed;            ///< The runtime-generated fast bilinear scaler emits SSE2 instead of MMXEXT code.
 
     int dstY;                     ///< Last destination vertical line output from last slice.
     int flags;                    ///< Flags passed by the user to select scaler algorithm, optimizations, subsampling, etc...
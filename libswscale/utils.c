@@ -69,6 +69,8 @@ const char *swscale_license(void)
 
 #define RET 0xC3 // near return opcode for x86
 
+#define USE_MMAP (HAVE_MMAP && HAVE_MPROTECT && defined MAP_ANONYMOUS)
+
 typedef struct FormatEntry {
     int is_supported_in, is_supported_out;
 } FormatEntry;
@@ -765,6 +767,257 @@ static int init_hscaler_mmxext(int dstW, int xInc, uint8_t *filterCode,
 }
 #endif /* HAVE_MMXEXT_INLINE */
 
+#if HAVE_SSE2_INLINE && ARCH_X86_64
+/**
+ * Compute the coefficients, the source position and the pshuflw/pshufhw
+ * immediate for the group of four output pixels starting at i.
+ * The group always reads five source pixels, the right neighbours come
+ * from a copy of the source shifted by one byte.
+ */
+static int hscaler_group_sse2(int i, int xpos, int xInc, int dstW,
+                              int16_t *filter, int32_t *filterPos)
+{
+    int xx       = xpos >> 16;
+    int b        = ((xpos + xInc)     >> 16) - xx;
+    int c        = ((xpos + xInc * 2) >> 16) - xx;
+    int d        = ((xpos + xInc * 3) >> 16) - xx;
+    int maxShift = 3 - d;
+    int shift    = 0;
+    int imm8     = b << 2 | c << 4 | d << 6;
+
+    filter[i]        = ((xpos              & 0xFFFF) ^ 0xFFFF) >> 9;
+    filter[i + 1]    = (((xpos + xInc)     & 0xFFFF) ^ 0xFFFF) >> 9;
+    filter[i + 2]    = (((xpos + xInc * 2) & 0xFFFF) ^ 0xFFFF) >> 9;
+    filter[i + 3]    = (((xpos + xInc * 3) & 0xFFFF) ^ 0xFFFF) >> 9;
+    filterPos[i / 2] = xx;
+
+    if (i + 4 >= dstW)
+        shift = maxShift;               // avoid overread
+    else if ((xx & 3) <= maxShift)
+        shift = xx & 3;                 // align
+
+    if (shift && i >= shift) {
+        imm8             += 0x55 * shift;
+        filterPos[i / 2] -= shift;
+    }
+
+    return imm8;
+}
+
+static int init_hscaler_sse2(int dstW, int xInc, uint8_t *filterCode,
+                             int16_t *filter, int32_t *filterPos,
+                             int numSplits)
+{
+    uint8_t *fragmentA;
+    x86_reg imm8OfPShufLW1A;
+    x86_reg imm8OfPShufHW1A;
+    x86_reg imm8OfPShufLW2A;
+    x86_reg imm8OfPShufHW2A;
+    x86_reg fragmentLengthA;
+    uint8_t *fragmentB;
+    x86_reg imm8OfPShufLW1B;
+    x86_reg imm8OfPShufLW2B;
+    x86_reg fragmentLengthB;
+    int fragmentPos;
+    int width = dstW / numSplits;
+
+    int xpos, i;
+
+    /* This scaler is made of runtime-generated SSE2 code. Every chunk of
+     * fragmentA computes eight output pixels from two groups of five input
+     * pixels, the low and high halves of the registers being shuffled
+     * independently with pshuflw and pshufhw. A trailing group of four
+     * output pixels uses a chunk of fragmentB, which only works on the low
+     * half.
+     */
+
+    // code fragment
+
+    __asm__ volatile (
+        "jmp                         9f                 \n\t"
+        // Begin
+        "0:                                             \n\t"
+        "movdqa  (%%"REG_d", %%"REG_a"), %%xmm3         \n\t"
+        "movd    (%%"REG_c", %%"REG_S"), %%xmm0         \n\t"
+        "movd   1(%%"REG_c", %%"REG_S"), %%xmm1         \n\t"
+        "movl   8(%%"REG_b", %%"REG_a"), %%esi          \n\t"
+        "movd    (%%"REG_c", %%"REG_S"), %%xmm4         \n\t"
+        "movd   1(%%"REG_c", %%"REG_S"), %%xmm5         \n\t"
+        "punpckldq               %%xmm4, %%xmm0         \n\t"
+        "punpckldq               %%xmm5, %%xmm1         \n\t"
+        "punpcklbw               %%xmm7, %%xmm0         \n\t"
+        "punpcklbw               %%xmm7, %%xmm1         \n\t"
+        "pshuflw          $0xFF, %%xmm1, %%xmm1         \n\t"
+        "1:                                             \n\t"
+        "pshufhw          $0xFF, %%xmm1, %%xmm1         \n\t"
+        "2:                                             \n\t"
+        "pshuflw          $0xFF, %%xmm0, %%xmm0         \n\t"
+        "3:                                             \n\t"
+        "pshufhw          $0xFF, %%xmm0, %%xmm0         \n\t"
+        "4:                                             \n\t"
+        "psubw                   %%xmm1, %%xmm0         \n\t"
+        "movl  16(%%"REG_b", %%"REG_a"), %%esi          \n\t"
+        "pmullw                  %%xmm3, %%xmm0         \n\t"
+        "psllw                      $7, %%xmm1          \n\t"
+        "paddw                   %%xmm1, %%xmm0         \n\t"
+
+        "movdqu                  %%xmm0, (%%"REG_D", %%"REG_a") \n\t"
+
+        "add                        $16, %%"REG_a"      \n\t"
+        // End
+        "9:                                             \n\t"
+        "lea       " LOCAL_MANGLE(0b) ", %0             \n\t"
+        "lea       " LOCAL_MANGLE(1b) ", %1             \n\t"
+        "lea       " LOCAL_MANGLE(2b) ", %2             \n\t"
+        "lea       " LOCAL_MANGLE(3b) ", %3             \n\t"
+        "lea       " LOCAL_MANGLE(4b) ", %4             \n\t"
+        "dec                         %1                 \n\t"
+        "dec                         %2                 \n\t"
+        "dec                         %3                 \n\t"
+        "dec                         %4                 \n\t"
+        "sub                         %0, %1             \n\t"
+        "sub                         %0, %2             \n\t"
+        "sub                         %0, %3             \n\t"
+        "sub                         %0, %4             \n\t"
+        "lea       " LOCAL_MANGLE(9b) ", %5             \n\t"
+        "sub                         %0, %5             \n\t"
+
+
+        : "=r" (fragmentA), "=r" (imm8OfPShufLW1A), "=r" (imm8OfPShufHW1A),
+          "=r" (imm8OfPShufLW2A), "=r" (imm8OfPShufHW2A),
+          "=r" (fragmentLengthA)
+        );
+
+    __asm__ volatile (
+        "jmp                         9f                 \n\t"
+        // Begin
+        "0:                                             \n\t"
+        "movq    (%%"REG_d", %%"REG_a"), %%xmm3         \n\t"
+        "movd    (%%"REG_c", %%"REG_S"), %%xmm0         \n\t"
+        "movd   1(%%"REG_c", %%"REG_S"), %%xmm1         \n\t"
+        "punpcklbw               %%xmm7, %%xmm0         \n\t"
+        "punpcklbw               %%xmm7, %%xmm1         \n\t"
+        "pshuflw          $0xFF, %%xmm1, %%xmm1         \n\t"
+        "1:                                             \n\t"
+        "pshuflw          $0xFF, %%xmm0, %%xmm0         \n\t"
+        "2:                                             \n\t"
+        "psubw                   %%xmm1, %%xmm0         \n\t"
+        "movl   8(%%"REG_b", %%"REG_a"), %%esi          \n\t"
+        "pmullw                  %%xmm3, %%xmm0         \n\t"
+        "psllw                      $7, %%xmm1          \n\t"
+        "paddw                   %%xmm1, %%xmm0         \n\t"
+
+        "movq                    %%xmm0, (%%"REG_D", %%"REG_a") \n\t"
+
+        "add                         $8, %%"REG_a"      \n\t"
+        // End
+        "9:                                             \n\t"
+        "lea       " LOCAL_MANGLE(0b) ", %0             \n\t"
+        "lea       " LOCAL_MANGLE(1b) ", %1             \n\t"
+        "lea       " LOCAL_MANGLE(2b) ", %2             \n\t"
+        "dec                         %1                 \n\t"
+        "dec                         %2                 \n\t"
+        "sub                         %0, %1             \n\t"
+        "sub                         %0, %2             \n\t"
+        "lea       " LOCAL_MANGLE(9b) ", %3             \n\t"
+        "sub                         %0, %3             \n\t"
+
+
+        : "=r" (fragmentB), "=r" (imm8OfPShufLW1B), "=r" (imm8OfPShufLW2B),
+          "=r" (fragmentLengthB)
+        );
+
+    xpos        = 0;
+    fragmentPos = 0;
+
+    for (i = 0; i < width; i += 8) {
+        if (i + 4 < width) {
+            if (filterCode) {
+                int lo = hscaler_group_sse2(i,     xpos,            xInc, dstW,
+                                            filter, filterPos);
+                int hi = hscaler_group_sse2(i + 4, xpos + xInc * 4, xInc, dstW,
+                                            filter, filterPos);
+
+                memcpy(filterCode + fragmentPos, fragmentA, fragmentLengthA);
+                filterCode[fragmentPos + imm8OfPShufLW1A] = lo;
+                filterCode[fragmentPos + imm8OfPShufHW1A] = hi;
+                filterCode[fragmentPos + imm8OfPShufLW2A] = lo;
+                filterCode[fragmentPos + imm8OfPShufHW2A] = hi;
+            }
+            fragmentPos += fragmentLengthA;
+        } else {
+            if (filterCode) {
+                int lo = hscaler_group_sse2(i, xpos, xInc, dstW,
+                                            filter, filterPos);
+
+                memcpy(filterCode + fragmentPos, fragmentB, fragmentLengthB);
+                filterCode[fragmentPos + imm8OfPShufLW1B] = lo;
+                filterCode[fragmentPos + imm8OfPShufLW2B] = lo;
+            }
+            fragmentPos += fragmentLengthB;
+        }
+
+        if (filterCode)
+            filterCode[fragmentPos] = RET;
+        xpos += xInc * 8;
+    }
+    if (filterCode)
+        filterPos[((width / 2) + 1) & (~1)] = (xInc * width) >> 16;  // needed to jump to the next part
+
+    return fragmentPos + 1;
+}
+#endif /* HAVE_SSE2_INLINE && ARCH_X86_64 */
+
+#if HAVE_MMXEXT_INLINE
+static uint8_t *alloc_hscaler_code(int size)
+{
+    uint8_t *code;
+#if USE_MMAP
+    code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+        code = NULL;
+#elif HAVE_VIRTUALALLOC
+    code = VirtualAlloc(NULL, size, MEM_COMMIT, PAGE_READWRITE);
+#else
+    code = av_malloc(size);
+#endif
+    return code;
+}
+
+/**
+ * Switch the generated code from writable to executable, so that no page
+ * is ever mapped writable and executable at the same time.
+ */
+static int protect_hscaler_code(uint8_t *code, int size)
+{
+#if USE_MMAP
+    if (mprotect(code, size, PROT_EXEC | PROT_READ) < 0)
+        return AVERROR(errno);
+#elif HAVE_VIRTUALALLOC
+    DWORD old_protect;
+    if (!VirtualProtect(code, size, PAGE_EXECUTE_READ, &old_protect))
+        return AVERROR(EACCES);
+    FlushInstructionCache(GetCurrentProcess(), code, size);
+#endif
+    return 0;
+}
+#endif /* HAVE_MMXEXT_INLINE */
+
+static void free_hscaler_code(uint8_t **code, int size)
+{
+    if (!*code)
+        return;
+#if USE_MMAP
+    munmap(*code, size);
+#elif HAVE_VIRTUALALLOC
+    VirtualFree(*code, 0, MEM_RELEASE);
+#else
+    av_free(*code);
+#endif
+    *code = NULL;
+}
+
 static void getSubSampleFactors(int *h, int *v, enum AVPixelFormat format)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
@@ -1030,6 +1283,8 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             c->canMMXEXTBeUsed = 0;
     } else
         c->canMMXEXTBeUsed = 0;
+    c->canSSE2BeUsed = HAVE_SSE2_INLINE && ARCH_X86_64 &&
+                       c->canMMXEXTBeUsed && INLINE_SSE2(cpu_flags);
 
     c->chrXInc = (((int64_t)c->chrSrcW << 16) + (c->chrDstW >> 1)) / c->chrDstW;
     c->chrYInc = (((int64_t)c->chrSrcH << 16) + (c->chrDstH >> 1)) / c->chrDstH;
@@ -1053,58 +1308,53 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         }
     }
 
-#define USE_MMAP (HAVE_MMAP && HAVE_MPROTECT && defined MAP_ANONYMOUS)
-
     /* precalculate horizontal scaler filter coefficients */
     {
 #if HAVE_MMXEXT_INLINE
 // can't downscale !!!
         if (c->canMMXEXTBeUsed && (flags & SWS_FAST_BILINEAR)) {
-            c->lumMmxextFilterCodeSize = init_hscaler_mmxext(dstW, c->lumXInc, NULL,
-                                                             NULL, NULL, 8);
-            c->chrMmxextFilterCodeSize = init_hscaler_mmxext(c->chrDstW, c->chrXInc,
-                                                             NULL, NULL, NULL, 4);
-
-#if USE_MMAP
-            c->lumMmxextFilterCode = mmap(NULL, c->lumMmxextFilterCodeSize,
-                                          PROT_READ | PROT_WRITE,
-                                          MAP_PRIVATE | MAP_ANONYMOUS,
-                                          -1, 0);
-            c->chrMmxextFilterCode = mmap(NULL, c->chrMmxextFilterCodeSize,
-                                          PROT_READ | PROT_WRITE,
-                                          MAP_PRIVATE | MAP_ANONYMOUS,
-                                          -1, 0);
-#elif HAVE_VIRTUALALLOC
-            c->lumMmxextFilterCode = VirtualAlloc(NULL,
-                                                  c->lumMmxextFilterCodeSize,
-                                                  MEM_COMMIT,
-                                                  PAGE_EXECUTE_READWRITE);
-            c->chrMmxextFilterCode = VirtualAlloc(NULL,
-                                                  c->chrMmxextFilterCodeSize,
-                                                  MEM_COMMIT,
-                                                  PAGE_EXECUTE_READWRITE);
-#else
-            c->lumMmxextFilterCode = av_malloc(c->lumMmxextFilterCodeSize);
-            c->chrMmxextFilterCode = av_malloc(c->chrMmxextFilterCodeSize);
+            int (*init_hscaler)(int dstW, int xInc, uint8_t *filterCode,
+                                int16_t *filter, int32_t *filterPos,
+                                int numSplits) = init_hscaler_mmxext;
+#if HAVE_SSE2_INLINE && ARCH_X86_64
+            if (c->canSSE2BeUsed)
+                init_hscaler = init_hscaler_sse2;
 #endif
-
-            if (!c->lumMmxextFilterCode || !c->chrMmxextFilterCode)
+            c->lumFastBilinearCodeSize = init_hscaler(dstW, c->lumXInc, NULL,
+                                                      NULL, NULL, 8);
+            c->chrFastBilinearCodeSize = init_hscaler(c->chrDstW, c->chrXInc,
+                                                      NULL, NULL, NULL, 4);
+
+            c->lumFastBilinearCode = alloc_hscaler_code(c->lumFastBilinearCodeSize);
+            c->chrFastBilinearCode = alloc_hscaler_code(c->chrFastBilinearCodeSize);
+            if (!c->lumFastBilinearCode || !c->chrFastBilinearCode)
                 return AVERROR(ENOMEM);
             FF_ALLOCZ_OR_GOTO(c, c->hLumFilter,    (dstW           / 8 + 8) * sizeof(int16_t), fail);
             FF_ALLOCZ_OR_GOTO(c, c->hChrFilter,    (c->chrDstW     / 4 + 8) * sizeof(int16_t), fail);
             FF_ALLOCZ_OR_GOTO(c, c->hLumFilterPos, (dstW       / 2 / 8 + 8) * sizeof(int32_t), fail);
             FF_ALLOCZ_OR_GOTO(c, c->hChrFilterPos, (c->chrDstW / 2 / 4 + 8) * sizeof(int32_t), fail);
 
-            init_hscaler_mmxext(dstW, c->lumXInc, c->lumMmxextFilterCode,
-                                c->hLumFilter, c->hLumFilterPos, 8);
-            init_hscaler_mmxext(c->chrDstW, c->chrXInc, c->chrMmxextFilterCode,
-                                c->hChrFilter, c->hChrFilterPos, 4);
-
-#if USE_MMAP
-            mprotect(c->lumMmxextFilterCode, c->lumMmxextFilterCodeSize, PROT_EXEC | PROT_READ);
-            mprotect(c->chrMmxextFilterCode, c->chrMmxextFilterCodeSize, PROT_EXEC | PROT_READ);
-#endif
-        } else
+            init_hscaler(dstW, c->lumXInc, c->lumFastBilinearCode,
+                         c->hLumFilter, c->hLumFilterPos, 8);
+            init_hscaler(c->chrDstW, c->chrXInc, c->chrFastBilinearCode,
+                         c->hChrFilter, c->hChrFilterPos, 4);
+
+            if (protect_hscaler_code(c->lumFastBilinearCode, c->lumFastBilinearCodeSize) < 0 ||
+                protect_hscaler_code(c->chrFastBilinearCode, c->chrFastBilinearCodeSize) < 0) {
+                av_log(c, AV_LOG_VERBOSE,
+                       "cannot map the runtime-generated scaler executable, "
+                       "using the generic fast bilinear scaler\n");
+                free_hscaler_code(&c->lumFastBilinearCode, c->lumFastBilinearCodeSize);
+                free_hscaler_code(&c->chrFastBilinearCode, c->chrFastBilinearCodeSize);
+                av_freep(&c->hLumFilter);
+                av_freep(&c->hChrFilter);
+                av_freep(&c->hLumFilterPos);
+                av_freep(&c->hChrFilterPos);
+                c->canMMXEXTBeUsed = 0;
+                c->canSSE2BeUsed   = 0;
+            }
+        }
+        if (!c->lumFastBilinearCode)
 #endif /* HAVE_MMXEXT_INLINE */
         {
             const int filterAlign =
@@ -1678,24 +1928,8 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->hLumFilterPos);
     av_freep(&c->hChrFilterPos);
 
-#if HAVE_MMX_INLINE
-#if USE_MMAP
-    if (c->lumMmxextFilterCode)
-        munmap(c->lumMmxextFilterCode, c->lumMmxextFilterCodeSize);
-    if (c->chrMmxextFilterCode)
-        munmap(c->chrMmxextFilterCode, c->chrMmxextFilterCodeSize);
-#elif HAVE_VIRTUALALLOC
-    if (c->lumMmxextFilterCode)
-        VirtualFree(c->lumMmxextFilterCode, 0, MEM_RELEASE);
-    if (c->chrMmxextFilterCode)
-        VirtualFree(c->chrMmxextFilterCode, 0, MEM_RELEASE);
-#else
-    av_free(c->lumMmxextFilterCode);
-    av_free(c->chrMmxextFilterCode);
-#endif
-    c->lumMmxextFilterCode = NULL;
-    c->chrMmxextFilterCode = NULL;
-#endif /* HAVE_MMX_INLINE */
+    free_hscaler_code(&c->lumFastBilinearCode, c->lumFastBilinearCodeSize);
+    free_hscaler_code(&c->chrFastBilinearCode, c->chrFastBilinearCodeSize);
 
     av_freep(&c->yuvTable);
     av_free(c->formatConvBuffer);
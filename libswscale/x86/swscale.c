@@ -203,6 +203,104 @@ void updateMMXDitherTables(SwsContext *c, int dstY, int lumBufIndex, int chrBufI
     }
 }
 
+#if HAVE_SSE2_INLINE && ARCH_X86_64
+/* The generated code is entered with a call, which writes its return address
+ * below the stack pointer, so the red zone is skipped around the calls. */
+#define CALL_SSE2_FILTER_CODE \
+        "movl            (%%"REG_b"), %%esi     \n\t"\
+        "call                    *%6            \n\t"\
+        "movl (%%"REG_b", %%"REG_a"), %%esi     \n\t"\
+        "add               %%"REG_S", %%"REG_c" \n\t"\
+        "add               %%"REG_a", %%"REG_D" \n\t"\
+        "xor               %%"REG_a", %%"REG_a" \n\t"\
+
+static void hyscale_fast_sse2(SwsContext *c, int16_t *dst,
+                              int dstWidth, const uint8_t *src,
+                              int srcW, int xInc)
+{
+    int32_t *filterPos = c->hLumFilterPos;
+    int16_t *filter    = c->hLumFilter;
+    void    *fastBilinearCode = c->lumFastBilinearCode;
+    const uint8_t *srcp = src;
+    int16_t       *dstp = dst;
+    x86_reg i = 0, pos;
+
+    __asm__ volatile(
+        "sub                    $128, %%rsp     \n\t"
+        "pxor                 %%xmm7, %%xmm7    \n\t"
+        "prefetchnta     (%%"REG_c")            \n\t"
+        "prefetchnta   32(%%"REG_c")            \n\t"
+        "prefetchnta   64(%%"REG_c")            \n\t"
+
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+
+        "add                    $128, %%rsp     \n\t"
+        : "+a" (i), "=&S" (pos), "+c" (srcp), "+D" (dstp)
+        : "d" (filter), "b" (filterPos), "r" (fastBilinearCode)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm3", "%xmm4", "%xmm5", "%xmm7",)
+          "memory"
+    );
+
+    for (i = dstWidth - 1; (i * xInc) >> 16 >= srcW - 1; i--)
+        dst[i] = src[srcW - 1] * 128;
+}
+
+static void hcscale_fast_sse2(SwsContext *c, int16_t *dst1, int16_t *dst2,
+                              int dstWidth, const uint8_t *src1,
+                              const uint8_t *src2, int srcW, int xInc)
+{
+    int32_t *filterPos = c->hChrFilterPos;
+    int16_t *filter    = c->hChrFilter;
+    void    *fastBilinearCode = c->chrFastBilinearCode;
+    const uint8_t *srcp = src1;
+    int16_t       *dstp = dst1;
+    x86_reg i = 0, pos;
+
+    __asm__ volatile(
+        "sub                    $128, %%rsp     \n\t"
+        "pxor                 %%xmm7, %%xmm7    \n\t"
+        "prefetchnta     (%%"REG_c")            \n\t"
+        "prefetchnta   32(%%"REG_c")            \n\t"
+        "prefetchnta   64(%%"REG_c")            \n\t"
+
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        "xor               %%"REG_a", %%"REG_a" \n\t" // i
+        "mov                      %7, %%"REG_c" \n\t" // src
+        "mov                      %8, %%"REG_D" \n\t" // buf2
+        "prefetchnta     (%%"REG_c")            \n\t"
+        "prefetchnta   32(%%"REG_c")            \n\t"
+        "prefetchnta   64(%%"REG_c")            \n\t"
+
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+        CALL_SSE2_FILTER_CODE
+
+        "add                    $128, %%rsp     \n\t"
+        : "+a" (i), "=&S" (pos), "+c" (srcp), "+D" (dstp)
+        : "d" (filter), "b" (filterPos), "r" (fastBilinearCode),
+          "r" (src2), "r" (dst2)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm3", "%xmm4", "%xmm5", "%xmm7",)
+          "memory"
+    );
+
+    for (i = dstWidth - 1; (i * xInc) >> 16 >= srcW - 1; i--) {
+        dst1[i] = src1[srcW - 1] * 128;
+        dst2[i] = src2[srcW - 1] * 128;
+    }
+}
+#endif /* HAVE_SSE2_INLINE && ARCH_X86_64 */
+
 #endif /* HAVE_INLINE_ASM */
 
 #define SCALE_FUNC(filter_n, from_bpc, to_bpc, opt) \
@@ -313,6 +411,12 @@ av_cold void ff_sws_init_swScale_mmx(SwsContext *c)
     if (cpu_flags & AV_CPU_FLAG_MMXEXT)
         sws_init_swScale_MMXEXT(c);
 #endif
+#if HAVE_SSE2_INLINE && ARCH_X86_64
+    if (c->flags & SWS_FAST_BILINEAR && c->canSSE2BeUsed) {
+        c->hyscale_fast = hyscale_fast_sse2;
+        c->hcscale_fast = hcscale_fast_sse2;
+    }
+#endif
 #endif /* HAVE_INLINE_ASM */
 
 #define ASSIGN_SCALE_FUNC2(hscalefn, filtersize, opt1, opt2) do { \
@@ -2,6 +2,7 @@ FATE_LAVFI = fate-lavfi-crop                                            \
              fate-lavfi-crop_scale                                      \
              fate-lavfi-crop_scale_vflip                                \
              fate-lavfi-crop_vflip                                      \
+             fate-lavfi-format_scale                                    \
              fate-lavfi-null                                            \
              fate-lavfi-pixdesc                                         \
              fate-lavfi-pixfmts_copy                                    \
@@ -13,6 +13,11 @@ fate-atomic: libavutil/atomic-test$(EXESUF)
 fate-atomic: CMD = run libavutil/atomic-test
 fate-atomic: REF = /dev/null
 
+FATE_LIBAVUTIL += fate-autotune
+fate-autotune: libavutil/autotune-test$(EXESUF)
+fate-autotune: CMD = run libavutil/autotune-test
+fate-autotune: REF = /dev/null
+
 FATE_LIBAVUTIL += fate-avstring
 fate-avstring: libavutil/avstring-test$(EXESUF)
 fate-avstring: CMD = run libavutil/avstring-test
@@ -46,6 +51,11 @@ FATE_LIBAVUTIL += fate-hmac
 fate-hmac: libavutil/hmac-test$(EXESUF)
 fate-hmac: CMD = run libavutil/hmac-test
 
+FATE_LIBAVUTIL += fate-imgutils
+fate-imgutils: libavutil/imgutils-test$(EXESUF)
+fate-imgutils: CMD = run libavutil/imgutils-test
+fate-imgutils: REF = /dev/null
+
 FATE_LIBAVUTIL += fate-md5
 fate-md5: libavutil/md5-test$(EXESUF)
 fate-md5: CMD = run libavutil/md5-test
@@ -54,6 +64,11 @@ FATE_LIBAVUTIL += fate-parseutils
 fate-parseutils: libavutil/parseutils-test$(EXESUF)
 fate-parseutils: CMD = run libavutil/parseutils-test
 
+FATE_LIBAVUTIL += fate-ring
+fate-ring: libavutil/ring-test$(EXESUF)
+fate-ring: CMD = run libavutil/ring-test
+fate-ring: REF = /dev/null
+
 FATE_LIBAVUTIL += fate-sha
 fate-sha: libavutil/sha-test$(EXESUF)
 fate-sha: CMD = run libavutil/sha-test
@@ -0,0 +1,150 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Contention of AVBufferPool under many threads.
+ *
+ * Each thread repeatedly takes a few buffers from a pool shared by all the
+ * threads and releases them, as the decoding and filtering threads do with
+ * the frame and packet pools. The throughput is measured for each of the
+ * tested AV_BUFFER_POOL_FLAG_* combinations.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/time.h"
+
+#define BUFFER_SIZE     4096
+#define BUFFERS_PER_ITER   4
+
+static const struct {
+    const char *name;
+    int flags;
+} modes[] = {
+    { "shared",        0                                 },
+    { "thread_caches", AV_BUFFER_POOL_FLAG_THREAD_CACHES },
+};
+
+typedef struct ThreadArg {
+    AVBufferPool *pool;
+    int iterations;
+    int ret;
+} ThreadArg;
+
+static void *worker(void *opaque)
+{
+    ThreadArg *arg = opaque;
+    AVBufferRef *bufs[BUFFERS_PER_ITER];
+    int i, j;
+
+    for (i = 0; i < arg->iterations; i++) {
+        for (j = 0; j < BUFFERS_PER_ITER; j++) {
+            if (!(bufs[j] = av_buffer_pool_get(arg->pool))) {
+                arg->ret = -1;
+                while (j--)
+                    av_buffer_unref(&bufs[j]);
+                return NULL;
+            }
+            bufs[j]->data[0] = i;
+        }
+        for (j = 0; j < BUFFERS_PER_ITER; j++)
+            av_buffer_unref(&bufs[j]);
+    }
+    return NULL;
+}
+
+static int run(int flags, int nb_threads, int iterations, double *rate)
+{
+    AVBufferPool *pool;
+    pthread_t *threads;
+    ThreadArg *args;
+    int64_t start;
+    int i, nb_started, ret = 0;
+
+    pool    = av_buffer_pool_init2(BUFFER_SIZE, NULL, flags, 0);
+    threads = malloc(nb_threads * sizeof(*threads));
+    args    = malloc(nb_threads * sizeof(*args));
+    if (!pool || !threads || !args) {
+        ret = -1;
+        goto end;
+    }
+
+    start = av_gettime();
+    for (nb_started = 0; nb_started < nb_threads; nb_started++) {
+        args[nb_started].pool       = pool;
+        args[nb_started].iterations = iterations;
+        args[nb_started].ret        = 0;
+        if (pthread_create(&threads[nb_started], NULL, worker,
+                           &args[nb_started])) {
+            ret = -1;
+            break;
+        }
+    }
+    for (i = 0; i < nb_started; i++) {
+        pthread_join(threads[i], NULL);
+        if (args[i].ret < 0)
+            ret = -1;
+    }
+    *rate = (double)nb_threads * iterations * BUFFERS_PER_ITER /
+            FFMAX(av_gettime() - start, 1);
+
+end:
+    av_buffer_pool_uninit(&pool);
+    free(threads);
+    free(args);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int nb_threads = 16, iterations = 200000, i;
+
+    if (argc > 1 && !strcmp(argv[1], "-h")) {
+        fprintf(stderr, "usage: %s [threads [iterations]]\n", argv[0]);
+        return 0;
+    }
+    if (argc > 1)
+        nb_threads = atoi(argv[1]);
+    if (argc > 2)
+        iterations = atoi(argv[2]);
+    if (nb_threads < 1 || iterations < 1) {
+        fprintf(stderr, "Invalid thread or iteration count.\n");
+        return 1;
+    }
+
+    printf("%d threads on %d cpus, %d iterations of %d buffers\n",
+           nb_threads, av_cpu_count(), iterations, BUFFERS_PER_ITER);
+    for (i = 0; i < FF_ARRAY_ELEMS(modes); i++) {
+        double rate;
+
+        if (run(modes[i].flags, nb_threads, iterations, &rate) < 0) {
+            fprintf(stderr, "%s: failed\n", modes[i].name);
+            return 1;
+        }
+        printf("%-14s %8.2f Mbuffers/s\n", modes[i].name, rate);
+    }
+    return 0;
+}
+
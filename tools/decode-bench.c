@@ -0,0 +1,323 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Decoding throughput on large frames depending on how the frame buffers are
+ * allocated.
+ *
+ * A few frames of a synthetic picture are encoded in memory, then decoded
+ * repeatedly into frames taken from buffer pools created with each of the
+ * tested AV_BUFFER_POOL_FLAG_* combinations. With frame threading, the frames
+ * are allocated and released by the decoding threads, which is where the
+ * thread caches and AV_BUFFER_POOL_FLAG_LOCAL matter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+#include "libavcodec/avcodec.h"
+
+#define MAX_PACKETS 64
+#define MAX_THREADS 64
+
+typedef struct BenchContext {
+    AVBufferPool *pools[3];
+    int linesize[4];
+    int width, height;
+    int pool_flags;
+    int nb_threads;
+} BenchContext;
+
+static const struct {
+    const char *name;
+    int flags;
+} modes[] = {
+    { "default",       0                                 },
+    { "huge_pages",    AV_BUFFER_POOL_FLAG_HUGE_PAGES    },
+    { "thread_caches", AV_BUFFER_POOL_FLAG_THREAD_CACHES },
+    { "local",         AV_BUFFER_POOL_FLAG_THREAD_CACHES |
+                       AV_BUFFER_POOL_FLAG_LOCAL         },
+};
+
+/* the pools are created before decoding starts, as get_buffer() may be
+ * called from several decoding threads at once */
+static int init_pools(AVCodecContext *avctx, BenchContext *b)
+{
+    int w = b->width, h = b->height, i;
+    int align[AV_NUM_DATA_POINTERS];
+
+    avcodec_align_dimensions2(avctx, &w, &h, align);
+    if (av_image_fill_linesizes(b->linesize, AV_PIX_FMT_YUV420P, w) < 0)
+        return AVERROR(EINVAL);
+
+    for (i = 0; i < 3; i++) {
+        int plane_h = i ? h >> 1 : h;
+
+        b->linesize[i] = FFALIGN(b->linesize[i], 32);
+        b->pools[i]    = av_buffer_pool_init2(b->linesize[i] * plane_h + 16,
+                                              NULL, b->pool_flags, 0);
+        if (!b->pools[i])
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static int get_buffer(AVCodecContext *avctx, AVFrame *frame, int flags)
+{
+    BenchContext *b = avctx->opaque;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        if (!(frame->buf[i] = av_buffer_pool_get(b->pools[i])))
+            return AVERROR(ENOMEM);
+        frame->data[i]     = frame->buf[i]->data;
+        frame->linesize[i] = b->linesize[i];
+    }
+    return 0;
+}
+
+/* a moving pattern with enough detail to keep the decoder busy */
+static void fill_frame(AVFrame *frame, int n)
+{
+    int x, y, p;
+
+    for (p = 0; p < 3; p++) {
+        int w = p ? frame->width  >> 1 : frame->width;
+        int h = p ? frame->height >> 1 : frame->height;
+
+        for (y = 0; y < h; y++) {
+            uint8_t *line = frame->data[p] + y * frame->linesize[p];
+            for (x = 0; x < w; x++)
+                line[x] = p ? 128 + ((x + n) >> 3) % 32 :
+                              ((x + 2 * n) ^ (y + n)) + (x * y >> 7);
+        }
+    }
+}
+
+static int encode_packets(AVCodec *codec, int w, int h, int nb_frames,
+                          AVPacket *pkts)
+{
+    AVCodecContext *enc = avcodec_alloc_context3(codec);
+    AVFrame *frame = av_frame_alloc();
+    int nb_pkts = 0, got_packet, i, ret = AVERROR(ENOMEM);
+
+    if (!enc || !frame)
+        goto end;
+
+    enc->width     = w;
+    enc->height    = h;
+    enc->pix_fmt   = AV_PIX_FMT_YUV420P;
+    enc->time_base = (AVRational){ 1, 25 };
+    enc->gop_size  = 12;
+    enc->bit_rate  = w * h * 4;
+    if ((ret = avcodec_open2(enc, codec, NULL)) < 0)
+        goto end;
+
+    frame->width  = w;
+    frame->height = h;
+    frame->format = AV_PIX_FMT_YUV420P;
+    if ((ret = av_frame_get_buffer(frame, 32)) < 0)
+        goto end;
+
+    for (i = 0; i <= nb_frames && nb_pkts < MAX_PACKETS; i++) {
+        AVPacket *pkt = &pkts[nb_pkts];
+
+        av_init_packet(pkt);
+        pkt->data = NULL;
+        pkt->size = 0;
+        if (i < nb_frames) {
+            fill_frame(frame, i);
+            frame->pts = i;
+        }
+        ret = avcodec_encode_video2(enc, pkt, i < nb_frames ? frame : NULL,
+                                    &got_packet);
+        if (ret < 0)
+            goto end;
+        if (got_packet)
+            nb_pkts++;
+        else if (i == nb_frames)
+            break;
+    }
+    ret = nb_pkts;
+
+end:
+    av_frame_free(&frame);
+    if (enc)
+        avcodec_close(enc);
+    av_free(enc);
+    return ret;
+}
+
+static int decode_packets(AVCodec *codec, BenchContext *b,
+                          AVPacket *pkts, int nb_pkts, int *nb_frames)
+{
+    AVCodecContext *dec = avcodec_alloc_context3(codec);
+    AVFrame *frame = av_frame_alloc();
+    int i, got_frame, ret = AVERROR(ENOMEM);
+
+    if (!dec || !frame)
+        goto end;
+
+    dec->opaque                = b;
+    dec->get_buffer2           = get_buffer;
+    dec->refcounted_frames     = 1;
+    dec->flags                |= CODEC_FLAG_EMU_EDGE;
+    dec->thread_count          = b->nb_threads;
+    dec->thread_type           = FF_THREAD_FRAME;
+    dec->thread_safe_callbacks = 1;
+    if ((ret = avcodec_open2(dec, codec, NULL)) < 0)
+        goto end;
+    if (!b->pools[0] && (ret = init_pools(dec, b)) < 0)
+        goto end;
+
+    for (i = 0; i <= nb_pkts; i++) {
+        AVPacket pkt;
+
+        if (i < nb_pkts) {
+            pkt = pkts[i];
+        } else {
+            av_init_packet(&pkt);
+            pkt.data = NULL;
+            pkt.size = 0;
+        }
+        do {
+            if ((ret = avcodec_decode_video2(dec, frame, &got_frame, &pkt)) < 0)
+                goto end;
+            if (got_frame) {
+                (*nb_frames)++;
+                av_frame_unref(frame);
+            }
+        } while (i == nb_pkts && got_frame);
+    }
+    ret = 0;
+
+end:
+    av_frame_free(&frame);
+    if (dec)
+        avcodec_close(dec);
+    av_free(dec);
+    return ret;
+}
+
+static void usage(void)
+{
+    printf("Benchmark decoding large frames with various frame allocations\n"
+           "Usage: decode-bench [OPTIONS]\n"
+           "\n"
+           "Options:\n"
+           "-s WxH                   frame size (default 3840x2160)\n"
+           "-c CODEC                 codec (default mpeg4)\n"
+           "-n FRAMES                number of encoded frames (default 8)\n"
+           "-j THREADS               number of frame decoding threads (default 1)\n"
+           "-t MS                    minimum run time per mode in milliseconds (default 2000)\n"
+           "-h                       print this help\n");
+}
+
+int main(int argc, char **argv)
+{
+    AVPacket pkts[MAX_PACKETS];
+    const char *codec_name = "mpeg4";
+    AVCodec *encoder, *decoder;
+    int w = 3840, h = 2160, nb_frames = 8, nb_threads = 1, min_time = 2000000;
+    int nb_pkts, i, m, ret = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h")) {
+            usage();
+            return 0;
+        }
+        if (i + 1 == argc) {
+            fprintf(stderr, "missing argument for option %s\n", argv[i]);
+            return 1;
+        }
+        if (!strcmp(argv[i], "-s")) {
+            if (sscanf(argv[++i], "%dx%d", &w, &h) != 2) {
+                fprintf(stderr, "invalid size %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-c")) {
+            codec_name = argv[++i];
+        } else if (!strcmp(argv[i], "-n")) {
+            nb_frames = av_clip(atoi(argv[++i]), 1, MAX_PACKETS - 1);
+        } else if (!strcmp(argv[i], "-j")) {
+            nb_threads = av_clip(atoi(argv[++i]), 1, MAX_THREADS);
+        } else if (!strcmp(argv[i], "-t")) {
+            min_time = atoi(argv[++i]) * 1000;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            usage();
+            return 1;
+        }
+    }
+
+    avcodec_register_all();
+
+    encoder = avcodec_find_encoder_by_name(codec_name);
+    decoder = avcodec_find_decoder_by_name(codec_name);
+    if (!encoder || !decoder) {
+        fprintf(stderr, "codec %s not available\n", codec_name);
+        return 1;
+    }
+
+    if ((nb_pkts = encode_packets(encoder, w, h, nb_frames, pkts)) < 0) {
+        fprintf(stderr, "encoding failed\n");
+        return 1;
+    }
+
+    printf("mode,size,threads,frames,fps\n");
+    for (m = 0; m < FF_ARRAY_ELEMS(modes); m++) {
+        BenchContext b = { { NULL } };
+        int64_t start, elapsed;
+        int decoded = 0;
+
+        b.width      = w;
+        b.height     = h;
+        b.pool_flags = modes[m].flags;
+        b.nb_threads = nb_threads;
+        start = av_gettime();
+        do {
+            if (decode_packets(decoder, &b, pkts, nb_pkts, &decoded) < 0) {
+                fprintf(stderr, "decoding failed\n");
+                ret = 1;
+                break;
+            }
+            elapsed = av_gettime() - start;
+        } while (elapsed < min_time);
+
+        for (i = 0; i < 3; i++)
+            av_buffer_pool_uninit(&b.pools[i]);
+        if (ret)
+            break;
+
+        printf("%s,%dx%d,%d,%d,%.2f\n", modes[m].name, w, h, nb_threads,
+               decoded, decoded * 1000000.0 / FFMAX(elapsed, 1));
+        fflush(stdout);
+    }
+
+    for (i = 0; i < nb_pkts; i++)
+        av_free_packet(&pkts[i]);
+    return ret;
+}
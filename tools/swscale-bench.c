@@ -0,0 +1,500 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * libswscale benchmark and accuracy suite.
+ *
+ * Sweeps input format x output format x size x flags x CPU flags and
+ * reports the throughput in megapixels per second together with the PSNR
+ * against a high-precision reference, one line per case in CSV or JSON.
+ *
+ * The reference is computed by converting the source picture to 16-bit
+ * 4:4:4 and scaling it with the C Lanczos scaler in accurate rounding
+ * mode; the output of the tested conversion is brought to the same
+ * format without scaling before comparing.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/log.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+#include "libswscale/swscale.h"
+
+#define REF_FORMAT AV_PIX_FMT_YUV444P16
+#define REF_FLAGS  (SWS_LANCZOS | SWS_ACCURATE_RND | SWS_BITEXACT | \
+                    SWS_FULL_CHR_H_INT | SWS_FULL_CHR_H_INP)
+#define MAX_ENTRIES 32
+
+typedef struct Picture {
+    uint8_t *data[4];
+    int linesize[4];
+    int w, h;
+    enum AVPixelFormat fmt;
+} Picture;
+
+typedef struct Size {
+    int w, h;
+} Size;
+
+typedef struct CPUConfig {
+    const char *name;
+    int mask;
+} CPUConfig;
+
+typedef struct Result {
+    double mpps;
+    double psnr[3];
+    int special;
+} Result;
+
+static const struct {
+    const char *name;
+    int flags;
+} scaler_names[] = {
+    { "fast_bilinear", SWS_FAST_BILINEAR },
+    { "bilinear",      SWS_BILINEAR      },
+    { "bicubic",       SWS_BICUBIC       },
+    { "experimental",  SWS_X             },
+    { "point",         SWS_POINT         },
+    { "area",          SWS_AREA          },
+    { "bicublin",      SWS_BICUBLIN      },
+    { "gauss",         SWS_GAUSS         },
+    { "sinc",          SWS_SINC          },
+    { "lanczos",       SWS_LANCZOS       },
+    { "spline",        SWS_SPLINE        },
+};
+
+static int special_converter;
+static int alloc_flags;
+
+static void log_callback(void *ptr, int level, const char *fmt, va_list vl)
+{
+    if (strstr(fmt, "special converter"))
+        special_converter = 1;
+    if (level <= AV_LOG_WARNING)
+        av_log_default_callback(ptr, level, fmt, vl);
+}
+
+static int alloc_picture(Picture *pic, int w, int h, enum AVPixelFormat fmt)
+{
+    int i, size;
+
+    memset(pic, 0, sizeof(*pic));
+    if (av_image_fill_linesizes(pic->linesize, fmt, w) < 0)
+        return AVERROR(EINVAL);
+    for (i = 0; i < 4; i++)
+        pic->linesize[i] = FFALIGN(pic->linesize[i], 32);
+    size = av_image_fill_pointers(pic->data, fmt, h, NULL, pic->linesize);
+    if (size < 0)
+        return size;
+    /* Some scalers write slightly out of bounds. */
+    pic->data[0] = av_malloc_flags(size + 64, alloc_flags);
+    if (!pic->data[0])
+        return AVERROR(ENOMEM);
+    memset(pic->data[0], 0, size + 64);
+    av_image_fill_pointers(pic->data, fmt, h, pic->data[0], pic->linesize);
+    pic->w   = w;
+    pic->h   = h;
+    pic->fmt = fmt;
+    return 0;
+}
+
+static void free_picture(Picture *pic)
+{
+    av_freep(&pic->data[0]);
+}
+
+static int convert(const Picture *src, Picture *dst, int flags)
+{
+    struct SwsContext *sws = sws_getContext(src->w, src->h, src->fmt,
+                                            dst->w, dst->h, dst->fmt,
+                                            flags, NULL, NULL, NULL);
+    if (!sws)
+        return AVERROR(EINVAL);
+    sws_scale(sws, (const uint8_t * const *)src->data, src->linesize,
+              0, src->h, dst->data, dst->linesize);
+    sws_freeContext(sws);
+    return 0;
+}
+
+/* A smooth picture with some detail, so that scaler quality shows. */
+static void fill_master(Picture *pic)
+{
+    int x, y, p;
+
+    for (p = 0; p < 3; p++) {
+        for (y = 0; y < pic->h; y++) {
+            uint16_t *line = (uint16_t *)(pic->data[p] + y * pic->linesize[p]);
+            for (x = 0; x < pic->w; x++) {
+                double fx = (double)x / pic->w, fy = (double)y / pic->h;
+                double v  = 0.5 + 0.25 * sin(2 * M_PI * (fx * (3 + p) + fy * 2)) +
+                            0.15 * cos(2 * M_PI * 9 * fx * fy) +
+                            0.10 * sin(2 * M_PI * 40 * fx * fx);
+                if (p) // keep the colors mostly within the RGB gamut
+                    v = 0.5 + (v - 0.5) * 0.4;
+                line[x] = av_clip_uint16(lrint(v * 0xC000 + 0x1000));
+            }
+        }
+    }
+}
+
+static int has_chroma(enum AVPixelFormat fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+    return desc->nb_components >= 3 || (desc->flags & PIX_FMT_PAL);
+}
+
+static double plane_psnr(const Picture *a, const Picture *b, int p)
+{
+    uint64_t sse = 0;
+    int x, y;
+
+    for (y = 0; y < a->h; y++) {
+        const uint16_t *la = (const uint16_t *)(a->data[p] + y * a->linesize[p]);
+        const uint16_t *lb = (const uint16_t *)(b->data[p] + y * b->linesize[p]);
+        for (x = 0; x < a->w; x++) {
+            int64_t d = la[x] - lb[x];
+            sse += d * d;
+        }
+    }
+    if (!sse)
+        return 999.99;
+    return 10 * log10(65535.0 * 65535.0 * a->w * a->h / sse);
+}
+
+static int run_case(const Picture *src, const Picture *ref, Picture *dst,
+                    int flags, int min_time, Result *r)
+{
+    struct SwsContext *sws;
+    Picture out;
+    int64_t start, elapsed;
+    int iterations = 0, p, ret;
+
+    special_converter = 0;
+    sws = sws_getContext(src->w, src->h, src->fmt, dst->w, dst->h, dst->fmt,
+                         flags | SWS_PRINT_INFO, NULL, NULL, NULL);
+    if (!sws)
+        return AVERROR(EINVAL);
+    r->special = special_converter;
+
+    start = av_gettime();
+    do {
+        sws_scale(sws, (const uint8_t * const *)src->data, src->linesize,
+                  0, src->h, dst->data, dst->linesize);
+        iterations++;
+        elapsed = av_gettime() - start;
+    } while (elapsed < min_time);
+    sws_freeContext(sws);
+
+    r->mpps = (double)dst->w * dst->h * iterations / FFMAX(elapsed, 1);
+
+    if (!sws_isSupportedInput(dst->fmt)) {
+        r->psnr[0] = r->psnr[1] = r->psnr[2] = -1;
+        return 0;
+    }
+    if ((ret = alloc_picture(&out, dst->w, dst->h, REF_FORMAT)) < 0)
+        return ret;
+    if ((ret = convert(dst, &out, REF_FLAGS)) < 0) {
+        free_picture(&out);
+        return ret;
+    }
+    for (p = 0; p < 3; p++)
+        r->psnr[p] = p && !(has_chroma(src->fmt) && has_chroma(dst->fmt)) ?
+                     -1 : plane_psnr(&out, ref, p);
+    free_picture(&out);
+    return 0;
+}
+
+static void print_header(int json)
+{
+    if (json)
+        printf("[\n");
+    else
+        printf("src,dst,src_size,dst_size,flags,cpu,special,mpix_per_s,"
+               "speedup,psnr_y,psnr_u,psnr_v\n");
+}
+
+static void print_result(int json, const Picture *src, const Picture *dst,
+                         const char *flags, const char *cpu,
+                         const Result *r, double speedup)
+{
+    static int first = 1;
+    const char *src_name = av_get_pix_fmt_name(src->fmt);
+    const char *dst_name = av_get_pix_fmt_name(dst->fmt);
+
+    if (json) {
+        printf("%s  { \"src\": \"%s\", \"dst\": \"%s\", "
+               "\"src_size\": \"%dx%d\", \"dst_size\": \"%dx%d\", "
+               "\"flags\": \"%s\", \"cpu\": \"%s\", \"special\": %d, "
+               "\"mpix_per_s\": %.3f, \"speedup\": %.3f, "
+               "\"psnr_y\": %.2f, \"psnr_u\": %.2f, \"psnr_v\": %.2f }",
+               first ? "" : ",\n", src_name, dst_name,
+               src->w, src->h, dst->w, dst->h, flags, cpu, r->special,
+               r->mpps, speedup, r->psnr[0], r->psnr[1], r->psnr[2]);
+    } else {
+        printf("%s,%s,%dx%d,%dx%d,%s,%s,%d,%.3f,%.3f,%.2f,%.2f,%.2f\n",
+               src_name, dst_name, src->w, src->h, dst->w, dst->h,
+               flags, cpu, r->special, r->mpps, speedup,
+               r->psnr[0], r->psnr[1], r->psnr[2]);
+    }
+    first = 0;
+    fflush(stdout);
+}
+
+static int parse_list(char *str, char **entries)
+{
+    int n = 0;
+
+    while (str && n < MAX_ENTRIES) {
+        entries[n++] = str;
+        if ((str = strchr(str, ',')))
+            *str++ = 0;
+    }
+    return n;
+}
+
+static void usage(void)
+{
+    printf("Benchmark libswscale conversions and measure their accuracy\n"
+           "Usage: swscale-bench [OPTIONS]\n"
+           "\n"
+           "Options:\n"
+           "-src FMT[,FMT...]        source pixel formats, all if omitted\n"
+           "-dst FMT[,FMT...]        destination pixel formats, all if omitted\n"
+           "-s WxH                   source size (default 640x360)\n"
+           "-d WxH[,WxH...]          destination sizes (default 640x360,1280x720,320x180)\n"
+           "-flags NAME[,NAME...]    scalers (default fast_bilinear,bilinear,bicubic,point,area,lanczos)\n"
+           "-cpuflags SET[,SET...]   CPU flag sets, \"c\", \"native\" or a flags string\n"
+           "                         for av_parse_cpu_flags, '+' separated (default c,native)\n"
+           "-t MS                    minimum run time per case in milliseconds (default 20)\n"
+           "-json                    print JSON instead of CSV\n"
+           "-hugepages               allocate the pictures with huge pages\n"
+           "-h                       print this help\n");
+}
+
+int main(int argc, char **argv)
+{
+    enum AVPixelFormat src_fmts[AV_PIX_FMT_NB], dst_fmts[AV_PIX_FMT_NB];
+    int nb_src_fmts = 0, nb_dst_fmts = 0, all_src_fmts, all_dst_fmts;
+    Size src_size = { 640, 360 };
+    Size dst_sizes[MAX_ENTRIES] = { { 640, 360 }, { 1280, 720 }, { 320, 180 } };
+    int nb_dst_sizes = 3;
+    const char *flag_names[MAX_ENTRIES];
+    int flag_values[MAX_ENTRIES], nb_flags = 0;
+    CPUConfig cpus[MAX_ENTRIES] = { { "c", 0 }, { "native", ~0 } };
+    int nb_cpus = 2, c_index = 0;
+    int min_time = 20000, json = 0;
+    Picture master = { { 0 } }, src = { { 0 } }, src_ref = { { 0 } };
+    Picture ref = { { 0 } }, dst = { { 0 } };
+    int i, j, k, s, f, ret = 0;
+    char *entries[MAX_ENTRIES];
+    enum AVPixelFormat fmt;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(scaler_names); i++) {
+        int flags = scaler_names[i].flags;
+        if (flags == SWS_FAST_BILINEAR || flags == SWS_BILINEAR ||
+            flags == SWS_BICUBIC || flags == SWS_POINT ||
+            flags == SWS_AREA || flags == SWS_LANCZOS) {
+            flag_names[nb_flags]    = scaler_names[i].name;
+            flag_values[nb_flags++] = flags;
+        }
+    }
+
+    for (i = 1; i < argc; i++) {
+        int n;
+        if (!strcmp(argv[i], "-h")) {
+            usage();
+            return 0;
+        } else if (!strcmp(argv[i], "-json")) {
+            json = 1;
+            continue;
+        } else if (!strcmp(argv[i], "-hugepages")) {
+            alloc_flags = AV_MALLOC_HUGE_PAGES;
+            continue;
+        }
+        if (i + 1 == argc) {
+            fprintf(stderr, "missing argument for option %s\n", argv[i]);
+            return 1;
+        }
+        n = parse_list(argv[++i], entries);
+        if (!strcmp(argv[i - 1], "-src") || !strcmp(argv[i - 1], "-dst")) {
+            enum AVPixelFormat *fmts = argv[i - 1][1] == 's' ? src_fmts : dst_fmts;
+            int *nb_fmts = argv[i - 1][1] == 's' ? &nb_src_fmts : &nb_dst_fmts;
+            for (j = 0; j < n; j++) {
+                if ((fmt = av_get_pix_fmt(entries[j])) == AV_PIX_FMT_NONE) {
+                    fprintf(stderr, "invalid pixel format %s\n", entries[j]);
+                    return 1;
+                }
+                /* the lists cannot overflow without duplicates */
+                for (k = 0; k < *nb_fmts; k++)
+                    if (fmts[k] == fmt)
+                        break;
+                if (k == *nb_fmts)
+                    fmts[(*nb_fmts)++] = fmt;
+            }
+        } else if (!strcmp(argv[i - 1], "-s")) {
+            if (sscanf(entries[0], "%dx%d", &src_size.w, &src_size.h) != 2) {
+                fprintf(stderr, "invalid size %s\n", entries[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i - 1], "-d")) {
+            for (j = 0; j < n; j++) {
+                if (sscanf(entries[j], "%dx%d",
+                           &dst_sizes[j].w, &dst_sizes[j].h) != 2) {
+                    fprintf(stderr, "invalid size %s\n", entries[j]);
+                    return 1;
+                }
+            }
+            nb_dst_sizes = n;
+        } else if (!strcmp(argv[i - 1], "-flags")) {
+            for (j = 0; j < n; j++) {
+                for (k = 0; k < FF_ARRAY_ELEMS(scaler_names); k++)
+                    if (!strcmp(entries[j], scaler_names[k].name))
+                        break;
+                if (k == FF_ARRAY_ELEMS(scaler_names)) {
+                    fprintf(stderr, "unknown scaler %s\n", entries[j]);
+                    return 1;
+                }
+                flag_names[j]  = scaler_names[k].name;
+                flag_values[j] = scaler_names[k].flags;
+            }
+            nb_flags = n;
+        } else if (!strcmp(argv[i - 1], "-cpuflags")) {
+            c_index = -1;
+            for (j = 0; j < n; j++) {
+                cpus[j].name = entries[j];
+                if (!strcmp(entries[j], "c")) {
+                    cpus[j].mask = 0;
+                    c_index      = j;
+                } else if (!strcmp(entries[j], "native")) {
+                    cpus[j].mask = ~0;
+                } else if ((cpus[j].mask = av_parse_cpu_flags(entries[j])) < 0) {
+                    fprintf(stderr, "invalid cpu flags %s\n", entries[j]);
+                    return 1;
+                }
+            }
+            nb_cpus = n;
+        } else if (!strcmp(argv[i - 1], "-t")) {
+            min_time = atoi(entries[0]) * 1000;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i - 1]);
+            usage();
+            return 1;
+        }
+    }
+
+    all_src_fmts = !nb_src_fmts;
+    all_dst_fmts = !nb_dst_fmts;
+    for (fmt = 0; fmt < AV_PIX_FMT_NB; fmt++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+        if (!desc || (desc->flags & PIX_FMT_HWACCEL))
+            continue;
+        if (all_src_fmts && sws_isSupportedInput(fmt))
+            src_fmts[nb_src_fmts++] = fmt;
+        if (all_dst_fmts && sws_isSupportedOutput(fmt))
+            dst_fmts[nb_dst_fmts++] = fmt;
+    }
+
+    av_log_set_callback(log_callback);
+
+    if (alloc_picture(&master, src_size.w, src_size.h, REF_FORMAT) < 0)
+        return 1;
+    fill_master(&master);
+
+    print_header(json);
+
+    for (i = 0; i < nb_src_fmts; i++) {
+        /* The references are always computed with the C code. */
+        av_set_cpu_flags_mask(0);
+        if (alloc_picture(&src, src_size.w, src_size.h, src_fmts[i]) < 0 ||
+            alloc_picture(&src_ref, src_size.w, src_size.h, REF_FORMAT) < 0)
+            goto fail;
+        if (convert(&master, &src, REF_FLAGS) < 0 ||
+            convert(&src, &src_ref, REF_FLAGS) < 0) {
+            fprintf(stderr, "cannot convert to %s\n",
+                    av_get_pix_fmt_name(src_fmts[i]));
+            free_picture(&src);
+            free_picture(&src_ref);
+            continue;
+        }
+
+        for (s = 0; s < nb_dst_sizes; s++) {
+            av_set_cpu_flags_mask(0);
+            if (alloc_picture(&ref, dst_sizes[s].w, dst_sizes[s].h,
+                              REF_FORMAT) < 0 ||
+                convert(&src_ref, &ref, REF_FLAGS) < 0)
+                goto fail;
+
+            for (j = 0; j < nb_dst_fmts; j++) {
+                for (f = 0; f < nb_flags; f++) {
+                    Result results[MAX_ENTRIES];
+
+                    if (alloc_picture(&dst, dst_sizes[s].w, dst_sizes[s].h,
+                                      dst_fmts[j]) < 0)
+                        goto fail;
+                    for (k = 0; k < nb_cpus; k++) {
+                        av_set_cpu_flags_mask(cpus[k].mask);
+                        if (run_case(&src, &ref, &dst, flag_values[f],
+                                     min_time, &results[k]) < 0) {
+                            fprintf(stderr, "%s -> %s failed\n",
+                                    av_get_pix_fmt_name(src_fmts[i]),
+                                    av_get_pix_fmt_name(dst_fmts[j]));
+                            break;
+                        }
+                    }
+                    if (k == nb_cpus)
+                        for (k = 0; k < nb_cpus; k++)
+                            print_result(json, &src, &dst, flag_names[f],
+                                         cpus[k].name, &results[k],
+                                         c_index < 0 ? 1.0 : results[k].mpps /
+                                         results[c_index].mpps);
+                    free_picture(&dst);
+                }
+            }
+            free_picture(&ref);
+        }
+        free_picture(&src);
+        free_picture(&src_ref);
+    }
+
+    if (json)
+        printf("\n]\n");
+    goto end;
+
+fail:
+    ret = 1;
+end:
+    free_picture(&dst);
+    free_picture(&ref);
+    free_picture(&src_ref);
+    free_picture(&src);
+    free_picture(&master);
+    return ret;
+}